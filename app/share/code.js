@@ -7,6 +7,14 @@
   /* mode */
   window.App.mode = "none";
 
+  /* event source while waiting for a due card */
+  window.App.events = null;
+
+  /* review socket, the cards it sent ahead, and whether a card is awaited */
+  window.App.sock = null;
+  window.App.queue = [];
+  window.App.pending = false;
+
   /* retrieve the score name */
   window.App.score = function(num) {
     switch(num) {
@@ -20,105 +28,190 @@
     throw "Inavlid score";
   };
 
+  /* open the review socket, falling back to requests without it */
+  window.App.connect = function() {
+    var sock = new WebSocket((location.protocol == "https:" ? "wss://" : "ws://") + location.host + location.pathname + "/review");
+
+    sock.addEventListener("open", function() {
+      App.sock = sock;
+      App.next();
+    });
+
+    sock.addEventListener("message", function(e) {
+      var json = JSON.parse(e.data);
+      if(!Array.isArray(json)) {
+        window.alert(json.error);
+        App.queue = [];
+        if(App.pending) { App.next(); }
+        return;
+      }
+
+      App.queue = json;
+      if(App.pending) {
+        App.pending = false;
+        if(App.queue.length > 0) { App.show(App.queue.shift()); } else { App.wait(); }
+      }
+    });
+
+    sock.addEventListener("close", function() {
+      var opened = (App.sock == sock);
+      App.sock = null;
+      App.queue = [];
+      if(!opened || App.pending) {
+        App.pending = false;
+        App.next();
+      }
+    });
+  };
+
   /* retrieve the next card */
   window.App.next = function() {
+    if(App.sock != null) {
+      App.queue = [];
+      App.pending = true;
+      App.sock.send("next");
+      return;
+    }
+
     Req.get(location.pathname + "/rand", function(resp) {
       var json = JSON.parse(resp);
-      var card = Gui.div("card");
-      var list = [ "eng", "rom", "hir", "kanji", "audio" ];
-      var space, show, actions, audio = null;
-
-      var mk = function(el) {
-        var div;
-        if(el != "audio") {
-          div = Gui.div(el, Gui.text(json[el]));
+      if(json == null) { App.wait(); } else { App.show(json); }
+    });
+  };
+
+  /* grade a card, or skip it with "next", and move on to the next card */
+  window.App.review = function(verb, id) {
+    if(App.sock == null) {
+      if(verb == "next") { App.next(); return; }
+      Req.get(location.pathname + "/" + verb + "/" + id, function(resp) {
+        App.next();
+      });
+      return;
+    }
+
+    var card = App.queue.shift();
+    var msg = (verb == "next") ? "next" : (verb + " " + id);
+    if(card != null) {
+      msg += " " + card.id;
+      App.show(card);
+    }
+
+    App.pending = (card == null);
+    App.sock.send(msg);
+  };
+
+  /* show a card */
+  window.App.show = function(json) {
+    var card = Gui.div("card");
+    var list = [ "eng", "rom", "hir", "kanji", "audio" ];
+    var space, show, actions, audio = null;
+
+    var mk = function(el) {
+      var div;
+      if(el != "audio") {
+        div = Gui.div(el, Gui.text(json[el]));
+      } else {
+        if(json.audio != "_") {
+          audio = Gui.tag("audio");
+          audio.src = json.src;
+          var play = Gui.tag("button", "play", Gui.text("Play"));
+          play.addEventListener("click", function() { audio.play(); });
+          div = Gui.div("audio", [audio, play]);
         } else {
-          if(json.audio != "_") {
-            audio = Gui.tag("audio");
-            audio.src = "/mp3/" + json.audio;
-            var play = Gui.tag("button", "play", Gui.text("Play"));
-            play.addEventListener("click", function() { audio.play(); });
-            div = Gui.div("audio", [audio, play]);
-          } else {
-            div = Gui.div("audio", Gui.text("No audio"));
-          }
+          div = Gui.div("audio", Gui.text("No audio"));
         }
-        return div;
-      };
+      }
+      return div;
+    };
 
-      var query = mk(App.mode);
-      query.classList.add("prompt");
-      card.appendChild(query);
+    var query = mk(App.mode);
+    query.classList.add("prompt");
+    card.appendChild(query);
 
-      if(App.mode == "audio") { audio.play(); }
+    if(App.mode == "audio") { audio.play(); }
 
-      list.map(mk).forEach(function(el) {
-        el.classList.add("hidden");
-        card.appendChild(el);
-      });
+    list.map(mk).forEach(function(el) {
+      el.classList.add("hidden");
+      card.appendChild(el);
+    });
 
-      var notes = Gui.tag("input", "notes");
-      notes.type = "text";
-      notes.placeholder = "Notes";
-      notes.autofocus = true;
-      notes.addEventListener("keyup", function(e) {
-        if(e.keyCode == 13) { show.click(); }
-      });
-      card.appendChild(notes);
+    var notes = Gui.tag("input", "notes");
+    notes.type = "text";
+    notes.placeholder = "Notes";
+    notes.autofocus = true;
+    notes.addEventListener("keyup", function(e) {
+      if(e.keyCode == 13) { show.click(); }
+    });
+    card.appendChild(notes);
 
-      actions = Gui.div("actions");
-      card.appendChild(actions);
+    actions = Gui.div("actions");
+    card.appendChild(actions);
 
-      actions.appendChild(show = Gui.button("show", "Show", function() {
-        var list = card.getElementsByClassName("hidden");
-        for(var i = list.length - 1; i >= 0; i--) {
-          list.item(i).classList.remove("hidden");
-        }
+    actions.appendChild(show = Gui.button("show", "Show", function() {
+      var list = card.getElementsByClassName("hidden");
+      for(var i = list.length - 1; i >= 0; i--) {
+        list.item(i).classList.remove("hidden");
+      }
 
-        var req = function(verb) {
-          return function(e) {
-            Req.get(location.pathname + "/" + verb + "/" + json.id, function(resp) {
-              App.next();
-            });
-          };
+      var req = function(verb) {
+        return function(e) {
+          App.review(verb, json.id);
         };
+      };
 
-        actions.insertBefore(Gui.button("good", "Good", req("inc")), show);
-        actions.insertBefore(Gui.div("sep"), show);
-        actions.insertBefore(Gui.button("okay", "Okay", req("reset")), show);
-        actions.insertBefore(Gui.div("sep"), show);
-        actions.insertBefore(Gui.button("bad", "Bad", req("bad")), show);
-        actions.insertBefore(Gui.div("sep"), show);
-        actions.insertBefore(Gui.button("zero", "Zero", req("zero")), show);
-        space.appendChild(Gui.div("score " + App.score(json.score), Gui.text(App.score(json.score))));
-
-        if((App.mode != "audio") && (audio != null)) { audio.play(); }
-
-        var list = actions.getElementsByTagName("button");
-        for(var i = 0; i < list.length; i++) {
-          list.item(i).addEventListener("keyup", function(e) {
-            if(e.code == "KeyG") { req("inc")(); }
-            if(e.code == "KeyO") { req("reset")(); }
-            if(e.code == "KeyB") { req("dec")(); }
-            if(e.code == "KeyZ") { req("zero")(); }
-            if(e.code == "KeyS") { App.next(); }
-          });
-        }
-
-        actions.removeChild(show);
-        card.removeChild(query);
-        actions.firstChild.focus();
-      }));
+      actions.insertBefore(Gui.button("good", "Good", req("inc")), show);
+      actions.insertBefore(Gui.div("sep"), show);
+      actions.insertBefore(Gui.button("okay", "Okay", req("reset")), show);
+      actions.insertBefore(Gui.div("sep"), show);
+      actions.insertBefore(Gui.button("bad", "Bad", req("dec")), show);
+      actions.insertBefore(Gui.div("sep"), show);
+      actions.insertBefore(Gui.button("zero", "Zero", req("zero")), show);
+      space.appendChild(Gui.div("score " + App.score(json.score), Gui.text(App.score(json.score))));
+
+      if((App.mode != "audio") && (audio != null)) { audio.play(); }
+
+      var list = actions.getElementsByTagName("button");
+      for(var i = 0; i < list.length; i++) {
+        list.item(i).addEventListener("keyup", function(e) {
+          if(e.code == "KeyG") { req("inc")(); }
+          if(e.code == "KeyO") { req("reset")(); }
+          if(e.code == "KeyB") { req("dec")(); }
+          if(e.code == "KeyZ") { req("zero")(); }
+          if(e.code == "KeyS") { App.review("next", json.id); }
+        });
+      }
+
+      actions.removeChild(show);
+      card.removeChild(query);
+      actions.firstChild.focus();
+    }));
+
+    actions.appendChild(space = Gui.div("space"));
+
+    actions.appendChild(Gui.button("skip", "Skip", function() {
+      App.review("next", json.id);
+    }));
+
+    Gui.replace(Gui.byid("page"), card);
+    notes.focus();
+  };
 
-      actions.appendChild(space = Gui.div("space"));
+  /* wait for the server to report a due card */
+  window.App.wait = function() {
+    Gui.replace(Gui.byid("page"), Gui.div("card", Gui.text("Nothing due.")));
+    if(App.events != null) { return; }
 
-      actions.appendChild(Gui.button("skip", "Skip", function() {
+    var due = function(e) {
+      if(JSON.parse(e.data).due == 0) {
+        App.events.close();
+        App.events = null;
         App.next();
-      }));
+      }
+    };
 
-      Gui.replace(Gui.byid("page"), card);
-      notes.focus();
-    });
+    App.events = new EventSource(location.pathname + "/events");
+    App.events.addEventListener("update", due);
+    App.events.addEventListener("due", due);
   };
 
   window.addEventListener("load", function() {
@@ -130,7 +223,7 @@
     default: Gui.replace(Gui.byid("content"), Gui.text("Invalid page.")); return;
     }
 
-    App.next();
+    App.connect();
   });
 
 })();
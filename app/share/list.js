@@ -45,7 +45,7 @@
 
           if(json[i].audio != "_") {
             var audio = Gui.tag("audio");
-            audio.src = "/mp3/" + json[i].audio;
+            audio.src = json[i].src;
             var play = Gui.tag("button", "play", Gui.text("🔊"));
             play.addEventListener("click", function() { audio.play(); });
             card.appendChild(Gui.div("audio", [audio, play]));
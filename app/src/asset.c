@@ -0,0 +1,246 @@
+#include "common.h"
+#include <sys/stat.h>
+
+
+/*
+ * local definitions
+ */
+#define CHECK	1000000
+
+/*
+ * local declarations
+ */
+static char *asset_load(struct asset_data_t **data, const char *path, int64_t *mtime);
+static void asset_init(struct asset_data_t *data, const char *path, int64_t mtime);
+
+
+/**
+ * Open an asset, loading its contents from a path.
+ *   @asset: Ref. The asset.
+ *   @path: The path.
+ *   &returns: Error.
+ */
+char *asset_open(struct asset_t **asset, const char *path)
+{
+#define onexit
+	int64_t mtime;
+	struct asset_data_t *data;
+
+	chkfail(asset_load(&data, path, &mtime));
+
+	*asset = malloc(sizeof(struct asset_t));
+	(*asset)->path = strdup(path);
+	(*asset)->lock = sys_mutex_init(0);
+	(*asset)->pinning = 0;
+	(*asset)->mtime = mtime;
+	(*asset)->check = sys_utime();
+	(*asset)->data = data;
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Close an asset. Referenced contents remain valid until released.
+ *   @asset: The asset.
+ */
+void asset_close(struct asset_t *asset)
+{
+	asset_release(asset->data);
+	sys_mutex_destroy(&asset->lock);
+	free(asset->path);
+	free(asset);
+}
+
+
+/**
+ * Retrieve a reference to the current contents of an asset. The file is
+ * checked for changes at most once a second by a single caller, and
+ * reloaded if changed.
+ *   @asset: The asset.
+ *   &returns: The contents, released with 'asset_release'.
+ */
+struct asset_data_t *asset_get(struct asset_t *asset)
+{
+	int64_t now;
+	struct asset_data_t *data, *old;
+
+	now = sys_utime();
+	if(((now - __atomic_load_n(&asset->check, __ATOMIC_RELAXED)) >= CHECK) && sys_mutex_trylock(&asset->lock)) {
+		struct stat info;
+
+		if((now - asset->check) >= CHECK) {
+			__atomic_store_n(&asset->check, now, __ATOMIC_RELAXED);
+
+			if((stat(asset->path, &info) == 0) && (asset_mtime(&info) != asset->mtime)) {
+				int64_t mtime;
+
+				if(chkbool(asset_load(&data, asset->path, &mtime))) {
+					asset->mtime = mtime;
+
+					old = __atomic_exchange_n(&asset->data, data, __ATOMIC_SEQ_CST);
+					sys_thread_drain(&asset->pinning);
+
+					asset_release(old);
+				}
+			}
+		}
+
+		sys_mutex_unlock(&asset->lock);
+	}
+
+	__atomic_add_fetch(&asset->pinning, 1, __ATOMIC_SEQ_CST);
+	data = __atomic_load_n(&asset->data, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&data->refcnt, 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&asset->pinning, 1, __ATOMIC_SEQ_CST);
+
+	return data;
+}
+
+/**
+ * Create asset contents from memory, such as a rewritten asset.
+ *   @buf: The buffer.
+ *   @len: The length.
+ *   &returns: The contents, released with 'asset_release'.
+ */
+struct asset_data_t *asset_data_new(const void *buf, size_t len)
+{
+	struct asset_data_t *data;
+
+	data = malloc(sizeof(struct asset_data_t) + len);
+	data->refcnt = 1;
+	data->len = len;
+	memcpy(data->buf, buf, len);
+	asset_init(data, NULL, 0);
+
+	return data;
+}
+
+/**
+ * Release a reference to asset contents.
+ *   @ref: The contents.
+ */
+void asset_release(void *ref)
+{
+	struct asset_data_t *data = ref;
+
+	if(__atomic_sub_fetch(&data->refcnt, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+
+	if(data->zip != NULL)
+		free(data->zip);
+
+	free(data);
+}
+
+/**
+ * Retrieve the modification time from the status of a file.
+ *   @info: The file status.
+ *   &returns: The time in nanoseconds.
+ */
+int64_t asset_mtime(const struct stat *info)
+{
+	return 1000000000 * (int64_t)info->st_mtim.tv_sec + (int64_t)info->st_mtim.tv_nsec;
+}
+
+
+/**
+ * Load asset contents from a file, along with the gzip variant.
+ *   @data: Ref. The contents.
+ *   @path: The path.
+ *   @mtime: Ref. The file modification time.
+ *   &returns: Error.
+ */
+static char *asset_load(struct asset_data_t **data, const char *path, int64_t *mtime)
+{
+#define onexit fclose(file);
+	FILE *file;
+	struct stat info;
+
+	file = fopen(path, "r");
+	if(file == NULL) {
+		*data = NULL;
+		return mprintf("Cannot open '%s'. %s.", path, strerror(errno));
+	}
+
+	if(fstat(fileno(file), &info) < 0)
+		fail("Cannot stat '%s'. %s.", path, strerror(errno));
+
+	*data = malloc(sizeof(struct asset_data_t) + info.st_size);
+	(*data)->refcnt = 1;
+	(*data)->len = info.st_size;
+
+	if(fread((*data)->buf, 1, (*data)->len, file) != (*data)->len) {
+		free(*data);
+		fail("Failure to read from '%s'.", path);
+	}
+
+	*mtime = asset_mtime(&info);
+
+	fclose(file);
+	asset_init(*data, path, *mtime);
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Initialize the hash, entity tags, and gzip variant of asset contents. A
+ * '.gz' file next to the asset is used if at least as recent, and
+ * otherwise the contents are compressed at the best level. The variant is
+ * discarded if not smaller.
+ *   @data: The contents.
+ *   @path: Optional. The asset path.
+ *   @mtime: The asset modification time.
+ */
+static void asset_init(struct asset_data_t *data, const char *path, int64_t mtime)
+{
+	FILE *file = NULL;
+	struct stat info;
+
+	data->hash = hash_fnv64(HASH_FNV64, data->buf, data->len);
+	snprintf(data->etag, sizeof(data->etag), "\"%016llx\"", (unsigned long long)data->hash);
+	snprintf(data->ztag, sizeof(data->ztag), "\"%016llx-gz\"", (unsigned long long)data->hash);
+
+	data->zip = NULL;
+	data->nzip = 0;
+
+	if(path != NULL) {
+		char gz[strlen(path) + 4];
+
+		sprintf(gz, "%s.gz", path);
+		file = fopen(gz, "r");
+	}
+
+	if(file != NULL) {
+		if((fstat(fileno(file), &info) == 0) && (asset_mtime(&info) >= mtime) && (info.st_size > 0)) {
+			data->nzip = info.st_size;
+			data->zip = malloc(data->nzip);
+			if(fread(data->zip, 1, data->nzip, file) != data->nzip) {
+				free(data->zip);
+				data->zip = NULL;
+			}
+		}
+
+		fclose(file);
+	}
+
+	if(data->zip == NULL) {
+		struct gzip_t *gzip;
+		struct strbuf_t buf;
+
+		buf = strbuf_init(data->len / 2 + 64);
+		gzip = gzip_new(io_file_strbuf(&buf), GZIP_BEST);
+		io_file_write(gzip_file(gzip), data->buf, data->len);
+		gzip_finish(gzip);
+		gzip_delete(gzip);
+
+		data->nzip = buf.idx;
+		data->zip = (uint8_t *)buf.arr;
+	}
+
+	if(data->nzip >= data->len) {
+		free(data->zip);
+		data->zip = NULL;
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+/*
+ * asset definitions
+ */
+#define ASSET_CACHE	"public, max-age=31536000, immutable"
+
+/**
+ * Asset structure. An asset keeps the contents of a file resident,
+ * reloading them when the file changes. Readers take a reference without
+ * locking; a reload is published the same way as a deck version.
+ *   @path: The path.
+ *   @lock: The reload lock.
+ *   @pinning: The number of readers in the middle of pinning.
+ *   @mtime: The file modification time of the loaded contents.
+ *   @check: The time of the last change check.
+ *   @data: The current contents.
+ */
+struct asset_t {
+	char *path;
+	sys_mutex_t lock;
+
+	unsigned int pinning;
+	int64_t mtime, check;
+
+	struct asset_data_t *data;
+};
+
+/**
+ * Asset data structure. Contents are reference counted so that a queued
+ * response keeps its version alive across a reload. Each version also
+ * carries a gzip variant when one is smaller than the contents.
+ *   @refcnt: The reference count.
+ *   @len: The length.
+ *   @hash: The content hash.
+ *   @etag: The entity tag, the quoted content hash.
+ *   @nzip: The length of the gzip variant.
+ *   @zip: The gzip variant or null.
+ *   @ztag: The entity tag of the gzip variant.
+ *   @buf: The contents.
+ */
+struct asset_data_t {
+	unsigned int refcnt;
+
+	size_t len;
+	uint64_t hash;
+	char etag[20];
+
+	size_t nzip;
+	uint8_t *zip;
+	char ztag[24];
+
+	uint8_t buf[];
+};
+
+
+/*
+ * structure prototypes
+ */
+struct stat;
+
+/*
+ * asset declarations
+ */
+char *asset_open(struct asset_t **asset, const char *path);
+void asset_close(struct asset_t *asset);
+
+struct asset_data_t *asset_get(struct asset_t *asset);
+struct asset_data_t *asset_data_new(const void *buf, size_t len);
+void asset_release(void *ref);
+int64_t asset_mtime(const struct stat *info);
+
+#endif
@@ -5,6 +5,7 @@
  * common headers
  */
 #include <hax.h>
+#include <signal.h>
 #include "inc.h"
 
 #endif
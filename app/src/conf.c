@@ -0,0 +1,391 @@
+#include "common.h"
+
+
+/*
+ * local declarations
+ */
+static char *conf_line(struct conf_t *conf, char **tok, unsigned int n, const struct conf_handler_t *handler);
+static http_route_f conf_handler(const struct conf_handler_t *handler, const char *name);
+static struct asset_data_t *conf_view(struct conf_t *conf, const struct asset_data_t *data);
+
+
+/**
+ * Load the configuration from a file. Each line holds one directive:
+ *
+ *   deck NAME PATH          -- open the deck at PATH as NAME
+ *   media DIR               -- index the audio files in DIR by content
+ *   threads N               -- serve from N threads, 0 for one per processor
+ *   workers N               -- run blocking routes on N worker threads
+ *   file PATTERN PATH TYPE  -- serve a file for a route
+ *   page PATTERN PATH TYPE  -- serve a file for a route starting with a deck
+ *   route PATTERN HANDLER   -- dispatch a route to a named handler
+ *   route PATTERN HANDLER block
+ *                           -- dispatch a route that may block to a worker
+ *
+ * Blank lines and lines starting with '#' are ignored.
+ *   @conf: Ref. The configuration.
+ *   @path: The path.
+ *   @handler: The null-terminated list of named handlers.
+ *   &returns: Error.
+ */
+char *conf_load(struct conf_t **conf, const char *path, const struct conf_handler_t *handler)
+{
+#define onexit erase(err); if(file != NULL) fclose(file); conf_delete(*conf);
+	FILE *file = NULL;
+	char buf[1024], *tok[5], *str, *err = NULL;
+	unsigned int n, line = 0;
+
+	*conf = malloc(sizeof(struct conf_t));
+	(*conf)->deck = NULL;
+	(*conf)->file = NULL;
+	(*conf)->media = NULL;
+	(*conf)->router = http_router_new();
+	(*conf)->threads = 0;
+	(*conf)->workers = 4;
+
+	file = fopen(path, "r");
+	if(file == NULL)
+		fail("Cannot open configuration '%s'. %s.", path, strerror(errno));
+
+	while(fgets(buf, sizeof(buf), file) != NULL) {
+		line++;
+
+		if(strchr(buf, '\n') == NULL && !feof(file))
+			fail("%s:%u: Line too long.", path, line);
+
+		for(n = 0, str = buf; n < 5; n++) {
+			str += strspn(str, " \t\r\n");
+			if((*str == '\0') || (*str == '#'))
+				break;
+
+			tok[n] = str;
+			str += strcspn(str, " \t\r\n");
+			if(*str != '\0')
+				*str++ = '\0';
+		}
+
+		if(n == 0)
+			continue;
+
+		err = conf_line(*conf, tok, n, handler);
+		if(err != NULL)
+			fail("%s:%u: %s", path, line, err);
+	}
+
+	fclose(file);
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Delete a configuration, closing all decks.
+ *   @conf: The configuration.
+ */
+void conf_delete(struct conf_t *conf)
+{
+	struct conf_deck_t *deck;
+	struct conf_file_t *file;
+
+	while(conf->deck != NULL) {
+		deck = conf->deck;
+		conf->deck = deck->next;
+
+		deck_close(deck->deck);
+		free(deck->id);
+		free(deck);
+	}
+
+	while(conf->file != NULL) {
+		file = conf->file;
+		conf->file = file->next;
+
+		if(file->view != NULL)
+			asset_release(file->view);
+
+		sys_mutex_destroy(&file->lock);
+		asset_close(file->asset);
+		free(file->url);
+		free(file->type);
+		free(file);
+	}
+
+	if(conf->media != NULL)
+		media_close(conf->media);
+
+	http_router_delete(conf->router);
+	free(conf);
+}
+
+
+/**
+ * Retrieve a deck by the name in a route parameter.
+ *   @conf: The configuration.
+ *   @param: The parameter.
+ *   &returns: The deck or null.
+ */
+struct deck_t *conf_deck(struct conf_t *conf, const struct http_param_t *param)
+{
+	struct conf_deck_t *deck;
+
+	for(deck = conf->deck; deck != NULL; deck = deck->next) {
+		if((deck->len == param->len) && (memcmp(deck->id, param->str, param->len) == 0))
+			return deck->deck;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Retrieve a reference to the current contents of a file. A page is
+ * rewritten whenever it or any other file changes.
+ *   @conf: The configuration.
+ *   @file: The file.
+ *   &returns: The contents, released with 'asset_release'.
+ */
+struct asset_data_t *conf_asset(struct conf_t *conf, struct conf_file_t *file)
+{
+	uint64_t key;
+	struct conf_file_t *cur;
+	struct asset_data_t *data, *dep, *view;
+
+	data = asset_get(file->asset);
+	if(!file->page)
+		return data;
+
+	key = data->hash;
+	for(cur = conf->file; cur != NULL; cur = cur->next) {
+		if(cur->page)
+			continue;
+
+		dep = asset_get(cur->asset);
+		key = hash_fnv64(key, &dep->hash, sizeof(uint64_t));
+		asset_release(dep);
+	}
+
+	sys_mutex_lock(&file->lock);
+
+	if((file->view == NULL) || (file->key != key)) {
+		if(file->view != NULL)
+			asset_release(file->view);
+
+		file->view = conf_view(conf, data);
+		file->key = key;
+	}
+
+	view = file->view;
+	__atomic_add_fetch(&view->refcnt, 1, __ATOMIC_RELAXED);
+
+	sys_mutex_unlock(&file->lock);
+	asset_release(data);
+
+	return view;
+}
+
+/**
+ * Find the file whose current contents have a content hash. Pages are not
+ * content-addressed.
+ *   @conf: The configuration.
+ *   @hash: The content hash.
+ *   @data: Out. The contents, released with 'asset_release'.
+ *   &returns: The file, or null if no file currently has the hash.
+ */
+struct conf_file_t *conf_hashed(struct conf_t *conf, uint64_t hash, struct asset_data_t **data)
+{
+	struct conf_file_t *file;
+
+	for(file = conf->file; file != NULL; file = file->next) {
+		if(file->page)
+			continue;
+
+		*data = asset_get(file->asset);
+		if((*data)->hash == hash)
+			return file;
+
+		asset_release(*data);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Process a configuration line.
+ *   @conf: The configuration.
+ *   @tok: The tokens.
+ *   @n: The number of tokens.
+ *   @handler: The named handler list.
+ *   &returns: Error.
+ */
+static char *conf_line(struct conf_t *conf, char **tok, unsigned int n, const struct conf_handler_t *handler)
+{
+#define onexit
+	if(strcmp(tok[0], "deck") == 0) {
+		char *err;
+		struct conf_deck_t *deck, **ref;
+
+		if(n != 3)
+			fail("Expected 'deck NAME PATH'.");
+
+		for(ref = &conf->deck; *ref != NULL; ref = &(*ref)->next) {
+			if(strcmp((*ref)->id, tok[1]) == 0)
+				fail("Duplicate deck '%s'.", tok[1]);
+		}
+
+		deck = malloc(sizeof(struct conf_deck_t));
+		err = deck_open(&deck->deck, tok[2]);
+		if(err != NULL) {
+			free(deck);
+			return err;
+		}
+
+		deck->id = strdup(tok[1]);
+		deck->len = strlen(tok[1]);
+		deck->next = NULL;
+		*ref = deck;
+	}
+	else if((strcmp(tok[0], "file") == 0) || (strcmp(tok[0], "page") == 0)) {
+		char *err;
+		http_route_f func;
+		struct conf_file_t *file;
+
+		if(n != 4)
+			fail("Expected '%s PATTERN PATH TYPE'.", tok[0]);
+
+		func = conf_handler(handler, tok[0]);
+		if(func == NULL)
+			fail("Unknown handler '%s'.", tok[0]);
+
+		file = malloc(sizeof(struct conf_file_t));
+		err = asset_open(&file->asset, tok[2]);
+		if(err != NULL) {
+			free(file);
+			return err;
+		}
+
+		file->url = strdup(tok[1]);
+		file->type = strdup(tok[3]);
+		file->page = (strcmp(tok[0], "page") == 0);
+		file->lock = sys_mutex_init(0);
+		file->view = NULL;
+		file->key = 0;
+		file->conf = conf;
+		file->next = conf->file;
+		conf->file = file;
+
+		chkfail(http_router_add(conf->router, tok[1], func, file, 0));
+	}
+	else if(strcmp(tok[0], "media") == 0) {
+		if(n != 2)
+			fail("Expected 'media DIR'.");
+		else if(conf->media != NULL)
+			fail("Duplicate media directory.");
+
+		chkfail(media_open(&conf->media, tok[1]));
+	}
+	else if(strcmp(tok[0], "threads") == 0) {
+		char *end;
+		unsigned long val;
+
+		if(n != 2)
+			fail("Expected 'threads N'.");
+
+		val = strtoul(tok[1], &end, 10);
+		if((*end != '\0') || (end == tok[1]) || (val > 256))
+			fail("Invalid thread count '%s'.", tok[1]);
+
+		conf->threads = val;
+	}
+	else if(strcmp(tok[0], "workers") == 0) {
+		char *end;
+		unsigned long val;
+
+		if(n != 2)
+			fail("Expected 'workers N'.");
+
+		val = strtoul(tok[1], &end, 10);
+		if((*end != '\0') || (end == tok[1]) || (val > 256))
+			fail("Invalid worker count '%s'.", tok[1]);
+
+		conf->workers = val;
+	}
+	else if(strcmp(tok[0], "route") == 0) {
+		http_route_f func;
+		unsigned int flags = 0;
+
+		if((n == 4) && (strcmp(tok[3], "block") == 0))
+			flags |= HTTP_ROUTE_BLOCK;
+		else if(n != 3)
+			fail("Expected 'route PATTERN HANDLER [block]'.");
+
+		func = conf_handler(handler, tok[2]);
+		if(func == NULL)
+			fail("Unknown handler '%s'.", tok[2]);
+
+		chkfail(http_router_add(conf->router, tok[1], func, conf, flags));
+	}
+	else
+		fail("Unknown directive '%s'.", tok[0]);
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Find a named handler.
+ *   @handler: The named handler list.
+ *   @name: The name.
+ *   &returns: The handler or null.
+ */
+static http_route_f conf_handler(const struct conf_handler_t *handler, const char *name)
+{
+	for(; handler->name != NULL; handler++) {
+		if(strcmp(handler->name, name) == 0)
+			return handler->func;
+	}
+
+	return NULL;
+}
+
+/**
+ * Build the view of a page, replacing every quoted URL of another file with
+ * its content-addressed URL.
+ *   @conf: The configuration.
+ *   @data: The page contents.
+ *   &returns: The view contents.
+ */
+static struct asset_data_t *conf_view(struct conf_t *conf, const struct asset_data_t *data)
+{
+	size_t len;
+	struct strbuf_t buf;
+	struct conf_file_t *file;
+	struct asset_data_t *view, *dep;
+	const char *str = (const char *)data->buf, *end = str + data->len, *quote;
+
+	buf = strbuf_init(data->len + 256);
+
+	while((quote = memchr(str, '"', end - str)) != NULL) {
+		strbuf_addmem(&buf, str, quote + 1 - str);
+		str = quote + 1;
+
+		for(file = conf->file; file != NULL; file = file->next) {
+			len = strlen(file->url);
+			if(file->page || ((size_t)(end - str) <= len) || (memcmp(str, file->url, len) != 0) || (str[len] != '"'))
+				continue;
+
+			dep = asset_get(file->asset);
+			hprintf(io_file_strbuf(&buf), "/a/%016llx/%s", (unsigned long long)dep->hash, strrchr(file->url, '/') + 1);
+			asset_release(dep);
+
+			str += len;
+			break;
+		}
+	}
+
+	strbuf_addmem(&buf, str, end - str);
+	view = asset_data_new(buf.arr, buf.idx);
+	strbuf_destroy(&buf);
+
+	return view;
+}
@@ -0,0 +1,82 @@
+#ifndef CONF_H
+#define CONF_H
+
+/**
+ * Configuration structure.
+ *   @deck: The deck list.
+ *   @file: The file list.
+ *   @media: The media index, null if not configured.
+ *   @router: The compiled router.
+ *   @threads: The number of server threads, zero for one per processor.
+ *   @workers: The number of worker threads for blocking routes.
+ */
+struct conf_t {
+	struct conf_deck_t *deck;
+	struct conf_file_t *file;
+	struct media_t *media;
+	struct http_router_t *router;
+	unsigned int threads, workers;
+};
+
+/**
+ * Deck configuration structure.
+ *   @id: The identifier.
+ *   @len: The identifier length.
+ *   @deck: The resident deck.
+ *   @next: The next deck.
+ */
+struct conf_deck_t {
+	char *id;
+	size_t len;
+	struct deck_t *deck;
+
+	struct conf_deck_t *next;
+};
+
+/**
+ * File configuration structure. Pages are served with references to the
+ * other files rewritten into content-addressed URLs.
+ *   @asset: The resident file contents.
+ *   @url, type: The route pattern and content-type.
+ *   @page: The page flag.
+ *   @lock: The view lock.
+ *   @view: The rewritten page contents, null if not built.
+ *   @key: The combined hash of the page and files the view was built from.
+ *   @conf: The parent configuration.
+ *   @next: The next file.
+ */
+struct conf_file_t {
+	struct asset_t *asset;
+	char *url, *type;
+	bool page;
+
+	sys_mutex_t lock;
+	struct asset_data_t *view;
+	uint64_t key;
+
+	struct conf_t *conf;
+
+	struct conf_file_t *next;
+};
+
+/**
+ * Named handler structure.
+ *   @name: The name used by the configuration.
+ *   @func: The route handler.
+ */
+struct conf_handler_t {
+	const char *name;
+	http_route_f func;
+};
+
+/*
+ * configuration declarations
+ */
+char *conf_load(struct conf_t **conf, const char *path, const struct conf_handler_t *handler);
+void conf_delete(struct conf_t *conf);
+
+struct deck_t *conf_deck(struct conf_t *conf, const struct http_param_t *param);
+struct asset_data_t *conf_asset(struct conf_t *conf, struct conf_file_t *file);
+struct conf_file_t *conf_hashed(struct conf_t *conf, uint64_t hash, struct asset_data_t **data);
+
+#endif
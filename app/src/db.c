@@ -1,12 +1,20 @@
 #include "common.h"
+#include <fcntl.h>
 
 
+/*
+ * serializer definitions
+ */
+#define SAVE_SIZE	(64*1024)
+
 /**
  * File reader structure.
  *   @path: The path.
  *   @file: The file.
  *   @ch: The current character.
  *   @line, col: The line and column.
+ *   @buf: The string buffer.
+ *   @raw: The buffer recording each character consumed, or null.
  */
 struct read_t {
 	const char *path;
@@ -14,6 +22,22 @@ struct read_t {
 	int ch;
 
 	unsigned int line, col;
+	struct strbuf_t buf, *raw;
+};
+
+/**
+ * Serializer structure.
+ *   @fd: The file descriptor.
+ *   @path: The path.
+ *   @idx: The buffer index.
+ *   @buf: The buffer.
+ */
+struct save_t {
+	int fd;
+	const char *path;
+
+	size_t idx;
+	char buf[SAVE_SIZE];
 };
 
 
@@ -21,14 +45,43 @@ struct read_t {
  * local declarations
  */
 static struct read_t *read_open(const char *path);
+static struct read_t *read_mem(const char *path, const char *str);
+static struct read_t *read_new(const char *path, FILE *file);
 static void read_close(struct read_t *read);
 
 static int read_next(struct read_t *read);
 static uint64_t read_num(struct read_t *read);
+static uint64_t read_score(struct read_t *read);
+static char *read_entry(struct read_t *read, uint64_t score, struct db_entry_t **entry);
+static char *read_cold(struct read_t *read, struct db_entry_t **entry);
 
 struct io_chunk_t read_chunk(const struct read_t *read);
 static void read_proc(struct io_file_t file, void *arg);
 
+static void save_flush(struct save_t *save);
+static void save_mem(struct save_t *save, const char *data, size_t nbytes);
+static void save_num(struct save_t *save, uint64_t num);
+static void save_str(struct save_t *save, const char *str);
+
+static struct db_t *db_copy(struct db_t *db, unsigned int cnt);
+static uint64_t db_scan(struct db_t *db);
+
+static struct db_seg_t seg_init(void);
+static void seg_release(struct db_seg_t *seg);
+static struct db_entry_t *seg_get(struct db_seg_t *seg, unsigned int idx);
+static void seg_append(struct db_seg_t *seg, struct db_entry_t *entry);
+static struct db_seg_t seg_copy(struct db_seg_t *seg, unsigned int cnt);
+static void seg_set(struct db_seg_t *seg, unsigned int idx, struct db_entry_t *entry);
+
+static void page_release(struct db_page_t *page);
+static void entry_release(struct db_entry_t *entry);
+
+static struct db_index_t *index_new(unsigned int size);
+static void index_release(struct db_index_t *index);
+static struct db_index_t *index_own(struct db_index_t *index);
+static unsigned int index_find(struct db_index_t *index, unsigned int id);
+static struct db_index_t *index_add(struct db_index_t *index, unsigned int id, unsigned int idx);
+
 
 /**
  * Open a reader.
@@ -36,17 +89,50 @@ static void read_proc(struct io_file_t file, void *arg);
  *   &returns: The reader.
  */
 static struct read_t *read_open(const char *path)
+{
+	FILE *file;
+
+	file = fopen(path, "r");
+	if(file == NULL)
+		fatal("Cannot open '%s' for reading. %s.", path, strerror(errno));
+
+	return read_new(path, file);
+}
+
+/**
+ * Open a reader on a string.
+ *   @path: The path used for messages.
+ *   @str: The string.
+ *   &returns: The reader.
+ */
+static struct read_t *read_mem(const char *path, const char *str)
+{
+	FILE *file;
+
+	file = fmemopen((void *)str, strlen(str), "r");
+	if(file == NULL)
+		fatal("Cannot open '%s' for reading. %s.", path, strerror(errno));
+
+	return read_new(path, file);
+}
+
+/**
+ * Create a reader on an open file.
+ *   @path: The path.
+ *   @file: Consumed. The file.
+ *   &returns: The reader.
+ */
+static struct read_t *read_new(const char *path, FILE *file)
 {
 	struct read_t *read;
 
 	read = malloc(sizeof(struct read_t));
 	read->path = path;
-	read->file = fopen(path, "r");
-	if(read->file == NULL)
-		fatal("Cannot open '%s' for reading. %s.", path, strerror(errno));
-
+	read->file = file;
 	read->ch = fgetc(read->file);
 	read->line = read->col = 1;
+	read->buf = strbuf_init(64);
+	read->raw = NULL;
 
 	return read;
 }
@@ -57,6 +143,7 @@ static struct read_t *read_open(const char *path)
  */
 static void read_close(struct read_t *read)
 {
+	strbuf_destroy(&read->buf);
 	fclose(read->file);
 	free(read);
 }
@@ -69,6 +156,9 @@ static void read_close(struct read_t *read)
  */
 static int read_next(struct read_t *read)
 {
+	if(read->raw != NULL)
+		strbuf_addch(read->raw, read->ch);
+
 	read->ch = fgetc(read->file);
 
 	if(read->ch == '\n')
@@ -113,15 +203,29 @@ static uint64_t read_num(struct read_t *read)
 	return num;
 }
 
+/**
+ * Read a score from a reader, where '-' marks a suspended entry.
+ *   @read: The reader.
+ *   &returns: The score.
+ */
+static uint64_t read_score(struct read_t *read)
+{
+	if(read->ch != '-')
+		return read_num(read);
+
+	read_next(read);
+
+	return 255;
+}
+
 /**
  * Read a string from a reader.
  *   @read: The reader.
- *   &returns: The string.
+ *   &returns: The interned string.
  */
-char *read_str(struct read_t *read)
+const char *read_str(struct read_t *read)
 {
-	char *str;
-	struct strbuf_t buf;
+	const char *str;
 
 	while(isspace(read->ch))
 		read_next(read);
@@ -131,14 +235,14 @@ char *read_str(struct read_t *read)
 	else if(read->ch == '\'')
 		fatal("stub");
 	else if((read->ch != ',') && (read->ch != ';') && (read->ch != EOF)) {
-		buf = strbuf_init(16);
+		read->buf.idx = 0;
 
 		do {
-			strbuf_addch(&buf, read->ch);
+			strbuf_addch(&read->buf, read->ch);
 			read_next(read);
 		} while((read->ch != EOF) && (strchr(",;\n", read->ch) == NULL));
 
-		str = strbuf_done(&buf);
+		str = intern_get(read->buf.arr, read->buf.idx);
 	}
 	else
 		fatal("%C: Invalid character '%c' where string expected.", read_chunk(read), read->ch);
@@ -147,6 +251,94 @@ char *read_str(struct read_t *read)
 }
 
 
+/**
+ * Read the fields of an entry following the score through the terminating
+ * ';'.
+ *   @read: The reader.
+ *   @score: The already read score.
+ *   @entry: Ref. The entry, without an identifier.
+ *   &returns: Error.
+ */
+static char *read_entry(struct read_t *read, uint64_t score, struct db_entry_t **entry)
+{
+#define onexit while(i-- > 0) intern_put(str[i]);
+	unsigned int i = 0;
+	uint64_t time;
+	const char *str[5];
+
+	if((score > 5) && (score != 255))
+		fail("%C: Score too large.", read_chunk(read));
+
+	if(read->ch != ',')
+		fail("%C: Expected ','.", read_chunk(read));
+
+	read_next(read);
+	time = read_num(read);
+
+	for(i = 0; i < 5; i++) {
+		if(read->ch != ',')
+			fail("%C: Expected ','.", read_chunk(read));
+
+		read_next(read);
+		str[i] = read_str(read);
+	}
+
+	if(read->ch != ';')
+		fail("%C: Expected ';'.", read_chunk(read));
+
+	read_next(read);
+
+	*entry = malloc(sizeof(struct db_entry_t));
+	(*entry)->refcnt = 1;
+	(*entry)->id = DB_NOID;
+	(*entry)->score = score;
+	(*entry)->time = time;
+	(*entry)->eng = str[0];
+	(*entry)->rom = str[1];
+	(*entry)->hir = str[2];
+	(*entry)->kanji = str[3];
+	(*entry)->audio = str[4];
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Read a suspended record, checking its fields so that a malformed record
+ * fails the load, but keeping only its raw text through the terminating ';'
+ * in a cold entry.
+ *   @read: The reader.
+ *   @entry: Ref. The cold entry, without an identifier.
+ *   &returns: Error.
+ */
+static char *read_cold(struct read_t *read, struct db_entry_t **entry)
+{
+#define onexit read->raw = NULL; strbuf_destroy(&raw);
+	struct strbuf_t raw;
+	struct db_entry_t *load;
+
+	raw = strbuf_init(128);
+	read->raw = &raw;
+	chkfail(read_entry(read, read_score(read), &load));
+	read->raw = NULL;
+
+	db_entry_release(load);
+
+	*entry = malloc(sizeof(struct db_entry_t) + raw.idx + 1);
+	(*entry)->refcnt = 1;
+	(*entry)->id = DB_NOID;
+	(*entry)->score = 255;
+	(*entry)->time = 0;
+	(*entry)->eng = (*entry)->rom = (*entry)->hir = (*entry)->kanji = (*entry)->audio = NULL;
+	memcpy((*entry)->raw, raw.arr, raw.idx);
+	(*entry)->raw[raw.idx] = '\0';
+
+	strbuf_destroy(&raw);
+
+	return NULL;
+#undef onexit
+}
+
 /**
  * Create a chunk for the current reader position.
  *   @read: The reader.
@@ -164,28 +356,32 @@ static void read_proc(struct io_file_t file, void *arg)
 
 
 /**
- * Open a database.
+ * Open a database. Records without an identifier are numbered in file
+ * order after the largest identifier in the file, so that a deck written
+ * before identifiers existed keeps its positional numbering.
+ *   @ret: Ref. The database.
  *   @path: The path.
- *   &returns: The database.
+ *   &returns: Error.
  */
 char *db_open(struct db_t **ret, const char *path)
 {
-#define onexit free(db);
+#define onexit db_close(db); read_close(read); erase(miss);
 	struct db_t *db;
-	struct db_entry_t **entry;
+	struct db_entry_t *entry;
 	struct read_t *read;
-	unsigned int id = 0;
+	unsigned int i, slot, next = 0, nmiss = 0, *miss = NULL;
 
 	db = malloc(sizeof(struct db_t));
-	db->entry = NULL;
-	entry = &db->entry;
+	db->refcnt = 1;
+	db->hot = seg_init();
+	db->cold = seg_init();
+	db->index = index_new(64);
 
 	read = read_open(path);
 
 	while(true) {
-		unsigned int i;
-		uint64_t score, time;
-		char *str[5];
+		unsigned int id = DB_NOID;
+		uint64_t score = 0;
 		
 		while(isspace(read->ch))
 			read_next(read);
@@ -193,50 +389,59 @@ char *db_open(struct db_t **ret, const char *path)
 		if(read->ch == EOF)
 			break;
 
-		if(read->ch != '-') {
+		if(isdigit(read->ch)) {
 			score = read_num(read);
-			if(score > 5)
-				fail("%C: Score too large.", read_chunk(read));
+			if(read->ch == ':') {
+				if(score >= DB_NOID)
+					fail("%C: Identifier too large.", read_chunk(read));
+				else if(index_find(db->index, score) != UINT_MAX)
+					fail("%C: Duplicate identifier %u.", read_chunk(read), (unsigned int)score);
+
+				id = score;
+				read_next(read);
+				if(read->ch != '-')
+					score = read_score(read);
+			}
+		}
+		else if(read->ch != '-')
+			score = read_score(read);
+
+		if(read->ch == '-') {
+			chkfail(read_cold(read, &entry));
+			slot = db->cold.cnt | DB_COLD;
+			seg_append(&db->cold, entry);
 		}
 		else {
-			score = 255;
-			read_next(read);
+			chkfail(read_entry(read, score, &entry));
+			slot = db->hot.cnt;
+			seg_append(&db->hot, entry);
 		}
 
-		if(read->ch != ',')
-			fail("%C: Expected ','.", read_chunk(read));
-
-		read_next(read);
-		time = read_num(read);
-
-		for(i = 0; i < 5; i++) {
-			if(read->ch != ',')
-				fail("%C: Expected ','.", read_chunk(read));
-
-			read_next(read);
-			str[i] = read_str(read);
+		entry->id = id;
+		if(id != DB_NOID) {
+			db->index = index_add(db->index, id, slot);
+			if(id >= next)
+				next = id + 1;
 		}
+		else {
+			if(nmiss == 0)
+				miss = malloc(sizeof(unsigned int));
+			else if((nmiss & (nmiss - 1)) == 0)
+				miss = realloc(miss, 2 * nmiss * sizeof(unsigned int));
 
-		if(read->ch != ';')
-			fail("%C: Expected ';'.", read_chunk(read));
-
-		read_next(read);
+			miss[nmiss++] = slot;
+		}
+	}
 
-		*entry = malloc(sizeof(struct db_entry_t));
-		(*entry)->id = id++;
-		(*entry)->score = score;
-		(*entry)->time = time;
-		(*entry)->eng = str[0];
-		(*entry)->rom = str[1];
-		(*entry)->hir = str[2];
-		(*entry)->kanji = str[3];
-		(*entry)->audio = str[4];
-		(*entry)->next = NULL;
-		entry = &(*entry)->next;
+	for(i = 0; i < nmiss; i++) {
+		entry = (miss[i] & DB_COLD) ? db_cold(db, miss[i] & ~DB_COLD) : db_get(db, miss[i]);
+		entry->id = next++;
+		db->index = index_add(db->index, entry->id, miss[i]);
 	}
 
+	erase(miss);
 	read_close(read);
-	*entry = NULL;
+	db->due = db_scan(db);
 	*ret = db;
 
 	return NULL;
@@ -244,53 +449,558 @@ char *db_open(struct db_t **ret, const char *path)
 }
 
 /**
- * Close a database.
+ * Add a reference to a database.
+ *   @db: The database.
+ *   &returns: The database.
+ */
+struct db_t *db_ref(struct db_t *db)
+{
+	__atomic_add_fetch(&db->refcnt, 1, __ATOMIC_RELAXED);
+
+	return db;
+}
+
+/**
+ * Close a database, releasing a reference. The database is freed once the
+ * last reference is released.
  *   @db: The database.
  */
 void db_close(struct db_t *db)
+{
+	if(__atomic_sub_fetch(&db->refcnt, 1, __ATOMIC_ACQ_REL) > 0)
+		return;
+
+	seg_release(&db->hot);
+	seg_release(&db->cold);
+	index_release(db->index);
+	free(db);
+}
+
+
+/**
+ * Get the hot entry with a given index.
+ *   @db: The database.
+ *   @idx: The index.
+ *   &returns: The entry or null.
+ */
+struct db_entry_t *db_get(struct db_t *db, unsigned int idx)
+{
+	return seg_get(&db->hot, idx);
+}
+
+/**
+ * Get the cold entry with a given index.
+ *   @db: The database.
+ *   @idx: The index.
+ *   &returns: The entry or null.
+ */
+struct db_entry_t *db_cold(struct db_t *db, unsigned int idx)
+{
+	return seg_get(&db->cold, idx);
+}
+
+/**
+ * Lookup a hot or cold entry by its identifier.
+ *   @db: The database.
+ *   @id: The identifier.
+ *   &returns: The entry or null.
+ */
+struct db_entry_t *db_lookup(struct db_t *db, unsigned int id)
+{
+	unsigned int idx;
+
+	idx = index_find(db->index, id);
+	if(idx == UINT_MAX)
+		return NULL;
+	else if(idx & DB_COLD)
+		return db_cold(db, idx & ~DB_COLD);
+	else
+		return db_get(db, idx);
+}
+
+/**
+ * Retrieve a random due entry from the database.
+ *   @db: The database.
+ *   &returns: The entry, or null if none is due.
+ */
+struct db_entry_t *db_rand(struct db_t *db)
 {
 	struct db_entry_t *entry;
 
-	while(db->entry != NULL) {
-		entry = db->entry;
-		db->entry = entry->next;
+	return (db_sample(db, &entry, 1, NULL, 0) > 0) ? entry : NULL;
+}
+
+/**
+ * Sample distinct random due entries from the database in a single scan.
+ *   @db: The database.
+ *   @entry: The output array of entries.
+ *   @n: The size of the array.
+ *   @skip: Optional. The identifiers to leave out.
+ *   @nskip: The number of identifiers to leave out.
+ *   &returns: The number of entries sampled, fewer than requested if not
+ *     enough are due.
+ */
+unsigned int db_sample(struct db_t *db, struct db_entry_t **entry, unsigned int n, const unsigned int *skip, unsigned int nskip)
+{
+	uint64_t tm;
+	unsigned int i, j, k, cnt = 0;
+	struct db_entry_t *cur;
+
+	tm = sys_utime();
+
+	for(i = 0; i < db->hot.cnt; i++) {
+		cur = db_get(db, i);
+		if((cur == NULL) || (cur->time > tm))
+			continue;
+
+		for(k = 0; (k < nskip) && (skip[k] != cur->id); k++)
+			;
+
+		if(k < nskip)
+			continue;
+
+		if(cnt < n)
+			entry[cnt] = cur;
+		else if((j = rand() % (cnt + 1)) < n)
+			entry[j] = cur;
 
-		free(entry->eng);
-		free(entry->rom);
-		free(entry->hir);
-		free(entry->kanji);
-		free(entry->audio);
-		free(entry);
+		cnt++;
 	}
 
-	free(db);
+	if(cnt > n)
+		cnt = n;
+
+	for(i = cnt; i > 1; i--) {
+		j = rand() % i;
+		cur = entry[i - 1];
+		entry[i - 1] = entry[j];
+		entry[j] = cur;
+	}
+
+	return cnt;
+}
+
+/**
+ * Retrieve the time at which the next entry becomes due.
+ *   @db: The database.
+ *   &returns: The due time in microseconds, or 'DB_NEVER' if no hot
+ *     entries.
+ */
+uint64_t db_due(struct db_t *db)
+{
+	return db->due;
+}
+
+/**
+ * Create a new version of the database with a replaced hot entry. Only the
+ * page table and the page holding the entry are copied; everything else is
+ * shared with the original version.
+ *   @db: The database.
+ *   @entry: Consumed. The new entry, replacing the entry of the same
+ *     identifier.
+ *   &returns: The new database.
+ */
+struct db_t *db_replace(struct db_t *db, struct db_entry_t *entry)
+{
+	unsigned int idx;
+	uint64_t time;
+	struct db_t *copy;
+
+	idx = index_find(db->index, entry->id);
+	assert(db_get(db, idx) != NULL);
+
+	time = db_get(db, idx)->time;
+	copy = db_copy(db, db->hot.cnt);
+	seg_set(&copy->hot, idx, entry);
+
+	if(entry->time <= copy->due)
+		copy->due = entry->time;
+	else if(time == copy->due)
+		copy->due = db_scan(copy);
+
+	return copy;
+}
+
+/**
+ * Create a new version of the database with an inserted hot entry. An entry
+ * whose identifier was previously removed returns to its old slot, a cold
+ * entry of the same identifier is moved out of the cold segment, and a new
+ * identifier is appended. Moving or adding an identifier copies the index
+ * if it is shared, so that older versions keep their own slots.
+ *   @db: The database.
+ *   @entry: Consumed. The new entry.
+ *   &returns: The new database.
+ */
+struct db_t *db_insert(struct db_t *db, struct db_entry_t *entry)
+{
+	unsigned int idx;
+	struct db_t *copy;
+
+	idx = index_find(db->index, entry->id);
+	if((idx == UINT_MAX) || (idx & DB_COLD)) {
+		copy = db_copy(db, db->hot.cnt + 1);
+		copy->index = index_add(index_own(copy->index), entry->id, db->hot.cnt);
+		seg_set(&copy->hot, db->hot.cnt, entry);
+
+		if(idx != UINT_MAX)
+			seg_set(&copy->cold, idx & ~DB_COLD, NULL);
+	}
+	else {
+		assert(db_get(db, idx) == NULL);
+
+		copy = db_copy(db, db->hot.cnt);
+		seg_set(&copy->hot, idx, entry);
+	}
+
+	if(entry->time < copy->due)
+		copy->due = entry->time;
+
+	return copy;
+}
+
+/**
+ * Create a new version of the database with an entry removed. The slot is
+ * left empty and retained by the identifier.
+ *   @db: The database.
+ *   @id: The identifier.
+ *   &returns: The new database, or null if no such entry.
+ */
+struct db_t *db_remove(struct db_t *db, unsigned int id)
+{
+	unsigned int idx;
+	uint64_t time;
+	struct db_t *copy;
+
+	if(db_lookup(db, id) == NULL)
+		return NULL;
+
+	idx = index_find(db->index, id);
+	time = (idx & DB_COLD) ? DB_NEVER : db_get(db, idx)->time;
+	copy = db_copy(db, db->hot.cnt);
+	seg_set((idx & DB_COLD) ? &copy->cold : &copy->hot, idx & ~DB_COLD, NULL);
+
+	if(time == copy->due)
+		copy->due = db_scan(copy);
+
+	return copy;
 }
 
+/**
+ * Create a private copy of a database, sharing all pages.
+ *   @db: The database.
+ *   @cnt: The number of hot slots, at least the original number.
+ *   &returns: The copy.
+ */
+static struct db_t *db_copy(struct db_t *db, unsigned int cnt)
+{
+	struct db_t *copy;
+
+	copy = malloc(sizeof(struct db_t));
+	copy->refcnt = 1;
+	copy->hot = seg_copy(&db->hot, cnt);
+	copy->cold = seg_copy(&db->cold, db->cold.cnt);
+	copy->index = db->index;
+	copy->due = db->due;
+	__atomic_add_fetch(&copy->index->refcnt, 1, __ATOMIC_RELAXED);
 
-static void str_proc(struct io_file_t file, void *arg);
+	return copy;
+}
 
-struct io_chunk_t str_chunk(const char *str)
+/**
+ * Scan the hot segment for the earliest due time. Versions keep the due
+ * time up to date incrementally and only rescan when the earliest entry is
+ * postponed or removed.
+ *   @db: The database.
+ *   &returns: The earliest due time, or 'DB_NEVER' if no hot entries.
+ */
+static uint64_t db_scan(struct db_t *db)
 {
-	return (struct io_chunk_t){ str_proc, (void *)str };
+	unsigned int i;
+	uint64_t due = DB_NEVER;
+	struct db_entry_t *entry;
+
+	for(i = 0; i < db->hot.cnt; i++) {
+		entry = db_get(db, i);
+		if((entry != NULL) && (entry->time < due))
+			due = entry->time;
+	}
+
+	return due;
 }
-static void str_proc(struct io_file_t file, void *arg)
+
+
+/**
+ * Initialize an empty segment.
+ *   &returns: The segment.
+ */
+static struct db_seg_t seg_init(void)
 {
-	const char *str = arg;
+	return (struct db_seg_t){ 0, 0, NULL };
+}
 
-	if(strpbrk(str, "\"\t") != NULL) {
-		hprintf(file, "\"");
+/**
+ * Release the pages of a segment.
+ *   @seg: The segment.
+ */
+static void seg_release(struct db_seg_t *seg)
+{
+	unsigned int i;
+
+	for(i = 0; i < seg->npage; i++)
+		page_release(seg->page[i]);
+
+	erase(seg->page);
+}
+
+/**
+ * Get the entry in a segment slot.
+ *   @seg: The segment.
+ *   @idx: The slot index.
+ *   &returns: The entry or null.
+ */
+static struct db_entry_t *seg_get(struct db_seg_t *seg, unsigned int idx)
+{
+	if(idx >= seg->cnt)
+		return NULL;
+
+	return seg->page[idx / DB_PAGE]->entry[idx % DB_PAGE];
+}
+
+/**
+ * Append an entry onto a private segment under construction.
+ *   @seg: The segment.
+ *   @entry: Consumed. The entry.
+ */
+static void seg_append(struct db_seg_t *seg, struct db_entry_t *entry)
+{
+	if((seg->cnt % DB_PAGE) == 0) {
+		if(seg->page == NULL)
+			seg->page = malloc(sizeof(struct db_page_t *));
+		else
+			seg->page = realloc(seg->page, (seg->npage + 1) * sizeof(struct db_page_t *));
+
+		seg->page[seg->npage] = malloc(sizeof(struct db_page_t));
+		seg->page[seg->npage]->refcnt = 1;
+		memset(seg->page[seg->npage]->entry, 0x00, sizeof(seg->page[seg->npage]->entry));
+		seg->npage++;
+	}
+
+	seg->page[seg->cnt / DB_PAGE]->entry[seg->cnt % DB_PAGE] = entry;
+	seg->cnt++;
+}
+
+/**
+ * Copy a segment, sharing all pages.
+ *   @seg: The segment.
+ *   @cnt: The number of slots, at least the original number.
+ *   &returns: The copy.
+ */
+static struct db_seg_t seg_copy(struct db_seg_t *seg, unsigned int cnt)
+{
+	unsigned int i;
+	struct db_seg_t copy;
 
-		while(*str != '\0') {
-			if(strchr("\"\t", *str) != NULL)
-				hprintf(file, "\\");
+	copy.cnt = cnt;
+	copy.npage = (cnt + DB_PAGE - 1) / DB_PAGE;
+	copy.page = malloc(copy.npage * sizeof(struct db_page_t *));
 
-			hprintf(file, "%c", *str++);
+	for(i = 0; i < seg->npage; i++) {
+		copy.page[i] = seg->page[i];
+		__atomic_add_fetch(&copy.page[i]->refcnt, 1, __ATOMIC_RELAXED);
+	}
+
+	for(; i < copy.npage; i++) {
+		copy.page[i] = malloc(sizeof(struct db_page_t));
+		copy.page[i]->refcnt = 1;
+		memset(copy.page[i]->entry, 0x00, sizeof(copy.page[i]->entry));
+	}
+
+	return copy;
+}
+
+/**
+ * Set a slot on a private segment, copying the page if it is shared.
+ *   @seg: The segment.
+ *   @idx: The slot index.
+ *   @entry: Consumed. Optional. The entry.
+ */
+static void seg_set(struct db_seg_t *seg, unsigned int idx, struct db_entry_t *entry)
+{
+	unsigned int i;
+	struct db_page_t *page = seg->page[idx / DB_PAGE];
+
+	if(__atomic_load_n(&page->refcnt, __ATOMIC_ACQUIRE) > 1) {
+		page = malloc(sizeof(struct db_page_t));
+		page->refcnt = 1;
+
+		for(i = 0; i < DB_PAGE; i++) {
+			page->entry[i] = seg->page[idx / DB_PAGE]->entry[i];
+			if(page->entry[i] != NULL)
+				__atomic_add_fetch(&page->entry[i]->refcnt, 1, __ATOMIC_RELAXED);
 		}
 
-		hprintf(file, "\"");
+		page_release(seg->page[idx / DB_PAGE]);
+		seg->page[idx / DB_PAGE] = page;
 	}
-	else
-		hprintf(file, "%s", str);
+
+	if(page->entry[idx % DB_PAGE] != NULL)
+		entry_release(page->entry[idx % DB_PAGE]);
+
+	page->entry[idx % DB_PAGE] = entry;
+}
+
+
+/**
+ * Release a reference to a page.
+ *   @page: The page.
+ */
+static void page_release(struct db_page_t *page)
+{
+	unsigned int i;
+
+	if(__atomic_sub_fetch(&page->refcnt, 1, __ATOMIC_ACQ_REL) > 0)
+		return;
+
+	for(i = 0; i < DB_PAGE; i++) {
+		if(page->entry[i] != NULL)
+			entry_release(page->entry[i]);
+	}
+
+	free(page);
+}
+
+/**
+ * Release a reference to an entry.
+ *   @entry: The entry.
+ */
+static void entry_release(struct db_entry_t *entry)
+{
+	if(__atomic_sub_fetch(&entry->refcnt, 1, __ATOMIC_ACQ_REL) > 0)
+		return;
+
+	if(!db_entry_iscold(entry)) {
+		intern_put(entry->eng);
+		intern_put(entry->rom);
+		intern_put(entry->hir);
+		intern_put(entry->kanji);
+		intern_put(entry->audio);
+	}
+
+	free(entry);
+}
+
+
+/**
+ * Create an empty index.
+ *   @size: The table size, a power of two.
+ *   &returns: The index.
+ */
+static struct db_index_t *index_new(unsigned int size)
+{
+	struct db_index_t *index;
+
+	index = malloc(sizeof(struct db_index_t));
+	index->refcnt = 1;
+	index->cnt = 0;
+	index->size = size;
+	index->arr = malloc(size * sizeof(uint64_t));
+	memset(index->arr, 0x00, size * sizeof(uint64_t));
+
+	return index;
+}
+
+/**
+ * Release a reference to an index.
+ *   @index: The index.
+ */
+static void index_release(struct db_index_t *index)
+{
+	if(__atomic_sub_fetch(&index->refcnt, 1, __ATOMIC_ACQ_REL) > 0)
+		return;
+
+	free(index->arr);
+	free(index);
+}
+
+/**
+ * Take a private index that may be modified, copying the index if it is
+ * shared with another version.
+ *   @index: Consumed. The index.
+ *   &returns: The private index.
+ */
+static struct db_index_t *index_own(struct db_index_t *index)
+{
+	struct db_index_t *copy;
+
+	if(__atomic_load_n(&index->refcnt, __ATOMIC_ACQUIRE) == 1)
+		return index;
+
+	copy = index_new(index->size);
+	copy->cnt = index->cnt;
+	memcpy(copy->arr, index->arr, index->size * sizeof(uint64_t));
+	index_release(index);
+
+	return copy;
+}
+
+/**
+ * Find the slot of an identifier.
+ *   @index: The index.
+ *   @id: The identifier.
+ *   &returns: The slot index, or 'UINT_MAX' if not found.
+ */
+static unsigned int index_find(struct db_index_t *index, unsigned int id)
+{
+	uint64_t pair;
+	unsigned int i, mask = index->size - 1;
+
+	for(i = (id * 2654435769u) & mask; ; i = (i + 1) & mask) {
+		pair = index->arr[i];
+		if(pair == 0)
+			return UINT_MAX;
+		else if((pair >> 32) == id)
+			return (uint32_t)pair - 1;
+	}
+}
+
+/**
+ * Add an identifier to a private index, or move an existing identifier to a
+ * new slot. If the table must grow, a new index is created and the
+ * reference to the original is released.
+ *   @index: Consumed. The index.
+ *   @id: The identifier.
+ *   @idx: The slot index.
+ *   &returns: The index.
+ */
+static struct db_index_t *index_add(struct db_index_t *index, unsigned int id, unsigned int idx)
+{
+	unsigned int i, mask;
+
+	if((2 * (index->cnt + 1)) > index->size) {
+		struct db_index_t *grow;
+
+		grow = index_new(2 * index->size);
+		for(i = 0; i < index->size; i++) {
+			if(index->arr[i] != 0)
+				grow = index_add(grow, index->arr[i] >> 32, (uint32_t)index->arr[i] - 1);
+		}
+
+		index_release(index);
+		index = grow;
+	}
+
+	mask = index->size - 1;
+	for(i = (id * 2654435769u) & mask; index->arr[i] != 0; i = (i + 1) & mask) {
+		if((index->arr[i] >> 32) == id)
+			break;
+	}
+
+	if(index->arr[i] == 0)
+		index->cnt++;
+
+	index->arr[i] = ((uint64_t)id << 32) | (idx + 1);
+
+	return index;
 }
 
 
@@ -301,77 +1011,216 @@ static void str_proc(struct io_file_t file, void *arg)
  */
 void db_save(struct db_t *db, const char *path)
 {
-	FILE *file;
+	unsigned int i;
+	struct save_t *save;
 	struct db_entry_t *entry;
 
-	file = fopen(path, "w");
-	if(file == NULL)
+	save = malloc(sizeof(struct save_t));
+	save->idx = 0;
+	save->path = path;
+	save->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(save->fd < 0)
 		fatal("Cannot open '%s' for writing. %s.", path, strerror(errno));
 
-	for(entry = db->entry; entry != NULL; entry = entry->next) {
+	for(i = 0; i < db->hot.cnt; i++) {
+		entry = db_get(db, i);
+		if(entry == NULL)
+			continue;
+
+		save_num(save, entry->id);
+		save_mem(save, ":", 1);
+
 		if(entry->score == 255)
-			fprintf(file, "-,%lu,%C,%C,%C,%C,%C;\n", entry->time, str_chunk(entry->eng), str_chunk(entry->rom), str_chunk(entry->hir), str_chunk(entry->kanji), str_chunk(entry->audio));
+			save_mem(save, "-", 1);
 		else
-			fprintf(file, "%u,%lu,%C,%C,%C,%C,%C;\n", entry->score, entry->time, str_chunk(entry->eng), str_chunk(entry->rom), str_chunk(entry->hir), str_chunk(entry->kanji), str_chunk(entry->audio));
+			save_num(save, entry->score);
+
+		save_mem(save, ",", 1);
+		save_num(save, entry->time);
+		save_mem(save, ",", 1);
+		save_str(save, entry->eng);
+		save_mem(save, ",", 1);
+		save_str(save, entry->rom);
+		save_mem(save, ",", 1);
+		save_str(save, entry->hir);
+		save_mem(save, ",", 1);
+		save_str(save, entry->kanji);
+		save_mem(save, ",", 1);
+		save_str(save, entry->audio);
+		save_mem(save, ";\n", 2);
+	}
+
+	for(i = 0; i < db->cold.cnt; i++) {
+		entry = db_cold(db, i);
+		if(entry == NULL)
+			continue;
+
+		save_num(save, entry->id);
+		save_mem(save, ":", 1);
+		save_mem(save, entry->raw, strlen(entry->raw));
+		save_mem(save, "\n", 1);
 	}
 
-	fclose(file);
+	save_flush(save);
+	close(save->fd);
+	free(save);
 }
 
 
 /**
- * Get the entry with a given index.
- *   @db: The database.
- *   @idx: The index.
+ * Flush the serializer buffer to its file.
+ *   @save: The serializer.
  */
-struct db_entry_t *db_get(struct db_t *db, unsigned int idx)
+static void save_flush(struct save_t *save)
 {
-	struct db_entry_t *entry;
+	ssize_t wr;
+	size_t off = 0;
+
+	while(off < save->idx) {
+		wr = write(save->fd, save->buf + off, save->idx - off);
+		if(wr < 0) {
+			if(errno == EINTR)
+				continue;
+
+			fatal("Failed to write '%s'. %s.", save->path, strerror(errno));
+		}
 
-	for(entry = db->entry; entry != NULL; entry = entry->next) {
-		if(idx-- == 0)
-			return entry;
+		off += wr;
 	}
 
-	return NULL;
+	save->idx = 0;
 }
 
 /**
- * Retrieve a random entry from the database.
- *   @db: The database.
+ * Write raw memory to the serializer.
+ *   @save: The serializer.
+ *   @data: The data.
+ *   @nbytes: The number of bytes.
  */
-struct db_entry_t *db_rand(struct db_t *db)
+static void save_mem(struct save_t *save, const char *data, size_t nbytes)
 {
-	struct avltree_t tree;
-	struct db_entry_t *entry;
-	uint64_t tm;
-	unsigned int i, n;
-	struct avltree_inst_t *inst;
+	size_t len;
 
-	tm = sys_utime();
-	tree = avltree_init(compare_ptr, delete_noop);
+	if(nbytes <= (sizeof(save->buf) - save->idx)) {
+		memcpy(save->buf + save->idx, data, nbytes);
+		save->idx += nbytes;
+		return;
+	}
 
-	for(entry = db->entry; entry != NULL; entry = entry->next) {
-		if((entry->score == 255) || (entry->time > tm))
-			continue;
+	while(nbytes > 0) {
+		if(save->idx == sizeof(save->buf))
+			save_flush(save);
+
+		len = sizeof(save->buf) - save->idx;
+		if(len > nbytes)
+			len = nbytes;
+
+		memcpy(save->buf + save->idx, data, len);
+		save->idx += len;
+		data += len;
+		nbytes -= len;
+	}
+}
+
+/**
+ * Write a decimal number to the serializer.
+ *   @save: The serializer.
+ *   @num: The number.
+ */
+static void save_num(struct save_t *save, uint64_t num)
+{
+	char tmp[20];
+	unsigned int i = sizeof(tmp);
+
+	do
+		tmp[--i] = '0' + (num % 10);
+	while((num /= 10) > 0);
+
+	save_mem(save, tmp + i, sizeof(tmp) - i);
+}
+
+/**
+ * Write a string to the serializer, quoting and escaping it if it contains
+ * a quote or tab. The special characters are located with 'strcspn', which
+ * the C library vectorizes, so plain strings are copied in bulk.
+ *   @save: The serializer.
+ *   @str: The string.
+ */
+static void save_str(struct save_t *save, const char *str)
+{
+	size_t len;
 
-		avltree_insert(&tree, entry, entry);
+	len = strcspn(str, "\"\t");
+	if(str[len] == '\0') {
+		save_mem(save, str, len);
+		return;
 	}
 
-	if(tree.root.count > 0) {
-		n = rand() % tree.root.count;
-		inst = avltree_first(&tree);
-		for(i = 0; i < n; i++)
-			inst = avltree_next(inst);
+	save_mem(save, "\"", 1);
+
+	while(true) {
+		save_mem(save, str, len);
+		str += len;
+		if(*str == '\0')
+			break;
 
-		entry = inst->val;
+		save_mem(save, "\\", 1);
+		save_mem(save, str++, 1);
+		len = strcspn(str, "\"\t");
 	}
-	else
-		entry = NULL;
 
-	avltree_destroy(&tree);
+	save_mem(save, "\"", 1);
+}
+
+
+/**
+ * Copy an entry so that it may be modified.
+ *   @entry: The entry.
+ *   &returns: The private copy.
+ */
+struct db_entry_t *db_entry_copy(const struct db_entry_t *entry)
+{
+	struct db_entry_t *copy;
+
+	assert(!db_entry_iscold(entry));
+
+	copy = malloc(sizeof(struct db_entry_t));
+	*copy = (struct db_entry_t){ 1, entry->id, entry->score, entry->time, entry->eng, entry->rom, entry->hir, entry->kanji, entry->audio };
+	intern_ref(copy->eng);
+	intern_ref(copy->rom);
+	intern_ref(copy->hir);
+	intern_ref(copy->kanji);
+	intern_ref(copy->audio);
+
+	return copy;
+}
+
+/**
+ * Load a cold entry by parsing its raw record.
+ *   @entry: The cold entry.
+ *   &returns: The loaded entry.
+ */
+struct db_entry_t *db_entry_load(const struct db_entry_t *entry)
+{
+	struct read_t *read;
+	struct db_entry_t *load;
+
+	read = read_mem("suspended entry", entry->raw);
+	chkabort(read_entry(read, read_score(read), &load));
+	read_close(read);
+
+	load->id = entry->id;
 
-	return entry;
+	return load;
+}
+
+/**
+ * Release a reference to an entry.
+ *   @entry: The entry.
+ */
+void db_entry_release(struct db_entry_t *entry)
+{
+	entry_release(entry);
 }
 
 
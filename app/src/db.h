@@ -8,29 +8,90 @@
 // 4: 1 week  -- learned
 // 5: 1 month -- mastered
 
+/*
+ * database definitions
+ */
+#define DB_PAGE	64
+#define DB_NOID	UINT_MAX
+#define DB_COLD	0x80000000
+#define DB_NEVER	UINT64_MAX
+
+/**
+ * Database segment structure.
+ *   @cnt, npage: The number of slots and pages.
+ *   @page: The page table.
+ */
+struct db_seg_t {
+	unsigned int cnt, npage;
+	struct db_page_t **page;
+};
+
 /**
- * Database structure.
- *   @entry: The main entry.
+ * Database structure. A database is an immutable version of a deck. Pages
+ * and entries are reference counted and shared between versions, so that a
+ * change only copies the page tables and the affected page.
+ *
+ * Suspended entries live in the cold segment as unparsed records and are
+ * never seen by scans of the hot segment.
+ *   @refcnt: The reference count.
+ *   @hot, cold: The hot and cold segments.
+ *   @index: The identifier index.
+ *   @due: The earliest due time of any hot entry, 'DB_NEVER' if none.
  */
 struct db_t {
-	struct db_entry_t *entry;
+	unsigned int refcnt;
+
+	struct db_seg_t hot, cold;
+	struct db_index_t *index;
+	uint64_t due;
+};
+
+/**
+ * Database page structure.
+ *   @refcnt: The reference count.
+ *   @entry: The entry array.
+ */
+struct db_page_t {
+	unsigned int refcnt;
+
+	struct db_entry_t *entry[DB_PAGE];
+};
+
+/**
+ * Database index structure. The index maps stable identifiers to slots,
+ * with cold slots marked by 'DB_COLD'. Slots are never reused by another
+ * identifier, so a removed entry simply leaves its slot empty and the index
+ * is shared between versions; only moving or adding an identifier copies
+ * it, which is rare next to replacing an entry.
+ *   @refcnt: The reference count.
+ *   @cnt, size: The number of identifiers and the table size.
+ *   @arr: The table of packed identifier and slot pairs.
+ */
+struct db_index_t {
+	unsigned int refcnt;
+
+	unsigned int cnt, size;
+	uint64_t *arr;
 };
 
 /**
- * Database entry structure.
- *   @id: The identifier.
- *   @next: The next entry.
+ * Database entry structure. Cold entries have no strings and instead carry
+ * the raw record text.
+ *   @refcnt: The reference count.
+ *   @id: The stable identifier.
  *   @score: The current score.
  *   @time: The time until next
- *   @eng, rom, hir, kanji, audio: The entry strings.
+ *   @eng, rom, hir, kanji, audio: The interned entry strings.
+ *   @raw: The raw record of a cold entry.
  */
 struct db_entry_t {
-	unsigned int id;
-	struct db_entry_t *next;
+	unsigned int refcnt, id;
 
 	uint8_t score;
 	uint64_t time;
-	char *eng, *rom, *hir, *kanji, *audio;
+	const char *eng, *rom, *hir, *kanji, *audio;
+
+	char raw[];
 };
 
 
@@ -38,19 +99,42 @@ struct db_entry_t {
  * database declarations
  */
 char *db_open(struct db_t **ret, const char *path);
+struct db_t *db_ref(struct db_t *db);
 void db_close(struct db_t *db);
 
 void db_save(struct db_t *db, const char *path);
 
 struct db_entry_t *db_get(struct db_t *db, unsigned int idx);
+struct db_entry_t *db_cold(struct db_t *db, unsigned int idx);
+struct db_entry_t *db_lookup(struct db_t *db, unsigned int id);
 struct db_entry_t *db_rand(struct db_t *db);
+unsigned int db_sample(struct db_t *db, struct db_entry_t **entry, unsigned int n, const unsigned int *skip, unsigned int nskip);
+uint64_t db_due(struct db_t *db);
+
+struct db_t *db_replace(struct db_t *db, struct db_entry_t *entry);
+struct db_t *db_insert(struct db_t *db, struct db_entry_t *entry);
+struct db_t *db_remove(struct db_t *db, unsigned int id);
 
 /*
  * entry declarations
  */
+struct db_entry_t *db_entry_copy(const struct db_entry_t *entry);
+struct db_entry_t *db_entry_load(const struct db_entry_t *entry);
+void db_entry_release(struct db_entry_t *entry);
+
 void db_entry_inc(struct db_entry_t *entry);
 void db_entry_dec(struct db_entry_t *entry);
 void db_entry_zero(struct db_entry_t *entry);
 void db_entry_reset(struct db_entry_t *entry);
 
+/**
+ * Check if an entry is a cold entry.
+ *   @entry: The entry.
+ *   &returns: True if cold.
+ */
+static inline bool db_entry_iscold(const struct db_entry_t *entry)
+{
+	return entry->eng == NULL;
+}
+
 #endif
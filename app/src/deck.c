@@ -0,0 +1,242 @@
+#include "common.h"
+#include <sys/stat.h>
+
+
+/*
+ * local definitions
+ */
+#define CHECK	1000000
+
+/**
+ * Deck structure. The deck keeps the current version of the database
+ * resident; readers pin a version without taking any lock while writers
+ * serialize on the lock and publish new versions.
+ *   @path: The path.
+ *   @lock: The writer lock.
+ *   @hub: The hub signaled on each published version.
+ *   @version: The number of published versions.
+ *   @pinning: The number of readers in the middle of pinning.
+ *   @mtime: The file modification time of the last load attempted.
+ *   @check: The time the file was last checked for changes.
+ *   @db: The current database version.
+ */
+struct deck_t {
+	char *path;
+	sys_mutex_t lock;
+	struct http_hub_t *hub;
+	unsigned int version;
+
+	unsigned int pinning;
+	int64_t mtime, check;
+	struct db_t *db;
+};
+
+
+/*
+ * local declarations
+ */
+static char *deck_load(struct deck_t *deck);
+static void deck_publish(struct deck_t *deck, struct db_t *db);
+static int64_t deck_mtime(const char *path);
+
+
+/**
+ * Open a deck, loading the database from a path.
+ *   @deck: Ref. The deck.
+ *   @path: The path.
+ *   &returns: Error.
+ */
+char *deck_open(struct deck_t **deck, const char *path)
+{
+#define onexit http_hub_delete((*deck)->hub); free((*deck)->path); free(*deck);
+	*deck = malloc(sizeof(struct deck_t));
+	(*deck)->path = strdup(path);
+	(*deck)->lock = sys_mutex_init(0);
+	(*deck)->hub = http_hub_new();
+	(*deck)->version = 0;
+	(*deck)->pinning = 0;
+	(*deck)->check = sys_utime();
+	(*deck)->db = NULL;
+	chkfail(deck_load(*deck));
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Close a deck. Pinned versions remain valid until closed.
+ *   @deck: The deck.
+ */
+void deck_close(struct deck_t *deck)
+{
+	db_close(deck->db);
+	http_hub_delete(deck->hub);
+	sys_mutex_destroy(&deck->lock);
+	free(deck->path);
+	free(deck);
+}
+
+
+/**
+ * Pin the current version of the deck. The returned database is immutable
+ * and must be released with 'db_close'. The file is checked for outside
+ * changes at most once a second by a single caller, and reloaded if changed.
+ *   @deck: The deck.
+ *   &returns: The database.
+ */
+struct db_t *deck_pin(struct deck_t *deck)
+{
+	int64_t now;
+	struct db_t *db;
+
+	now = sys_utime();
+	if(((now - __atomic_load_n(&deck->check, __ATOMIC_RELAXED)) >= CHECK) && sys_mutex_trylock(&deck->lock)) {
+		if((now - deck->check) >= CHECK) {
+			__atomic_store_n(&deck->check, now, __ATOMIC_RELAXED);
+
+			if(deck_mtime(deck->path) != deck->mtime)
+				chkwarn(deck_load(deck));
+		}
+
+		sys_mutex_unlock(&deck->lock);
+	}
+
+	__atomic_add_fetch(&deck->pinning, 1, __ATOMIC_SEQ_CST);
+	db = db_ref(__atomic_load_n(&deck->db, __ATOMIC_SEQ_CST));
+	__atomic_sub_fetch(&deck->pinning, 1, __ATOMIC_SEQ_CST);
+
+	return db;
+}
+/**
+ * Retrieve the hub of a deck, signaled each time a new version is
+ * published.
+ *   @deck: The deck.
+ *   &returns: The hub.
+ */
+struct http_hub_t *deck_hub(struct deck_t *deck)
+{
+	return deck->hub;
+}
+
+/**
+ * Retrieve the version number of a deck, incremented each time a new
+ * version is published.
+ *   @deck: The deck.
+ *   &returns: The version number.
+ */
+unsigned int deck_version(struct deck_t *deck)
+{
+	return __atomic_load_n(&deck->version, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Update an entry in the deck, saving and publishing a new version. A
+ * suspended entry is only loaded and moved into the hot segment if the
+ * update brings it out of suspension.
+ *   @deck: The deck.
+ *   @id: The entry identifier.
+ *   @func: The update function.
+ *   &returns: True if updated, false if no such entry.
+ */
+bool deck_update(struct deck_t *deck, unsigned int id, deck_update_f func)
+{
+	struct db_t *db;
+	struct db_entry_t *entry;
+
+	sys_mutex_lock(&deck->lock);
+
+	if(deck_mtime(deck->path) != deck->mtime)
+		chkwarn(deck_load(deck));
+
+	entry = db_lookup(deck->db, id);
+	if(entry == NULL) {
+		sys_mutex_unlock(&deck->lock);
+		return false;
+	}
+
+	if(db_entry_iscold(entry)) {
+		entry = db_entry_load(entry);
+		func(entry);
+
+		if(entry->score > 5) {
+			db_entry_release(entry);
+			sys_mutex_unlock(&deck->lock);
+			return true;
+		}
+
+		db = db_insert(deck->db, entry);
+	}
+	else {
+		entry = db_entry_copy(entry);
+		func(entry);
+
+		db = db_replace(deck->db, entry);
+	}
+
+	db_save(db, deck->path);
+	deck->mtime = deck_mtime(deck->path);
+	deck_publish(deck, db);
+
+	sys_mutex_unlock(&deck->lock);
+
+	return true;
+}
+
+
+/**
+ * Load the database from disk and publish it. The modification time is
+ * recorded even if the file fails to load, so that a broken file is only
+ * loaded again once it changes. The writer lock must be held if the deck is
+ * shared.
+ *   @deck: The deck.
+ *   &returns: Error.
+ */
+static char *deck_load(struct deck_t *deck)
+{
+#define onexit
+	struct db_t *db;
+
+	deck->mtime = deck_mtime(deck->path);
+	chkfail(db_open(&db, deck->path));
+
+	deck_publish(deck, db);
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Publish a new version of the database and signal the hub. The previous
+ * version is released once no reader can still be pinning it; readers that
+ * already pinned it keep their own reference.
+ *   @deck: The deck.
+ *   @db: Consumed. The new database.
+ */
+static void deck_publish(struct deck_t *deck, struct db_t *db)
+{
+	struct db_t *old;
+
+	old = __atomic_exchange_n(&deck->db, db, __ATOMIC_SEQ_CST);
+	sys_thread_drain(&deck->pinning);
+
+	if(old != NULL)
+		db_close(old);
+
+	__atomic_add_fetch(&deck->version, 1, __ATOMIC_RELEASE);
+	http_hub_signal(deck->hub);
+}
+
+/**
+ * Retrieve the modification time of a file.
+ *   @path: The path.
+ *   &returns: The time in nanoseconds, or negative if unavailable.
+ */
+static int64_t deck_mtime(const char *path)
+{
+	struct stat info;
+
+	if(stat(path, &info) < 0)
+		return -1;
+
+	return asset_mtime(&info);
+}
@@ -0,0 +1,26 @@
+#ifndef DECK_H
+#define DECK_H
+
+/*
+ * structure prototypes
+ */
+struct deck_t;
+
+/**
+ * Entry update callback.
+ *   @entry: The private entry copy to modify.
+ */
+typedef void (*deck_update_f)(struct db_entry_t *entry);
+
+/*
+ * deck declarations
+ */
+char *deck_open(struct deck_t **deck, const char *path);
+void deck_close(struct deck_t *deck);
+
+struct db_t *deck_pin(struct deck_t *deck);
+struct http_hub_t *deck_hub(struct deck_t *deck);
+unsigned int deck_version(struct deck_t *deck);
+bool deck_update(struct deck_t *deck, unsigned int id, deck_update_f func);
+
+#endif
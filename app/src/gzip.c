@@ -0,0 +1,140 @@
+#include "common.h"
+#include <zlib.h>
+
+
+/**
+ * Compressor structure.
+ *   @strm: The deflate stream.
+ *   @out: The output file.
+ */
+struct gzip_t {
+	z_stream strm;
+	struct io_file_t out;
+};
+
+
+/*
+ * local declarations
+ */
+static void gzip_proc(struct gzip_t *gzip, const void *buf, size_t nbytes, int flush);
+
+static size_t gzip_read(void *ref, void *buf, size_t nbytes);
+static size_t gzip_write(void *ref, const void *buf, size_t nbytes);
+static void gzip_close(void *ref);
+
+
+/**
+ * Create a gzip compressor writing to an output file.
+ *   @out: The output file.
+ *   @level: The compression level, trading CPU for size.
+ *   &returns: The compressor.
+ */
+struct gzip_t *gzip_new(struct io_file_t out, int level)
+{
+	struct gzip_t *gzip;
+
+	gzip = malloc(sizeof(struct gzip_t));
+	gzip->strm.zalloc = Z_NULL;
+	gzip->strm.zfree = Z_NULL;
+	gzip->strm.opaque = Z_NULL;
+	gzip->out = out;
+
+	if(deflateInit2(&gzip->strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		fatal("Failed to initialize compressor.");
+
+	return gzip;
+}
+
+/**
+ * Delete a gzip compressor.
+ *   @gzip: The compressor.
+ */
+void gzip_delete(struct gzip_t *gzip)
+{
+	deflateEnd(&gzip->strm);
+	free(gzip);
+}
+
+
+/**
+ * Retrieve the file that compresses into the compressor output.
+ *   @gzip: The compressor.
+ *   &returns: The file.
+ */
+struct io_file_t gzip_file(struct gzip_t *gzip)
+{
+	static const struct io_file_i iface = { gzip_read, gzip_write, gzip_close };
+
+	return (struct io_file_t){ gzip, &iface };
+}
+
+/**
+ * Finish the compressed stream, writing all remaining output.
+ *   @gzip: The compressor.
+ */
+void gzip_finish(struct gzip_t *gzip)
+{
+	gzip_proc(gzip, NULL, 0, Z_FINISH);
+}
+
+
+/**
+ * Compress data into the output file.
+ *   @gzip: The compressor.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   @flush: The deflate flush mode.
+ */
+static void gzip_proc(struct gzip_t *gzip, const void *buf, size_t nbytes, int flush)
+{
+	int ret;
+	uint8_t out[16*1024];
+
+	gzip->strm.next_in = (Bytef *)buf;
+	gzip->strm.avail_in = nbytes;
+
+	do {
+		gzip->strm.next_out = out;
+		gzip->strm.avail_out = sizeof(out);
+
+		ret = deflate(&gzip->strm, flush);
+		if(ret == Z_STREAM_ERROR)
+			fatal("Failed to compress data.");
+
+		io_file_write(gzip->out, out, sizeof(out) - gzip->strm.avail_out);
+	} while((gzip->strm.avail_out == 0) || ((flush == Z_FINISH) && (ret != Z_STREAM_END)));
+}
+
+/**
+ * Read from the compressor, which is unsupported.
+ *   @ref: The compressor.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   &returns: Always zero.
+ */
+static size_t gzip_read(void *ref, void *buf, size_t nbytes)
+{
+	return 0;
+}
+
+/**
+ * Write to the compressor.
+ *   @ref: The compressor.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   &returns: The number of bytes written.
+ */
+static size_t gzip_write(void *ref, const void *buf, size_t nbytes)
+{
+	gzip_proc(ref, buf, nbytes, Z_NO_FLUSH);
+
+	return nbytes;
+}
+
+/**
+ * Close the compressor file, which is a no-op.
+ *   @ref: The compressor.
+ */
+static void gzip_close(void *ref)
+{
+}
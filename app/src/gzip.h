@@ -0,0 +1,24 @@
+#ifndef GZIP_H
+#define GZIP_H
+
+/*
+ * gzip definitions
+ */
+#define GZIP_FAST	1
+#define GZIP_BEST	9
+
+/*
+ * structure prototypes
+ */
+struct gzip_t;
+
+/*
+ * gzip declarations
+ */
+struct gzip_t *gzip_new(struct io_file_t out, int level);
+void gzip_delete(struct gzip_t *gzip);
+
+struct io_file_t gzip_file(struct gzip_t *gzip);
+void gzip_finish(struct gzip_t *gzip);
+
+#endif
@@ -0,0 +1,9 @@
+#include "defs.h"
+#include "main.h"
+#include "asset.h"
+#include "conf.h"
+#include "db.h"
+#include "deck.h"
+#include "gzip.h"
+#include "intern.h"
+#include "media.h"
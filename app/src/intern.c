@@ -0,0 +1,147 @@
+#include "common.h"
+
+
+/**
+ * Interned string structure.
+ *   @refcnt: The reference count.
+ *   @hash: The hash value.
+ *   @len: The string length.
+ *   @next: The next string in the bucket.
+ *   @str: The string.
+ */
+struct intern_t {
+	unsigned int refcnt;
+	uint32_t hash;
+	size_t len;
+	struct intern_t *next;
+
+	char str[];
+};
+
+
+/*
+ * local declarations
+ */
+static void intern_grow(void);
+
+/*
+ * local variables
+ */
+static struct intern_t **table = NULL;
+static unsigned int cnt = 0, size = 0;
+static sys_mutex_t lock = { SYS_MUTEX_INIT };
+
+
+/**
+ * Retrieve the interned copy of a string, adding a reference. Identical
+ * strings share the same storage and can be compared by pointer.
+ *   @str: The string.
+ *   @len: The string length.
+ *   &returns: The interned string.
+ */
+const char *intern_get(const char *str, size_t len)
+{
+	uint32_t hash;
+	struct intern_t **ref, *intern;
+
+	hash = hash_fnv32(HASH_FNV32, str, len);
+	sys_mutex_lock(&lock);
+
+	if(cnt >= size)
+		intern_grow();
+
+	for(ref = &table[hash & (size - 1)]; *ref != NULL; ref = &(*ref)->next) {
+		if(((*ref)->hash == hash) && ((*ref)->len == len) && (memcmp((*ref)->str, str, len) == 0)) {
+			(*ref)->refcnt++;
+			sys_mutex_unlock(&lock);
+
+			return (*ref)->str;
+		}
+	}
+
+	intern = malloc(sizeof(struct intern_t) + len + 1);
+	intern->refcnt = 1;
+	intern->hash = hash;
+	intern->len = len;
+	intern->next = NULL;
+	memcpy(intern->str, str, len);
+	intern->str[len] = '\0';
+
+	*ref = intern;
+	cnt++;
+	sys_mutex_unlock(&lock);
+
+	return intern->str;
+}
+
+/**
+ * Add a reference to an interned string.
+ *   @str: The interned string.
+ *   &returns: The interned string.
+ */
+const char *intern_ref(const char *str)
+{
+	sys_mutex_lock(&lock);
+	getparent(str, struct intern_t, str)->refcnt++;
+	sys_mutex_unlock(&lock);
+
+	return str;
+}
+
+/**
+ * Release a reference to an interned string, freeing it on the last
+ * reference.
+ *   @str: The interned string.
+ */
+void intern_put(const char *str)
+{
+	struct intern_t **ref, *intern = getparent(str, struct intern_t, str);
+
+	sys_mutex_lock(&lock);
+
+	if(--intern->refcnt > 0) {
+		sys_mutex_unlock(&lock);
+		return;
+	}
+
+	for(ref = &table[intern->hash & (size - 1)]; *ref != intern; ref = &(*ref)->next)
+		assert(*ref != NULL);
+
+	*ref = intern->next;
+	free(intern);
+
+	if(--cnt == 0) {
+		free(table);
+		table = NULL;
+		size = 0;
+	}
+
+	sys_mutex_unlock(&lock);
+}
+
+
+/**
+ * Double the size of the table, rehashing all strings.
+ */
+static void intern_grow(void)
+{
+	unsigned int i, len;
+	struct intern_t **arr, *cur, *next;
+
+	len = size ? (2 * size) : 256;
+	arr = malloc(len * sizeof(struct intern_t *));
+	for(i = 0; i < len; i++)
+		arr[i] = NULL;
+
+	for(i = 0; i < size; i++) {
+		for(cur = table[i]; cur != NULL; cur = next) {
+			next = cur->next;
+			cur->next = arr[cur->hash & (len - 1)];
+			arr[cur->hash & (len - 1)] = cur;
+		}
+	}
+
+	erase(table);
+	table = arr;
+	size = len;
+}
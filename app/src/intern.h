@@ -0,0 +1,11 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+/*
+ * intern declarations
+ */
+const char *intern_get(const char *str, size_t len);
+const char *intern_ref(const char *str);
+void intern_put(const char *str);
+
+#endif
@@ -1,42 +1,91 @@
 #include "common.h"
+#include <fcntl.h>
+#include <sys/stat.h>
 
 
 /**
- * File structure.
- *   @req, path, type: The request path, file path, and content-type.
+ * Listing stream structure.
+ *   @conf: The configuration.
+ *   @db: The pinned database.
+ *   @idx: The next slot.
+ *   @sep: The separator flag.
+ *   @gzip: The compressor, null if uncompressed.
  */
-struct file_t {
-	const char *req, *path, *type;
+struct list_t {
+	struct conf_t *conf;
+	struct db_t *db;
+	unsigned int idx;
+	bool sep;
+
+	struct gzip_t *gzip;
+};
+
+/**
+ * Review socket structure.
+ *   @conf: The configuration.
+ *   @deck: The deck.
+ */
+struct review_t {
+	struct conf_t *conf;
+	struct deck_t *deck;
 };
 
 /**
- * Database mapping.
- *   @id, path: The identifier and path.
+ * Event stream structure.
+ *   @deck: The deck.
+ *   @version: The deck version last reported.
+ *   @ready: The flag last reported, set if a card was due.
  */
-struct map_t {
-	const char *id, *path;
+struct events_t {
+	struct deck_t *deck;
+	unsigned int version;
+	bool ready;
 };
 
 
 /*
  * local declarations
  */
-static bool serv_req(const char *path, struct http_args_t *args, void *arg);
-static void serv_send(struct http_args_t *args, const char *path);
-
-static struct file_t filelist[] = {
-	{ "/code.js",   "share/code.js",   "application/javascript" },
-	{ "/list.js",   "share/list.js",   "application/javascript" },
-	{ "/gui.js",    "share/gui.js",    "application/javascript" },
-	{ "/style.css", "share/style.css", "text/css" },
-	{ NULL,         NULL,            NULL }
-};
-
-static struct map_t maplist[] = {
-	{ "eng",   "db/eng" },
-	{ "hir",   "db/hir" },
-	{ "audio", "db/audio" },
-	{ "kanji", "db/kanji" },
+static bool serv_file(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_page(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_debug(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_mp3(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_hashed(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_media(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_check(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_all(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_rand(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_update(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_events(struct http_args_t *args, const struct http_param_t *param, void *arg);
+static bool serv_review(struct http_args_t *args, const struct http_param_t *param, void *arg);
+
+static void serv_asset(struct http_args_t *args, struct asset_data_t *data, const char *type, const char *cache);
+static bool serv_send(struct http_args_t *args, const char *path, const char *type, const char *cache);
+static void serv_entry(struct io_file_t file, struct conf_t *conf, struct db_entry_t *entry);
+static deck_update_f serv_action(const struct http_param_t *param);
+static bool serv_hash(const struct http_param_t *param, uint64_t *hash);
+
+static bool list_stream(struct io_file_t file, void *arg);
+static void list_delete(void *arg);
+static int64_t events_push(struct io_file_t file, void *arg);
+static void events_send(struct io_file_t file, const char *name, uint64_t due, uint64_t now);
+static bool review_msg(struct io_file_t file, const char *data, size_t len, void *arg);
+static bool review_num(const char **str, unsigned int *num);
+static void fd_close(void *arg);
+
+static struct conf_handler_t handlers[] = {
+	{ "file",   serv_file },
+	{ "page",   serv_page },
+	{ "debug",  serv_debug },
+	{ "mp3",    serv_mp3 },
+	{ "hashed", serv_hashed },
+	{ "media",  serv_media },
+	{ "check",  serv_check },
+	{ "all",    serv_all },
+	{ "rand",   serv_rand },
+	{ "update", serv_update },
+	{ "events", serv_events },
+	{ "review", serv_review },
 	{ NULL,     NULL }
 };
 
@@ -48,26 +97,24 @@ static struct map_t maplist[] = {
  */
 int main(int argc, char **argv)
 {
+	struct conf_t *cfg;
+	struct http_conf_t conf;
 	struct http_server_t *serv;
 
 	srand(sys_utime());
+	signal(SIGPIPE, SIG_IGN);
 
-	chkabort(http_server_open(&serv, 8080));
-
-	while(true) {
-		unsigned int n = http_server_poll(serv, NULL);
-		struct sys_poll_t set[n+1];
-
-		set[n] = sys_poll_fd(STDIN_FILENO, POLLIN);
-		http_server_poll(serv, set);
+	chkabort(conf_load(&cfg, (argc > 1) ? argv[1] : "learn.conf", handlers));
 
-		sys_poll(set, n+1, -1);
+	conf = http_conf_init();
+	conf.threads = cfg->threads;
+	if(conf.threads == 0)
+		conf.threads = (sysconf(_SC_NPROCESSORS_ONLN) > 0) ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
 
-		if(set[n].revents)
-			break;
+	conf.workers = cfg->workers;
 
-		http_server_proc(serv, set, serv_req, NULL);
-	}
+	chkabort(http_server_open(&serv, 8080, &conf));
+	http_server_start(serv, http_router_proc, cfg->router);
 
 	while(true) {
 		int ch = fgetc(stdin);
@@ -76,6 +123,7 @@ int main(int argc, char **argv)
 	}
 
 	http_server_close(serv);
+	conf_delete(cfg);
 
 	if(hax_memcnt != 0)
 		fprintf(stderr, "Missing %d allocation.\n", hax_memcnt);
@@ -83,186 +131,672 @@ int main(int argc, char **argv)
 	return 0;
 }
 
+
 /**
- * Handle a server request.
- *   @path: The path.
+ * Serve a configured file from memory, with pages rewritten to refer to
+ * content-addressed URLs.
  *   @args: The arguments.
- *   @arg: The argument.
+ *   @param: The route parameters.
+ *   @arg: The file configuration.
  *   &returns: True if handled, false if unhandled.
  */
-static bool serv_req(const char *path, struct http_args_t *args, void *arg)
+static bool serv_file(struct http_args_t *args, const struct http_param_t *param, void *arg)
 {
-	char name[32], deck[16], act[8];
-	unsigned int n = 0, id;
-	struct file_t *file;
+	struct conf_file_t *file = arg;
+
+	serv_asset(args, conf_asset(file->conf, file), file->type, "no-cache");
+
+	return true;
+}
 
-	if(path[0] != '/')
+/**
+ * Serve a configured file for a deck, given by the first parameter.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The file configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_page(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	struct conf_file_t *file = arg;
+
+	if(conf_deck(file->conf, &param[0]) == NULL)
 		return false;
 
-	for(file = filelist; file->req != NULL; file++) {
-		if(strcmp(file->req, path) == 0)
-			break;
-	}
+	return serv_file(args, param, arg);
+}
 
-	if(file->req != NULL) {
-		serv_send(args, file->path);
-		http_head_add(&args->resp, "Content-Type", file->type);
+/**
+ * Serve the debug page.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_debug(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	hprintf(args->file, "Debug");
+	http_head_add(&args->resp, "Content-Type", "text/plaintext");
+
+	return true;
+}
+
+/**
+ * Serve an audio file by name, sent directly from the file and honoring
+ * byte ranges for seeking.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_mp3(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	size_t i;
+	char mp3[64];
+
+	if(param[0].len > 31)
+		return false;
+
+	for(i = 0; i < param[0].len; i++) {
+		if(((param[0].str[i] < 'a') || (param[0].str[i] > 'z')) && (param[0].str[i] != '-') && (param[0].str[i] != '_'))
+			return false;
 	}
-	else if(strcmp(path, "/debug") == 0) {
-		hprintf(args->file, "Debug");
-		http_head_add(&args->resp, "Content-Type", "text/plaintext");
+
+	sprintf(mp3, "db/mp3/%.*s.mp3", (int)param[0].len, param[0].str);
+
+	return serv_send(args, mp3, "audio/mpeg", NULL);
+}
+
+/**
+ * Serve a file by content hash from memory, allowing it to be cached
+ * indefinitely.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_hashed(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	uint64_t hash;
+	struct conf_file_t *file;
+	struct asset_data_t *data;
+
+	if(!serv_hash(&param[0], &hash))
+		return false;
+
+	file = conf_hashed(arg, hash, &data);
+	if(file == NULL)
+		return false;
+
+	serv_asset(args, data, file->type, ASSET_CACHE);
+
+	return true;
+}
+
+/**
+ * Serve an audio file by content hash, allowing it to be cached
+ * indefinitely. The file is opened and possibly rehashed from disk.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_media(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	int fd;
+	uint64_t hash, size;
+	struct conf_t *conf = arg;
+
+	if((conf->media == NULL) || !serv_hash(&param[0], &hash))
+		return false;
+
+	fd = media_file(conf->media, hash, &size);
+	if(fd < 0)
+		return false;
+
+	http_head_add(&args->resp, "Content-Type", "audio/mpeg");
+	http_head_add(&args->resp, "Cache-Control", ASSET_CACHE);
+	http_args_file(args, fd, size, fd_close, (void *)(intptr_t)fd);
+
+	return true;
+}
+
+/**
+ * Check a deck for missing audio files.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_check(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	unsigned int i;
+	struct db_t *db;
+	struct deck_t *deck;
+
+	deck = conf_deck(arg, &param[0]);
+	if(deck == NULL)
+		return false;
+
+	http_head_add(&args->resp, "Content-Type", "text/plaintext;charset=utf-8");
+	http_args_chunked(args);
+
+	db = deck_pin(deck);
+
+	for(i = 0; i < db->hot.cnt + db->cold.cnt; i++) {
+		struct db_entry_t *entry, *load = NULL;
+
+		if(i < db->hot.cnt)
+			entry = db_get(db, i);
+		else if((entry = db_cold(db, i - db->hot.cnt)) != NULL)
+			entry = load = db_entry_load(entry);
+
+		if(entry != NULL) {
+			char path[strlen(entry->audio) + 10];
+
+			sprintf(path, "db/mp3/%s", entry->audio);
+			if(access(path, F_OK) != 0)
+				hprintf(args->file, "%u,%s: missing audio (%s)\n", entry->id, entry->eng, path);
+		}
+
+		if(load != NULL)
+			db_entry_release(load);
 	}
-	else if(sscanf(path, "/mp3/%31[a-z-_].mp3%n", name, &n) == 1) {
-		char mp3[64];
 
-		if(path[n] != '\0')
-			return false;
+	db_close(db);
 
-		sprintf(mp3, "db/mp3/%s.mp3", name);
-		if(access(mp3, F_OK) != 0)
-			return false;
+	hprintf(args->file, "done\n");
+
+	return true;
+}
+
+/**
+ * List all active entries of a deck.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_all(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	struct list_t *list;
+	struct deck_t *deck;
+
+	deck = conf_deck(arg, &param[0]);
+	if(deck == NULL)
+		return false;
+
+	list = malloc(sizeof(struct list_t));
+	list->conf = arg;
+	list->db = deck_pin(deck);
+	list->idx = 0;
+	list->sep = false;
+	list->gzip = NULL;
+
+	http_head_add(&args->resp, "Content-Type", "application/json;charset=utf-8");
+	http_head_add(&args->resp, "Vary", "Accept-Encoding");
 
-		serv_send(args, mp3);
-		http_head_add(&args->resp, "Content-Type", "audio/mpeg");
+	if(http_head_accepts(&args->req, "gzip")) {
+		http_head_add(&args->resp, "Content-Encoding", "gzip");
+		list->gzip = gzip_new(args->file, GZIP_FAST);
 	}
-	else if(sscanf(path, "/%15[a-z]%n", deck, &n) == 1) {
-		struct map_t *map;
-		struct db_t *db;
 
-		for(map = maplist; map->id != NULL; map++) {
-			if(strcmp(map->id, deck) == 0)
-				break;
-		}
+	http_args_stream(args, list_stream, list, list_delete);
+	hprintf(list->gzip ? gzip_file(list->gzip) : args->file, "[");
 
-		if(map->id == NULL)
-			return false;
+	return true;
+}
 
-		path += n;
+/**
+ * Select a random entry from a deck.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_rand(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	struct db_t *db;
+	struct deck_t *deck;
+	struct db_entry_t *entry;
 
-		if(path[0] == '\0') {
-			serv_send(args, "share/index.xhtml");
-			http_head_add(&args->resp, "Content-Type", "application/xhtml+xml");
-		}
-		else if(strcmp(path, "/list") == 0) {
-			serv_send(args, "share/list.xhtml");
-			http_head_add(&args->resp, "Content-Type", "application/xhtml+xml");
-		}
-		else if(strcmp(path, "/check") == 0) {
-			char *err;
+	deck = conf_deck(arg, &param[0]);
+	if(deck == NULL)
+		return false;
 
-			http_head_add(&args->resp, "Content-Type", "text/plaintext;charset=utf-8");
+	db = deck_pin(deck);
+	entry = db_rand(db);
 
-			err = db_open(&db, map->path);
-			if(err == NULL) {
-				struct db_entry_t *entry;
+	serv_entry(args->file, arg, entry);
+	http_head_add(&args->resp, "Content-Type", "application/json;charset=utf-8");
 
-				for(entry = db->entry; entry != NULL; entry = entry->next) {
-					char path[strlen(entry->audio) + 10];
+	db_close(db);
 
-					sprintf(path, "db/mp3/%s", entry->audio);
-					if(access(path, F_OK) != 0)
-						hprintf(args->file, "%u,%s: missing audio (%s)\n", entry->id, entry->eng, path);
-				}
+	return true;
+}
 
-				db_close(db);
-			}
+/**
+ * Update an entry of a deck.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_update(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	struct deck_t *deck;
+	deck_update_f func;
 
-			hprintf(args->file, "done\n");
-		}
-		else if(strcmp(path, "/all") == 0) {
-			bool sep = false;
-			struct db_entry_t *entry;
+	deck = conf_deck(arg, &param[0]);
+	if((deck == NULL) || (param[2].num >= DB_NOID))
+		return false;
 
-			chkabort(db_open(&db, map->path));
+	func = serv_action(&param[1]);
+	if(func == NULL)
+		return false;
 
-			hprintf(args->file, "[");
-			for(entry = db->entry; entry != NULL; entry = entry->next) {
-				if(entry->score == 255)
-					continue;
+	if(!deck_update(deck, param[2].num, func))
+		return false;
 
-				if(sep)
-					hprintf(args->file, ",");
+	hprintf(args->file, "ok");
+	http_head_add(&args->resp, "Content-Type", "text/plaintext;charset=utf-8");
 
-				sep = true;
-				hprintf(args->file, "{\"id\":%u,\"score\":%u,\"time\":%lu,\"eng\":\"%s\",\"rom\":\"%s\",\"hir\":\"%s\",\"kanji\":\"%s\",\"audio\":\"%s\"}", entry->id, entry->score, entry->time, entry->eng, entry->rom, entry->hir, entry->kanji, entry->audio);
-			}
-			hprintf(args->file, "]");
+	return true;
+}
 
-			db_close(db);
-			http_head_add(&args->resp, "Content-Type", "application/json;charset=utf-8");
-		}
-		else if(strcmp(path, "/rand") == 0) {
-			struct db_entry_t *entry;
+/**
+ * Stream the due state of a deck as server-sent events. An 'update' event
+ * is sent whenever a new version of the deck is published, and a 'due'
+ * event once the next card becomes due; between events, the connection is
+ * parked without any timer or polling except the alarm for the next card.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_events(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	struct deck_t *deck;
+	struct events_t *events;
 
-			chkabort(db_open(&db, map->path));
-			entry = db_rand(db);
+	deck = conf_deck(arg, &param[0]);
+	if(deck == NULL)
+		return false;
 
-			hprintf(args->file, "{\"id\":%u,\"score\":%u,\"time\":%lu,\"eng\":\"%s\",\"rom\":\"%s\",\"hir\":\"%s\",\"kanji\":\"%s\",\"audio\":\"%s\"}", entry->id, entry->score, entry->time, entry->eng, entry->rom, entry->hir, entry->kanji, entry->audio);
-			http_head_add(&args->resp, "Content-Type", "application/json;charset=utf-8");
+	events = malloc(sizeof(struct events_t));
+	events->deck = deck;
+	events->version = deck_version(deck) - 1;
+	events->ready = false;
 
-			db_close(db);
-		}
-		else if((sscanf(path, "/%7[a-z]/%u%n", act, &id, &n) == 2) && (path[n] == '\0')) {
-			struct db_entry_t *entry;
-			void (*func)(struct db_entry_t *);
-
-			if(strcmp(act, "inc") == 0)
-				func = db_entry_inc;
-			else if(strcmp(act, "dec") == 0)
-				func = db_entry_dec;
-			else if(strcmp(act, "zero") == 0)
-				func = db_entry_zero;
-			else if(strcmp(act, "reset") == 0)
-				func = db_entry_reset;
-			else
-				return false;
-
-			chkabort(db_open(&db, map->path));
-
-			entry = db_get(db, id);
-			if(entry != NULL)
-				func(entry);
-
-			db_save(db, map->path);
-			db_close(db);
-
-			if(entry == NULL)
-				return false;
-
-			hprintf(args->file, "ok", act, id, deck);
-			http_head_add(&args->resp, "Content-Type", "text/plaintext;charset=utf-8");
-		}
-		else
-			return false;
+	if(!http_args_push(args, deck_hub(deck), events_push, events, free)) {
+		free(events);
+		return false;
 	}
-	else
+
+	http_head_add(&args->resp, "Content-Type", "text/event-stream;charset=utf-8");
+	http_head_add(&args->resp, "Cache-Control", "no-cache");
+
+	return true;
+}
+
+/**
+ * Review a deck over a WebSocket. Each message grades a card and is
+ * answered with the next due cards, so that a review step takes a single
+ * frame exchange instead of a grade and a selection request.
+ *   @args: The arguments.
+ *   @param: The route parameters.
+ *   @arg: The configuration.
+ *   &returns: True if handled, false if unhandled.
+ */
+static bool serv_review(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	struct deck_t *deck;
+	struct review_t *review;
+
+	deck = conf_deck(arg, &param[0]);
+	if(deck == NULL)
 		return false;
 
+	review = malloc(sizeof(struct review_t));
+	review->conf = arg;
+	review->deck = deck;
+
+	if(!http_args_websock(args, review_msg, review, free)) {
+		free(review);
+		return false;
+	}
+
 	return true;
 }
 
+
 /**
- * Send a file.
+ * Send asset contents, compressed if accepted, or confirm that the client
+ * copy is current.
+ *   @args: The arguments.
+ *   @data: Consumed. The contents.
+ *   @type: The content-type.
+ *   @cache: The cache control.
+ */
+static void serv_asset(struct http_args_t *args, struct asset_data_t *data, const char *type, const char *cache)
+{
+	bool zip;
+	const char *tags;
+
+	zip = (data->zip != NULL) && http_head_accepts(&args->req, "gzip");
+
+	http_head_add(&args->resp, "ETag", zip ? data->ztag : data->etag);
+	http_head_add(&args->resp, "Cache-Control", cache);
+	if(data->zip != NULL)
+		http_head_add(&args->resp, "Vary", "Accept-Encoding");
+
+	tags = http_head_known(&args->req, http_if_none_match_e);
+	if((tags != NULL) && http_etag_match(tags, zip ? data->ztag : data->etag)) {
+		http_args_status(args, 304);
+		asset_release(data);
+	}
+	else if(zip) {
+		http_head_add(&args->resp, "Content-Type", type);
+		http_head_add(&args->resp, "Content-Encoding", "gzip");
+		http_args_ref(args, data->zip, data->nzip, asset_release, data);
+	}
+	else {
+		http_head_add(&args->resp, "Content-Type", type);
+		http_args_ref(args, data->buf, data->len, asset_release, data);
+	}
+}
+
+/**
+ * Send a file directly from disk, honoring byte ranges for seeking.
  *   @args: The arguments.
  *   @path: The path.
+ *   @type: The content-type.
+ *   @cache: Optional. The cache control.
+ *   &returns: True if sent, false if the file cannot be opened.
  */
-static void serv_send(struct http_args_t *args, const char *path)
+static bool serv_send(struct http_args_t *args, const char *path, const char *type, const char *cache)
 {
-	FILE *file;
-	ssize_t rd;
-	uint8_t buf[32*1024];
+	int fd;
+	struct stat info;
 
-	file = fopen(path, "r");
-	if(file == NULL)
-		fatal("Missing file '%s'.", path);
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return false;
+
+	if(fstat(fd, &info) < 0)
+		fatal("Failure to stat '%s'. %s.", path, strerror(errno));
+
+	http_head_add(&args->resp, "Content-Type", type);
+	if(cache != NULL)
+		http_head_add(&args->resp, "Cache-Control", cache);
 
-	while(!feof(file)) {
-		rd = fread(buf, 1, sizeof(buf), file);
-		if((rd < 0) || ((rd == 0) && !feof(file)))
-			fatal("Failure to read from '%s'.", path);
+	http_args_file(args, fd, info.st_size, fd_close, (void *)(intptr_t)fd);
 
-		io_file_write(args->file, buf, rd);
+	return true;
+}
+
+/**
+ * Write an entry as JSON. The 'src' field holds the content-addressed URL
+ * of the audio if indexed, and the URL by name otherwise.
+ *   @file: The output file.
+ *   @conf: The configuration.
+ *   @entry: Optional. The entry, written as null if none.
+ */
+static void serv_entry(struct io_file_t file, struct conf_t *conf, struct db_entry_t *entry)
+{
+	const char *url;
+
+	if(entry == NULL) {
+		hprintf(file, "null");
+		return;
 	}
 
-	fclose(file);
+	url = conf->media ? media_url(conf->media, entry->audio) : NULL;
+	hprintf(file, "{\"id\":%u,\"score\":%u,\"time\":%lu,\"eng\":\"%s\",\"rom\":\"%s\",\"hir\":\"%s\",\"kanji\":\"%s\",\"audio\":\"%s\",", entry->id, entry->score, entry->time, entry->eng, entry->rom, entry->hir, entry->kanji, entry->audio);
+
+	if(url != NULL)
+		hprintf(file, "\"src\":\"%s\"}", url);
+	else
+		hprintf(file, "\"src\":\"/mp3/%s\"}", entry->audio);
+}
+
+/**
+ * Retrieve the update function of an action.
+ *   @param: The action parameter.
+ *   &returns: The update function, or null if unknown.
+ */
+static deck_update_f serv_action(const struct http_param_t *param)
+{
+	if(http_param_eq(param, "inc"))
+		return db_entry_inc;
+	else if(http_param_eq(param, "dec"))
+		return db_entry_dec;
+	else if(http_param_eq(param, "zero"))
+		return db_entry_zero;
+	else if(http_param_eq(param, "reset"))
+		return db_entry_reset;
+	else
+		return NULL;
+}
+
+/**
+ * Parse a content hash route parameter.
+ *   @param: The parameter.
+ *   @hash: Out. The hash.
+ *   &returns: True if a valid hash.
+ */
+static bool serv_hash(const struct http_param_t *param, uint64_t *hash)
+{
+	char *end;
+
+	if((param->len != 16) || !isxdigit((unsigned char)param->str[0]))
+		return false;
+
+	*hash = strtoull(param->str, &end, 16);
+
+	return end == param->str + 16;
+}
+
+
+/**
+ * Stream the next part of a listing, compressed if requested.
+ *   @file: The output file.
+ *   @arg: The listing.
+ *   &returns: True if more remains.
+ */
+static bool list_stream(struct io_file_t file, void *arg)
+{
+	unsigned int n;
+	struct list_t *list = arg;
+	struct db_entry_t *entry;
+
+	if(list->gzip != NULL)
+		file = gzip_file(list->gzip);
+
+	for(n = 0; (n < 256) && (list->idx < list->db->hot.cnt); n++) {
+		entry = db_get(list->db, list->idx++);
+		if(entry == NULL)
+			continue;
+
+		if(list->sep)
+			hprintf(file, ",");
+
+		list->sep = true;
+		serv_entry(file, list->conf, entry);
+	}
+
+	if(list->idx < list->db->hot.cnt)
+		return true;
+
+	hprintf(file, "]");
+
+	if(list->gzip != NULL)
+		gzip_finish(list->gzip);
+
+	return false;
+}
+
+/**
+ * Delete a listing, unpinning its database.
+ *   @arg: The listing.
+ */
+static void list_delete(void *arg)
+{
+	struct list_t *list = arg;
+
+	if(list->gzip != NULL)
+		gzip_delete(list->gzip);
+
+	db_close(list->db);
+	free(list);
+}
+
+/**
+ * Push the events of a deck that changed since the last push, arming the
+ * alarm for the next card to become due.
+ *   @file: The output file.
+ *   @arg: The event stream.
+ *   &returns: The alarm time, zero if none.
+ */
+static int64_t events_push(struct io_file_t file, void *arg)
+{
+	struct db_t *db;
+	uint64_t due, now;
+	unsigned int version;
+	struct events_t *events = arg;
+
+	version = deck_version(events->deck);
+	db = deck_pin(events->deck);
+	due = db_due(db);
+	db_close(db);
+
+	now = sys_utime();
+	if(version != events->version)
+		events_send(file, "update", due, now);
+	else if((due <= now) && !events->ready)
+		events_send(file, "due", due, now);
+
+	events->version = version;
+	events->ready = (due <= now);
+
+	return ((due > now) && (due != DB_NEVER)) ? (int64_t)due : 0;
+}
+
+/**
+ * Send an event with the time until the next card is due, in
+ * milliseconds, zero if due now or negative if none.
+ *   @file: The output file.
+ *   @name: The event name.
+ *   @due: The due time.
+ *   @now: The current time.
+ */
+static void events_send(struct io_file_t file, const char *name, uint64_t due, uint64_t now)
+{
+	int64_t wait;
+
+	if(due == DB_NEVER)
+		wait = -1;
+	else if(due <= now)
+		wait = 0;
+	else
+		wait = (due - now + 999) / 1000;
+
+	hprintf(file, "event: %s\ndata: {\"due\":%ld}\n\n", name, wait);
+}
+
+/**
+ * Process a review message, either 'next' or an action and a card
+ * identifier, optionally followed by the identifier of a card the client
+ * already holds. The action is applied and the reply is a JSON array of up
+ * to two due cards, leaving out both cards, so that the client can show the
+ * card it holds at once and keep the reply for the steps after. Since an
+ * action saves the deck, it is deferred to a worker, and an action that
+ * fails is answered with an error object instead.
+ *   @file: The output file.
+ *   @data: The message.
+ *   @len: The message length.
+ *   @arg: The review socket.
+ *   &returns: True to continue, false on a malformed message.
+ */
+static bool review_msg(struct io_file_t file, const char *data, size_t len, void *arg)
+{
+	struct db_t *db;
+	deck_update_f func = NULL;
+	unsigned int i, n, skip[2] = { DB_NOID, DB_NOID };
+	struct db_entry_t *entry[2];
+	struct review_t *review = arg;
+	struct http_param_t action = { data, strcspn(data, " "), 0 };
+
+	data += action.len;
+
+	if(!http_param_eq(&action, "next")) {
+		func = serv_action(&action);
+		if((func == NULL) || !review_num(&data, &skip[0]))
+			return false;
+	}
+
+	if((*data != '\0') && !review_num(&data, &skip[1]))
+		return false;
+	else if(*data != '\0')
+		return false;
+
+	if(func != NULL) {
+		if(http_websock_defer(file, review_msg))
+			return true;
+
+		if(!deck_update(review->deck, skip[0], func)) {
+			hprintf(file, "{\"error\":\"Cannot update card %u.\"}", skip[0]);
+			return true;
+		}
+	}
+
+	db = deck_pin(review->deck);
+	n = db_sample(db, entry, 2, skip, 2);
+
+	hprintf(file, "[");
+	for(i = 0; i < n; i++) {
+		if(i > 0)
+			hprintf(file, ",");
+
+		serv_entry(file, review->conf, entry[i]);
+	}
+	hprintf(file, "]");
+
+	db_close(db);
+
+	return true;
+}
+
+/**
+ * Parse a space-prefixed card identifier from a review message.
+ *   @str: Ref. The message position, advanced past the identifier.
+ *   @num: Ref. The identifier.
+ *   &returns: True if parsed.
+ */
+static bool review_num(const char **str, unsigned int *num)
+{
+	char *end;
+	unsigned long val;
+
+	if(((*str)[0] != ' ') || !isdigit((*str)[1]))
+		return false;
+
+	errno = 0;
+	val = strtoul(*str + 1, &end, 10);
+	if((errno != 0) || (val >= DB_NOID))
+		return false;
+
+	*num = val;
+	*str = end;
+
+	return true;
+}
+
+/**
+ * Close a file descriptor.
+ *   @arg: The file descriptor.
+ */
+static void fd_close(void *arg)
+{
+	close((intptr_t)arg);
 }
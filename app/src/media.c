@@ -0,0 +1,279 @@
+#include "common.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+
+/*
+ * local declarations
+ */
+static char *media_hash(struct media_file_t *file);
+static bool media_digest(int fd, uint64_t *hash);
+
+static int name_cmp(const void *left, const void *right);
+static int hash_cmp(const void *left, const void *right);
+static int path_cmp(const void *left, const void *right);
+
+
+/**
+ * Open a media index, hashing every file in a directory. Among files with
+ * identical contents, the first by name is the canonical file.
+ *   @media: Ref. The media index.
+ *   @dir: The directory.
+ *   &returns: Error.
+ */
+char *media_open(struct media_t **media, const char *dir)
+{
+#define onexit if(handle != NULL) closedir(handle); for(i = 0; i < n; i++) { free(name[i].name); free(file[i].path); } erase(name); erase(file);
+	DIR *handle;
+	struct dirent *ent;
+	unsigned int i, k, n = 0, size = 0;
+	struct media_name_t *name = NULL;
+	struct media_file_t *file = NULL, key;
+
+	handle = opendir(dir);
+	if(handle == NULL)
+		fail("Cannot open directory '%s'. %s.", dir, strerror(errno));
+
+	while((ent = readdir(handle)) != NULL) {
+		if(ent->d_name[0] == '.')
+			continue;
+
+		if(n == size) {
+			size = size ? (2 * size) : 64;
+			name = name ? realloc(name, size * sizeof(struct media_name_t)) : malloc(size * sizeof(struct media_name_t));
+			file = file ? realloc(file, size * sizeof(struct media_file_t)) : malloc(size * sizeof(struct media_file_t));
+		}
+
+		name[n].name = strdup(ent->d_name);
+		file[n].path = mprintf("%s/%s", dir, ent->d_name);
+		file[n].url = NULL;
+		n++;
+
+		chkfail(media_hash(&file[n-1]));
+		name[n-1].hash = file[n-1].hash;
+	}
+
+	closedir(handle);
+	handle = NULL;
+
+	qsort(name, n, sizeof(struct media_name_t), name_cmp);
+	qsort(file, n, sizeof(struct media_file_t), path_cmp);
+
+	for(i = k = 0; i < n; i++) {
+		if((k > 0) && (file[k-1].hash == file[i].hash)) {
+			free(file[i].path);
+			continue;
+		}
+
+		file[k] = file[i];
+		file[k].url = mprintf("/m/%016llx/%s", (unsigned long long)file[k].hash, strrchr(file[k].path, '/') + 1);
+		k++;
+	}
+
+	for(i = 0; i < n; i++) {
+		key.hash = name[i].hash;
+		name[i].file = bsearch(&key, file, k, sizeof(struct media_file_t), hash_cmp);
+	}
+
+	*media = malloc(sizeof(struct media_t));
+	(*media)->nname = n;
+	(*media)->name = name;
+	(*media)->nfile = k;
+	(*media)->file = file;
+	(*media)->lock = sys_mutex_init(0);
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Close a media index.
+ *   @media: The media index.
+ */
+void media_close(struct media_t *media)
+{
+	unsigned int i;
+
+	for(i = 0; i < media->nname; i++)
+		free(media->name[i].name);
+
+	for(i = 0; i < media->nfile; i++) {
+		free(media->file[i].path);
+		free(media->file[i].url);
+	}
+
+	erase(media->name);
+	erase(media->file);
+	sys_mutex_destroy(&media->lock);
+	free(media);
+}
+
+
+/**
+ * Retrieve the content-addressed URL of a file by name.
+ *   @media: The media index.
+ *   @name: The file name.
+ *   &returns: The URL or null if not indexed or stale.
+ */
+const char *media_url(struct media_t *media, const char *name)
+{
+	struct media_name_t key, *found;
+
+	key.name = (char *)name;
+	found = bsearch(&key, media->name, media->nname, sizeof(struct media_name_t), name_cmp);
+
+	if((found == NULL) || __atomic_load_n(&found->file->stale, __ATOMIC_RELAXED))
+		return NULL;
+
+	return found->file->url;
+}
+
+/**
+ * Open a file by content hash. If the file has changed since it was last
+ * hashed, it is rehashed, and a file whose contents no longer match is
+ * marked stale and not served again, so that content cached as immutable
+ * under its hash is never replaced.
+ *   @media: The media index.
+ *   @hash: The content hash.
+ *   @size: Out. The file size.
+ *   &returns: The file descriptor, or negative if not indexed or stale.
+ */
+int media_file(struct media_t *media, uint64_t hash, uint64_t *size)
+{
+	int fd;
+	bool same;
+	int64_t mtime;
+	uint64_t check;
+	struct stat info;
+	struct media_file_t key, *found;
+
+	key.hash = hash;
+	found = bsearch(&key, media->file, media->nfile, sizeof(struct media_file_t), hash_cmp);
+	if((found == NULL) || __atomic_load_n(&found->stale, __ATOMIC_RELAXED))
+		return -1;
+
+	fd = open(found->path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return -1;
+
+	if(fstat(fd, &info) < 0)
+		fatal("Failure to stat '%s'. %s.", found->path, strerror(errno));
+
+	mtime = asset_mtime(&info);
+
+	sys_mutex_lock(&media->lock);
+	same = (found->mtime == mtime) && (found->size == (uint64_t)info.st_size);
+	sys_mutex_unlock(&media->lock);
+
+	if(!same) {
+		if(!media_digest(fd, &check) || (check != hash)) {
+			__atomic_store_n(&found->stale, true, __ATOMIC_RELAXED);
+			close(fd);
+
+			return -1;
+		}
+
+		sys_mutex_lock(&media->lock);
+		found->mtime = mtime;
+		found->size = info.st_size;
+		sys_mutex_unlock(&media->lock);
+	}
+
+	*size = info.st_size;
+
+	return fd;
+}
+
+
+/**
+ * Compute the content hash of a file, recording its modification time and
+ * size.
+ *   @file: The file.
+ *   &returns: Error.
+ */
+static char *media_hash(struct media_file_t *file)
+{
+#define onexit close(fd);
+	int fd;
+	struct stat info;
+
+	fd = open(file->path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return mprintf("Cannot open '%s'. %s.", file->path, strerror(errno));
+
+	if(fstat(fd, &info) < 0)
+		fail("Failure to stat '%s'. %s.", file->path, strerror(errno));
+
+	file->mtime = asset_mtime(&info);
+	file->size = info.st_size;
+	file->stale = false;
+
+	if(!media_digest(fd, &file->hash))
+		fail("Failure to read from '%s'.", file->path);
+
+	close(fd);
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Compute the content hash of an open file from its start.
+ *   @fd: The file descriptor.
+ *   @hash: Out. The hash.
+ *   &returns: The success flag.
+ */
+static bool media_digest(int fd, uint64_t *hash)
+{
+	ssize_t rd;
+	off_t off = 0;
+	uint8_t buf[64*1024];
+
+	*hash = HASH_FNV64;
+
+	while((rd = pread(fd, buf, sizeof(buf), off)) > 0) {
+		*hash = hash_fnv64(*hash, buf, rd);
+		off += rd;
+	}
+
+	return rd == 0;
+}
+
+
+/**
+ * Compare two names.
+ *   @left: The left name.
+ *   @right: The right name.
+ *   &returns: Their order.
+ */
+static int name_cmp(const void *left, const void *right)
+{
+	return strcmp(((const struct media_name_t *)left)->name, ((const struct media_name_t *)right)->name);
+}
+
+/**
+ * Compare two files by hash.
+ *   @left: The left file.
+ *   @right: The right file.
+ *   &returns: Their order.
+ */
+static int hash_cmp(const void *left, const void *right)
+{
+	uint64_t l = ((const struct media_file_t *)left)->hash, r = ((const struct media_file_t *)right)->hash;
+
+	return (l > r) - (l < r);
+}
+
+/**
+ * Compare two files by hash, then by path.
+ *   @left: The left file.
+ *   @right: The right file.
+ *   &returns: Their order.
+ */
+static int path_cmp(const void *left, const void *right)
+{
+	int cmp = hash_cmp(left, right);
+
+	return cmp ? cmp : strcmp(((const struct media_file_t *)left)->path, ((const struct media_file_t *)right)->path);
+}
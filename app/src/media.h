@@ -0,0 +1,62 @@
+#ifndef MEDIA_H
+#define MEDIA_H
+
+/**
+ * Media file structure. Files with identical contents share one entry.
+ *   @hash: The content hash.
+ *   @path: The path of the canonical file.
+ *   @url: The content-addressed URL.
+ *   @mtime: The modification time when last hashed.
+ *   @size: The file size when last hashed.
+ *   @stale: Set once the file no longer matches its hash.
+ */
+struct media_file_t {
+	uint64_t hash;
+	char *path, *url;
+
+	int64_t mtime;
+	uint64_t size;
+	bool stale;
+};
+
+/**
+ * Media name structure.
+ *   @name: The file name.
+ *   @hash: The content hash.
+ *   @file: The file with its contents.
+ */
+struct media_name_t {
+	char *name;
+	uint64_t hash;
+	struct media_file_t *file;
+};
+
+/**
+ * Media index structure. The index is built once from a directory and maps
+ * file names and content hashes to files, both sorted for lookup. A file
+ * that changes is rehashed when next served, and dropped from the index if
+ * its contents no longer match.
+ *   @nfile, nname: The number of unique files and names.
+ *   @file: The file array, sorted by hash.
+ *   @name: The name array, sorted by name.
+ *   @lock: The lock guarding the recorded file times and sizes.
+ */
+struct media_t {
+	unsigned int nfile, nname;
+	struct media_file_t *file;
+	struct media_name_t *name;
+
+	sys_mutex_t lock;
+};
+
+
+/*
+ * media declarations
+ */
+char *media_open(struct media_t **media, const char *dir);
+void media_close(struct media_t *media);
+
+const char *media_url(struct media_t *media, const char *name);
+int media_file(struct media_t *media, uint64_t hash, uint64_t *size);
+
+#endif
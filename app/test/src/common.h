@@ -0,0 +1,12 @@
+#ifndef COMMON_H
+#define COMMON_H
+
+/*
+ * common includes
+ */
+#include "config.h"
+
+#include <hax.h>
+#include "../../src/inc.h"
+
+#endif
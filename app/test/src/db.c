@@ -0,0 +1,110 @@
+#include "common.h"
+
+
+/**
+ * Deck case structure.
+ *   @deck: The deck file contents.
+ *   @eng: The expected 'eng' field of each identifier from zero, or null if
+ *     the deck must fail to load.
+ */
+struct case_t {
+	const char *deck;
+	const char *eng[8];
+};
+
+
+/*
+ * local declarations
+ */
+static bool check(unsigned int n, const struct case_t *deck, const char *path);
+
+
+/**
+ * Perform tests on the database implementation.
+ *   &returns: Success flag.
+ */
+bool test_db(void)
+{
+	static const struct case_t list[] = {
+		{ "0,0,a,r,h,k,_;\n-,0,b,r,h,k,_;\n1,0,c,r,h,k,_;\n-,0,d,r,h,k,_;\n-,0,e,r,h,k,_;\n2,0,f,r,h,k,_;\n",
+		  { "a", "b", "c", "d", "e", "f" } },
+		{ "-,0,a,r,h,k,_;\n0,0,b,r,h,k,_;\n",
+		  { "a", "b" } },
+		{ "3:0,0,d,r,h,k,_;\n0,0,e,r,h,k,_;\n1:-,0,b,r,h,k,_;\n-,0,f,r,h,k,_;\n0:1,0,a,r,h,k,_;\n",
+		  { "a", "b", NULL, "d", "e", "f" } },
+		{ "0,0,a,r,h,k,_;\n-,0,b,r,h,k;\n", { NULL } },
+		{ "0,0,a,r,h,k,_;\n-,0,b,r,h,k,_\n", { NULL } },
+		{ "0,0,a,r,h,k,_;\n-0,b,r,h,k,_;\n", { NULL } },
+		{ "0:0,0,a,r,h,k,_;\n0:-,0,b,r,h,k,_;\n", { NULL } },
+	};
+
+	FILE *file;
+	unsigned int i;
+	bool suc = true;
+	char path[] = "/tmp/learn-test.XXXXXX";
+
+	for(i = 0; i < sizeof(list) / sizeof(list[0]); i++) {
+		file = fdopen(mkstemp(path), "w");
+		if(file == NULL)
+			fatal("Failed to create file. %s.", strerror(errno));
+
+		fputs(list[i].deck, file);
+		fclose(file);
+
+		suc &= check(i, &list[i], path);
+
+		unlink(path);
+		strcpy(path, "/tmp/learn-test.XXXXXX");
+	}
+
+	return suc;
+}
+
+
+/**
+ * Check that a deck loads with the expected identifiers, or fails to load.
+ *   @n: The case number.
+ *   @deck: The deck case.
+ *   @path: The deck path.
+ *   &returns: Success flag.
+ */
+static bool check(unsigned int n, const struct case_t *deck, const char *path)
+{
+	char *err;
+	unsigned int i;
+	struct db_t *db;
+	bool suc = true;
+	struct db_entry_t *entry;
+
+	err = db_open(&db, path);
+	if(deck->eng[0] == NULL) {
+		if(err == NULL)
+			return db_close(db), fprintf(stderr, "Error. Deck case %u. Malformed deck loaded.\n", n), false;
+
+		free(err);
+
+		return true;
+	}
+	else if(err != NULL)
+		return fprintf(stderr, "Error. Deck case %u. %s\n", n, err), free(err), false;
+
+	for(i = 0; i < 8; i++) {
+		entry = db_lookup(db, i);
+		if((entry == NULL) != (deck->eng[i] == NULL)) {
+			suc = false, fprintf(stderr, "Error. Deck case %u. Identifier %u %s.\n", n, i, entry ? "unexpected" : "missing");
+			continue;
+		}
+		else if(entry == NULL)
+			continue;
+
+		entry = db_entry_iscold(entry) ? db_entry_load(entry) : db_entry_copy(entry);
+		if(strcmp(entry->eng, deck->eng[i]) != 0)
+			suc = false, fprintf(stderr, "Error. Deck case %u. Identifier %u is '%s', expected '%s'.\n", n, i, entry->eng, deck->eng[i]);
+
+		db_entry_release(entry);
+	}
+
+	db_close(db);
+
+	return suc;
+}
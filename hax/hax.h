@@ -0,0 +1,1411 @@
+#ifndef LIBHAX_H
+#define LIBHAX_H
+
+/*
+ * common headers
+ */
+#ifdef WINDOWS
+#	define WIN32_LEAN_AND_MEAN
+#	define _WIN32_WINNT 0x600
+#	include <windows.h>
+#	include <winsock2.h>
+#else
+#	include <pthread.h>
+#	include <netinet/in.h>
+#	include <sys/socket.h>
+#	include <sys/uio.h>
+#	include <sys/time.h>
+#endif
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define noreturn __attribute__((noreturn))
+
+typedef void (*delete_f)(void *ref);
+
+/*
+ * structure prototypes
+ */
+struct sys_poll_t;
+
+/*
+ * fail macros
+ */
+#define fail(...) do { char *_fail_err = hax_mprintf(__VA_ARGS__); do { onexit } while(0); return _fail_err; } while(0)
+#define chkfail(ptr) do { char *_fail_err = ptr; if(_fail_err != NULL) { do { onexit } while(0); return _fail_err; } } while(0)
+#define chkwarn(ptr) do { char *_fail_err = ptr; if(_fail_err != NULL) { hax_fprintf(stderr, "%s\n", _fail_err); free(_fail_err); } } while(0)
+#define chkexit(ptr) do { char *_fail_err = ptr; if(_fail_err != NULL) { hax_fprintf(stderr, "%s\n", _fail_err); exit(1); } } while(0)
+#define chkabort(ptr) do { char *_fail_err = ptr; if(_fail_err != NULL) { hax_fprintf(stderr, "%s\n", _fail_err); abort(); } } while(0)
+
+void hax_free(void *ptr);
+static inline bool chkbool(char *err)
+{
+	if(err != NULL) hax_free(err);
+
+	return err == NULL;
+}
+
+/**
+ * Create callback.
+ *   &returns: The pointer.
+ */
+typedef void *(*new_f)(void);
+
+/**
+ * Copy callback.
+ *   @ptr: The original pointer.
+ *   &returns: The copied pointer.
+ */
+typedef void *(*copy_f)(void *ptr);
+
+/**
+ * Delete callback.
+ *   @ptr: The pointer.
+ */
+typedef void (*delete_f)(void *ptr);
+
+/**
+ * Compare two refrences.
+ *   @left: The left reference.
+ *   @right: The right reference.
+ *   &returns: Their order.
+ */
+typedef int (*compare_f)(const void *left, const void *right);
+
+/**
+ * Retrive the parent data structure from a member pointer.
+ *   @ptr: The member poitner.
+ *   @type: The parent type.
+ *   @member: The member identifier.
+ *   &returns: The parent pointer.
+ */
+#define getparent(ptr, type, member) ((type *)((void *)(ptr) - offsetof(type, member)))
+
+
+/*
+ * common headers
+ */
+
+#include <poll.h>
+
+/*
+ * common definitions 
+ */
+typedef int sys_fd_t;
+typedef int sys_sock_t;
+
+
+/*
+ * common headers
+ */
+
+#include <poll.h>
+
+/*
+ * common definitions 
+ */
+typedef int sys_fd_t;
+typedef int sys_sock_t;
+
+
+/**
+ * Poll enumerator.
+ *   @poll_in_e: Input.
+ *   @poll_out_e: Output.
+ *   @poll_err_e: Error.
+ */
+enum sys_poll_e {
+	sys_poll_in_e = 0x01,
+	sys_poll_out_e = 0x02,
+	sys_poll_err_e = 0x04,
+};
+
+/**
+ * Poll structure.
+ *   @fd: The file descriptor.
+ *   @sock: The socket.
+ *   @events, revents: The listen and received events.
+ */
+struct sys_poll_t {
+	sys_fd_t fd;
+	sys_sock_t sock;
+	enum sys_poll_e events, revents;
+};
+
+/**
+ * Create a poll structure for a file descriptor.
+ *   @fd: The file descriptor.
+ *   @events: The events.
+ *   &returns: The poll structure.
+ */
+static inline struct sys_poll_t sys_poll_fd(sys_fd_t fd, enum sys_poll_e events)
+{
+	return (struct sys_poll_t){ fd, -1, events, 0 };
+}
+
+/**
+ * Create a poll structure for a socket.
+ *   @sock: The socket.
+ *   @events: The events.
+ *   &returns: The poll structure.
+ */
+static inline struct sys_poll_t sys_poll_sock(sys_sock_t sock, enum sys_poll_e events)
+{
+	return (struct sys_poll_t){ -1, sock, events, 0 };
+}
+
+/**
+ * Poller event structure.
+ *   @ref: The reference given when the file was added.
+ *   @revents: The received events.
+ */
+struct sys_event_t {
+	void *ref;
+	enum sys_poll_e revents;
+};
+
+/*
+ * poll declarations
+ */
+bool sys_poll(struct sys_poll_t *poll, unsigned int n, int timeout);
+
+/*
+ * poller declarations
+ */
+sys_fd_t sys_poller_new(void);
+void sys_poller_delete(sys_fd_t fd);
+
+void sys_poller_add(sys_fd_t fd, struct sys_poll_t poll, void *ref);
+void sys_poller_mod(sys_fd_t fd, struct sys_poll_t poll, void *ref);
+void sys_poller_remove(sys_fd_t fd, struct sys_poll_t poll);
+unsigned int sys_poller_wait(sys_fd_t fd, struct sys_event_t *event, unsigned int n, int timeout);
+
+/*
+ * notifier declarations
+ */
+sys_fd_t sys_notify_new(void);
+void sys_notify_delete(sys_fd_t fd);
+
+void sys_notify_signal(sys_fd_t fd);
+void sys_notify_clear(sys_fd_t fd);
+
+
+/*
+ * socket declarations
+ */
+extern sys_sock_t sys_badsock;
+
+char *sys_socket(sys_sock_t *sock, int af, int type, int prot);
+char *sys_connect(sys_sock_t *sock, int type, const char *host, uint16_t port);
+void sys_closesocket(sys_sock_t sock);
+
+ssize_t sys_recv(sys_sock_t sock, void *buf, size_t nbytes, int flags);
+ssize_t sys_send(sys_sock_t sock, const void *buf, size_t nbytes, int flags);
+ssize_t sys_sendv(sys_sock_t sock, const struct iovec *iov, unsigned int cnt, int flags);
+ssize_t sys_sendfile(sys_sock_t sock, int fd, int64_t *off, size_t nbytes);
+
+char *sys_bind(sys_sock_t fd, void *addr, socklen_t len);
+char *sys_listen(sys_sock_t sock, int backlog);
+char *sys_accept(sys_sock_t sock, sys_sock_t *client, struct sockaddr *addr, socklen_t *len);
+char *sys_setsockopt(sys_sock_t fd, int level, int opt, const void *val, socklen_t len);
+
+/**
+ * Check if a socket is valid.
+ *   @fd: The socket.
+ *   &returns: True if valid, false otherwise.
+ */
+static inline bool sys_issock(sys_sock_t fd)
+{
+	return fd >= 0;
+}
+
+
+/*
+ * common headers
+ */
+
+#include <pthread.h>
+
+/**
+ * Thread structure.
+ *   @pthrd: The internal pthread mutex.
+ */
+struct sys_thread_t {
+	pthread_t pthrd;
+};
+
+/**
+ * Mutex structure.
+ *   @pthrd: The internal pthread mutex.
+ */
+struct sys_mutex_t {
+	pthread_mutex_t pthrd;
+};
+
+/**
+ * Condition variable structure.
+ *   @pthrd: The internal thread condition variable.
+ */
+struct sys_cond_t {
+	pthread_cond_t pthrd;
+};
+
+/*
+ * thread declarations
+ */
+typedef struct sys_thread_t sys_thread_t;
+
+sys_thread_t sys_thread_create(unsigned int flags, void *(*func)(void *), void *arg);
+void *sys_thread_join(sys_thread_t *thread);
+void sys_thread_detach(sys_thread_t *thread);
+void sys_thread_drain(unsigned int *cnt);
+
+/*
+ * mutex declarations
+ */
+typedef struct sys_mutex_t sys_mutex_t;
+
+struct sys_mutex_t sys_mutex_init(unsigned int flags);
+void sys_mutex_destroy(struct sys_mutex_t *mutex);
+
+void sys_mutex_lock(struct sys_mutex_t *mutex);
+bool sys_mutex_trylock(struct sys_mutex_t *mutex);
+void sys_mutex_unlock(struct sys_mutex_t *mutex);
+
+#define SYS_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+
+/*
+ * condition variable declarations
+ */
+typedef struct sys_cond_t sys_cond_t;
+
+sys_cond_t sys_cond_init(unsigned int flags);
+void sys_cond_destroy(sys_cond_t *cond);
+
+void sys_cond_wait(sys_cond_t *cond, sys_mutex_t *mutex);
+void sys_cond_signal(sys_cond_t *cond);
+void sys_cond_broadcast(sys_cond_t *cond);
+
+
+/**
+ * Task function.
+ *   @fd: The termiantion file descriptor.
+ *   @arg: The argument.
+ */
+typedef void (*sys_task_f)(sys_fd_t fd, void *arg);
+
+/*
+ * task declarations
+ */
+struct sys_task_t *sys_task_new(sys_task_f func, void *arg);
+void sys_task_delete(struct sys_task_t *task);
+
+
+/*
+ * time function declarations
+ */
+int64_t sys_time(void);
+int64_t sys_utime(void);
+
+void sys_sleep(uint64_t sec);
+void sys_usleep(uint64_t usec);
+
+int64_t sys_clock_realtime();
+int64_t sys_clock_monotonic();
+
+
+/**
+ * Arena structure. Allocations are carved from a fixed block that is kept
+ * across resets; requests that do not fit are given overflow blocks that
+ * are released on reset.
+ *   @idx, size: The index and size of the block.
+ *   @mem: The block memory.
+ *   @over: The overflow block list.
+ */
+struct arena_t {
+	size_t idx, size;
+	char *mem;
+
+	struct arena_block_t *over;
+};
+
+
+/*
+ * arena declarations
+ */
+struct arena_t arena_init(size_t size);
+void arena_destroy(struct arena_t *arena);
+
+void arena_reset(struct arena_t *arena);
+
+void *arena_alloc(struct arena_t *arena, size_t nbytes);
+char *arena_strdup(struct arena_t *arena, const char *str);
+
+
+/**
+ * AVL tree root structure.
+ *   @count: The number of nodes.
+ *   @node: The root node.
+ *   @compare: The comparison callback.
+ */
+struct avltree_root_t {
+	unsigned int count;
+	struct avltree_node_t *node;
+
+	compare_f compare;
+};
+
+/**
+ * AVL tree node storage.
+ *   @bal: The balance factor.
+ *   @ref: The reference.
+ *   @parent, left, right: The parent, left, and right children.
+ */
+struct avltree_node_t {
+	int_fast8_t bal;
+
+	const void *ref;
+	struct avltree_root_t *root;
+	struct avltree_node_t *parent, *left, *right;
+};
+
+
+/**
+ * Pointer-based AVL tree.
+ *   @root: The root.
+ *   @delete: Deletion callback.
+ */
+struct avltree_t {
+	struct avltree_root_t root;
+	delete_f delete;
+};
+
+/**
+ * Instance structure.
+ *   @val: The value.
+ *   @tree: The parent tree.
+ *   @node: The node.
+ */
+struct avltree_inst_t {
+	void *val;
+
+	struct avltree_t *tree;
+	struct avltree_node_t node;
+};
+
+
+/*
+ * avl tree root function declarations
+ */
+struct avltree_root_t avltree_root_init(compare_f compare);
+void avltree_root_destroy(struct avltree_root_t *root, ssize_t offset, delete_f delete);
+
+struct avltree_node_t *avltree_root_first(struct avltree_root_t *root);
+struct avltree_node_t *avltree_root_last(struct avltree_root_t *root);
+struct avltree_node_t *avltree_node_prev(struct avltree_node_t *node);
+struct avltree_node_t *avltree_node_next(struct avltree_node_t *node);
+
+struct avltree_node_t *avltree_root_lookup(struct avltree_root_t *root, const void *ref);
+struct avltree_node_t *avltree_root_atleast(struct avltree_root_t *root, const void *ref);
+struct avltree_node_t *avltree_root_atmost(struct avltree_root_t *root, const void *ref);
+
+void avltree_root_insert(struct avltree_root_t *root, struct avltree_node_t *node);
+struct avltree_node_t *avltree_root_remove(struct avltree_root_t *root, const void *ref);
+
+/*
+ * avl tree declarations
+ */
+struct avltree_t avltree_init(compare_f compare, delete_f delete);
+void avltree_destroy(struct avltree_t *tree);
+
+void *avltree_lookup(struct avltree_t *tree, const void *key);
+struct avltree_inst_t *avltree_insert(struct avltree_t *tree, const void *key, void *val);
+void *avltree_remove(struct avltree_t *tree, const void *key);
+
+struct avltree_inst_t *avltree_first(struct avltree_t *tree);
+struct avltree_inst_t *avltree_prev(struct avltree_inst_t *inst);
+struct avltree_inst_t *avltree_last(struct avltree_t *tree);
+struct avltree_inst_t *avltree_next(struct avltree_inst_t *inst);
+
+
+/*
+ * structure prototypes
+ */
+struct io_file_t;
+
+/**
+ * Chunk processing function.
+ *   @file: The output file.
+ *   @arg: The argument.
+ */
+typedef void (*io_chunk_f)(struct io_file_t file, void *arg);
+
+/**
+ * Chunk structure.
+ *   @func: The processing function.
+ *   @arg: The argument.
+ */
+struct io_chunk_t {
+	io_chunk_f func;
+	void *arg;
+};
+
+/*
+ * chunk declarations
+ */
+
+void io_chunk_proc(struct io_chunk_t chunk, struct io_file_t file);
+
+struct io_chunk_t io_chunk_str(const char *str);
+
+
+/**
+ * Double complex structure.
+ *   @re, im: The re and imaginary components.
+ */
+struct z_double_t {
+	double re, im;
+};
+
+
+/*
+ * complex variables
+ */
+extern struct z_double_t z_zero_d;
+extern struct z_double_t z_one_d;
+
+
+/**
+ * Complex double contructor.
+ *   @re: The real component.
+ *   @im: The imaginary component.
+ *   &returns: The complex number.
+ */
+static inline struct z_double_t z_init_d(double re, double im)
+{
+	return (struct z_double_t){ re, im };
+}
+
+/**
+ * Create a purely real complex number.
+ *   @re: The real component.
+ *   &returns: The complex number.
+ */
+static inline struct z_double_t z_re_d(double re)
+{
+	return z_init_d(re, 0.0);
+}
+
+/**
+ * Create a purely imaginary complex number.
+ *   @im: The imaginary component.
+ *   &returns: The complex number.
+ */
+static inline struct z_double_t z_im_d(double im)
+{
+	return z_init_d(0.0, im);
+}
+
+/**
+ * Check if a complex double is zero.
+ *   @flt: The complex double.
+ *   &returns: True if zero, false otherwise.
+ */
+static inline bool z_iszero_d(struct z_double_t flt)
+{
+	return ((flt.re == 0.0) || (flt.re == -0.0)) && ((flt.im == 0.0) || (flt.im == -0.0));
+}
+
+/**
+ * Check if a complex double is one.
+ *   @flt: The complex double.
+ *   &returns: True if one, false otherwise.
+ */
+static inline bool z_isone_d(struct z_double_t flt)
+{
+	return (flt.re == 1.0) && ((flt.im == 0.0) || (flt.im == -0.0));
+}
+
+/**
+ * Check if two complex doubles are equal.
+ *   @left: The left value.
+ *   @right: The right value.
+ *   &returns: True if equal, false otherwise.
+ */
+static inline bool z_isequal_d(struct z_double_t left, struct z_double_t right)
+{
+	return (left.re == right.re) && (left.im == right.im);
+}
+
+
+/**
+ * Add two complex doubles together.
+ *   @a: The first value.
+ *   @b: The second value.
+ *   &returns: The sum.
+ */
+static inline struct z_double_t z_add_d(struct z_double_t a, struct z_double_t b)
+{
+	return z_init_d(a.re + b.re, a.im + b.im);
+}
+
+/**
+ * Subtract two complex doubles together.
+ *   @a: The first value.
+ *   @b: The second value.
+ *   &returns: The difference.
+ */
+static inline struct z_double_t z_sub_d(struct z_double_t a, struct z_double_t b)
+{
+	return z_init_d(a.re - b.re, a.im - b.im);
+}
+
+/**
+ * Multiply two complex doubles together.
+ *   @a: The first value.
+ *   @b: The second value.
+ *   &returns: The product.
+ */
+static inline struct z_double_t z_mul_d(struct z_double_t a, struct z_double_t b)
+{
+	return z_init_d(a.re * b.re - a.im * b.im, a.im * b.re + a.re * b.im);
+}
+
+/**
+ * Divide two complex doubles together.
+ *   @a: The first value.
+ *   @b: The second value.
+ *   &returns: The quotient.
+ */
+static inline struct z_double_t z_div_d(struct z_double_t a, struct z_double_t b)
+{
+	double t = b.re * b.re + b.im * b.im;
+
+	return z_init_d((a.re * b.re + a.im * b.im) / t, (a.im * b.re - a.re * b.im) / t);
+}
+
+/**
+ * Exponentiate the complex double.
+ *   @a: The complex value.
+ *   &returns: The exponentiated value.
+ */
+static inline struct z_double_t z_exp_d(struct z_double_t a)
+{
+	double c = exp(a.re);
+
+	return z_init_d(c * cos(a.im), c * sin(a.im));
+}
+
+/**
+ * Exponentiate to an imaginary number.
+ *   @im: The imaginary coefficient.
+ *   &returns: The exponentiated value.
+ */
+static inline struct z_double_t z_expi_d(double im)
+{
+	return z_init_d(cos(im), sin(im));
+}
+
+
+/**
+ * Compute the magnitude of the complex double.
+ *   @a: The complex double.
+ *   &returns: The magnitude.
+ */
+static inline double z_mag_d(struct z_double_t a)
+{
+	return sqrt((a.re * a.re) + (a.im * a.im));
+}
+
+/**
+ * Compute the magnitude of the complex double.
+ *   @a: The complex double.
+ *   &returns: The argument.
+ */
+static inline double z_arg_d(struct z_double_t a)
+{
+	return atan2(a.im, a.re);
+}
+
+
+/*
+ * crc32 declarations
+ */
+extern uint32_t crc32_table[];
+uint32_t crc32_calc(uint32_t crc, const void *buf, size_t nbytes);
+
+
+/**
+ * Read function.
+ *   @ref: The reference.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes to read.
+ *   &returns: The number of bytes read.
+ */
+typedef size_t (*io_read_f)(void *ref, void *buf, size_t nbytes);
+
+/**
+ * Write function.
+ *   @ref: The reference.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes to write.
+ *   &returns: The number of bytes written.
+ */
+typedef size_t (*io_write_f)(void *ref, const void *buf, size_t nbytes);
+
+/**
+ * Close function.
+ *   @ref: The reference.
+ */
+typedef void (*io_close_f)(void *ref);
+
+/**
+ * File interface.
+ *   @read: Read data.
+ *   @write: Write data.
+ *   @close: Close file.
+ */
+struct io_file_i {
+	io_read_f read;
+	io_write_f write;
+	io_close_f close;
+};
+
+/**
+ * File structure.
+ *   @ref: The reference.
+ *   @iface: The file interface.
+ */
+struct io_file_t {
+	void *ref;
+	const struct io_file_i *iface;
+};
+
+/**
+ * Read to a file.
+ *   @file: The file.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   &returns: The number of bytes read.
+ */
+static inline size_t io_file_read(struct io_file_t file, void *buf, size_t nbytes)
+{
+	return file.iface->read(file.ref, buf, nbytes);
+}
+
+/**
+ * Write to a file.
+ *   @file: The file.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   &returns: The number of bytes written.
+ */
+static inline size_t io_file_write(struct io_file_t file, const void *buf, size_t nbytes)
+{
+	return file.iface->write(file.ref, buf, nbytes);
+}
+
+/**
+ * Close a file.
+ *   @file: The file.
+ */
+static inline void io_file_close(struct io_file_t file)
+{
+	file.iface->close(file.ref);
+}
+
+
+/*
+ * structure prototypes
+ */
+struct strbuf_t;
+
+/*
+ * file declarations
+ */
+struct io_file_t io_file_len(size_t *len);
+struct io_file_t io_file_accum(char **str, size_t *len);
+struct io_file_t io_file_strbuf(struct strbuf_t *buf);
+struct io_file_t io_file_wrap(FILE *file);
+struct io_file_t io_file_fd(int fd);
+struct io_file_t io_file_str(const char *str);
+
+
+/*
+ * comparison declarations
+ */
+int compare_int(const void *left, const void *right);
+int compare_uint16(const void *left, const void *right);
+int compare_str(const void *left, const void *right);
+int compare_ptr(const void *left, const void *right);
+
+void delete_noop(void *ptr);
+
+
+/*
+ * hash definitions
+ */
+#define HASH_FNV32	2166136261u
+#define HASH_FNV64	14695981039346656037u
+
+/*
+ * hash declarations
+ */
+uint32_t hash_fnv32(uint32_t hash, const void *buf, size_t nbytes);
+uint32_t hash_fnv32_fold(uint32_t hash, const void *buf, size_t nbytes);
+uint64_t hash_fnv64(uint64_t hash, const void *buf, size_t nbytes);
+
+
+/**
+ * List root structure.
+ *   @len: The length.
+ *   @head, tail: The head and tail nodes.
+ */
+
+struct list_root_t {
+	unsigned int len;
+	struct list_node_t *head, *tail;
+};
+
+/**
+ * List node structure.
+ *   @prev, next: The previous and next node.
+ */
+
+struct list_node_t {
+	struct list_node_t *prev, *next;
+};
+
+
+/*
+ * list root function declarations
+ */
+
+struct list_root_t list_root_init(void);
+void list_root_destroy(struct list_root_t *root, ssize_t offset, delete_f delete);
+
+void list_root_prepend(struct list_root_t *root, struct list_node_t *node);
+void list_root_append(struct list_root_t *root, struct list_node_t *node);
+void list_root_insert_before(struct list_root_t *root, struct list_node_t *cur, struct list_node_t *node);
+void list_root_insert_after(struct list_root_t *root, struct list_node_t *cur, struct list_node_t *node);
+void list_root_remove(struct list_root_t *root, struct list_node_t *node);
+
+
+/**
+ * Retrieve the reference from a node using an offset.
+ *   @node: The node.
+ *   @offset: The offset.
+ *   &returns: The reference.
+ */
+
+static inline void *list_node_ref(struct list_node_t *node, ssize_t offset)
+{
+	return (void *)node - offset;
+}
+
+
+/*
+ * log declarations
+ */
+void hax_logf(const char *path, unsigned int line, const char *format, ...);
+void hax_logfv(const char *path, unsigned int line, const char *format, va_list args);
+
+#define logf(format, ...) hax_logf(__FILE__, __LINE__, format, ##__VA_ARGS__)
+#define vlogf(format, args) hax_vlogf(__FILE__, __LINE__, format, args)
+
+
+/*
+ * memory declarations
+ */
+
+extern ssize_t hax_memcnt;
+
+void *hax_malloc(size_t nbytes);
+void hax_free(void *ptr);
+char *hax_strdup(const char *str);
+
+void hax_inc(void);
+void hax_dec(void);
+
+
+static inline void erase(void *ptr)
+{
+	if(ptr != NULL)
+		hax_free(ptr);
+}
+
+static inline void hax_strset(char **dest, char *src)
+#define strset hax_strset
+{
+	erase(*dest);
+	*dest = src;
+}
+
+/*
+ * fallback definitions
+ */
+
+static inline void *_malloc(size_t nbytes) { return malloc(nbytes); }
+static inline void _free(void *ptr) { free(ptr); }
+
+/*
+ * shortened macros
+ */
+
+#undef malloc
+#undef free
+#undef strdup
+#define malloc hax_malloc
+#define free hax_free
+#define strdup hax_strdup
+
+
+
+/*
+ * printing declarations
+ */
+size_t hax_lprintf(const char *restrict format, ...);
+size_t hax_vlprintf(const char *restrict format, va_list args);
+
+char *hax_mprintf(const char *restrict format, ...);
+char *hax_vmprintf(const char *restrict format, va_list args);
+
+void hax_hprintf(struct io_file_t file, const char *restrict format, ...);
+void hax_vhprintf(struct io_file_t file, const char *restrict format, va_list args);;
+
+void hax_fprintf(FILE *file, const char *restrict format, ...);
+void hax_vfprintf(FILE *file, const char *restrict format, va_list args);
+
+void hax_printf(const char *restrict format, ...);
+
+noreturn void hax_vfatal(const char *restrict format, va_list args);
+noreturn void hax_fatal(const char *restrict format, ...);
+
+
+/**
+ * Direct 'vprintf' call.
+ *   @format: The format.
+ *   @args: The arguments.
+ *   &returns: Number of bytes written.
+ */
+static inline int d_vprintf(const char *restrict format, va_list args)
+{
+	return vprintf(format, args);
+}
+
+/**
+ * Direct 'printf' call.
+ *   @format: The format.
+ *   @args: The arguments.
+ *   &returns: Number of bytes written.
+ */
+static inline size_t d_printf(const char *restrict format, ...)
+{
+	int retval;
+	va_list args;
+
+	va_start(args, format);
+	retval = vprintf(format, args);
+	va_end(args);
+
+	return retval;
+}
+
+/**
+ * Direct 'fprintf' call.
+ *   @file: The file.
+ *   @format: The format.
+ *   @args: The arguments.
+ *   &returns: Number of bytes written.
+ */
+static inline int d_fprintf(FILE *file, const char *restrict format, ...)
+{
+	int retval;
+	va_list args;
+
+	va_start(args, format);
+	retval = vfprintf(file, format, args);
+	va_end(args);
+
+	return retval;
+}
+
+/**
+ * Direct 'vfprintf' call.
+ *   @file: The file.
+ *   @format: The format.
+ *   @args: The arguments.
+ *   &returns: Number of bytes written.
+ */
+static inline int d_vfprintf(FILE *file, const char *restrict format, va_list args)
+{
+	return vfprintf(file, format, args);
+}
+
+static inline size_t d_vsprintf(char *restrict str, const char *restrict format, va_list args)
+{
+	return vsprintf(str, format, args);
+}
+static inline size_t d_vsnprintf(char *restrict str, size_t nbytes, const char *restrict format, va_list args)
+{
+	return vsnprintf(str, nbytes, format, args);
+}
+
+
+/*
+ * short macros
+ */
+#define lprintf hax_lprintf
+#define vlprintf hax_vlprintf
+
+#define mprintf hax_mprintf
+#define vmprintf hax_vmprintf
+
+#define hprintf hax_hprintf
+#define vhprintf hax_vhprintf
+
+#define fprintf hax_fprintf
+#define vfprintf hax_vfprintf
+
+#define printf hax_printf
+#define vprintf hax_vprintf
+
+#define fatal hax_fatal
+#define vfatal hax_vfatal
+
+
+/**
+ * Random storage structure.
+ *   @x, y, z, w: Storage data.
+ */
+struct m_rand_t {
+	uint32_t x, y, z, w;
+};
+
+/*
+ * random declarations
+ */
+extern struct m_rand_t m_rand;
+
+void m_rand_seed(uint32_t seed);
+struct m_rand_t m_rand_init(uint32_t seed);
+double m_rand_d(struct m_rand_t *rand);
+
+
+/*
+ * sha1 definitions
+ */
+#define SHA1_LEN	20
+
+/**
+ * SHA-1 state structure.
+ *   @h: The hash state.
+ *   @len: The number of bytes processed.
+ *   @buf: The partial block.
+ */
+struct sha1_t {
+	uint32_t h[5];
+	uint64_t len;
+	uint8_t buf[64];
+};
+
+/*
+ * sha1 declarations
+ */
+struct sha1_t sha1_init(void);
+void sha1_proc(struct sha1_t *sha1, const void *buf, size_t nbytes);
+void sha1_finish(struct sha1_t *sha1, uint8_t *digest);
+
+
+/**
+ * String buffer structure.
+ *   @idx, len: The index and length.
+ *   @arr: The character array.
+ */
+
+struct strbuf_t {
+	size_t idx, len;
+	char *arr;
+};
+
+
+/*
+ * string buffer declarations
+ */
+
+struct strbuf_t strbuf_init(size_t initlen);
+void strbuf_destroy(struct strbuf_t *buf);
+
+char strbuf_last(struct strbuf_t *buf);
+void strbuf_addch(struct strbuf_t *buf, char ch);
+void strbuf_addstr(struct strbuf_t *buf, const char *restrict str);
+void strbuf_addmem(struct strbuf_t *buf, const char *restrict data, size_t nbytes);
+
+char *strbuf_done(struct strbuf_t *buf);
+const char *strbuf_finish(struct strbuf_t *buf);
+
+
+/*
+ * header definitions
+ */
+#define HTTP_INLINE	16
+
+/**
+ * Well-known header enumerator.
+ *   @content_length: Content-Length.
+ *   @connection: Connection.
+ *   @host: Host.
+ *   @if_none_match: If-None-Match.
+ *   @range: Range.
+ *   @accept_encoding: Accept-Encoding.
+ *   @cookie: Cookie.
+ *   @transfer_encoding: Transfer-Encoding.
+ *   @nknown: The number of well-known headers.
+ */
+enum http_known_e {
+	http_content_length_e,
+	http_connection_e,
+	http_host_e,
+	http_if_none_match_e,
+	http_range_e,
+	http_accept_encoding_e,
+	http_cookie_e,
+	http_transfer_encoding_e,
+	http_nknown_e
+};
+
+/**
+ * Key-value pair structure.
+ *   @key, value: Key and value strings.
+ *   @hash: The case-insensitive hash of the key.
+ */
+struct http_pair_t {
+	const char *key, *value;
+	uint32_t hash;
+};
+
+/**
+ * Header structure. Request headers point into the received header block
+ * and added headers are copied into the arena, so that no header requires
+ * its own allocation. The first pairs are stored inline, and any further
+ * pairs in an overflow array allocated from the arena. Well-known headers
+ * are also recognized into fixed slots as they are added.
+ *   @verb, path, proto: Verb path and protocol.
+ *   @known: The values of the well-known headers.
+ *   @cnt, size: The number of pairs and the overflow capacity.
+ *   @pair: The inline pair array.
+ *   @over: The overflow pair array.
+ *   @arena: The arena.
+ */
+struct http_head_t {
+	const char *verb, *path, *proto;
+	const char *known[http_nknown_e];
+
+	unsigned int cnt, size;
+	struct http_pair_t pair[HTTP_INLINE], *over;
+
+	struct arena_t *arena;
+};
+
+/**
+ * Server configuration structure. Time limits are in microseconds, zero
+ * for none.
+ *   @idle: The idle limit between requests.
+ *   @head: The limit for receiving a request header, from its first byte
+ *     or from the connection if the first request.
+ *   @body: The limit for receiving a request body.
+ *   @life: The total lifetime of a connection.
+ *   @length: The maximum length of a request body buffered for a handler,
+ *     zero for none. Bodies taken as they arrive are not limited.
+ *   @max: The maximum number of requests per connection, zero for none.
+ *   @threads: The number of event loop threads, zero to run a single loop
+ *     from the caller.
+ *   @workers: The number of worker threads for deferred requests, zero to
+ *     run them inline.
+ *   @pipeline: The maximum number of unsent responses per connection, zero
+ *     for none.
+ */
+struct http_conf_t {
+	int64_t idle, head, body, life;
+	uint64_t length;
+	unsigned int max, pipeline, threads, workers;
+};
+
+/**
+ * Argument structure. By default, the response body is accumulated and
+ * sent with its length once the handler returns. A handler may instead
+ * declare the length or select chunked encoding before writing, after
+ * which the headers are sent and writes go out as they are produced.
+ *
+ * A request with a body is first offered to the handler with a null body,
+ * before any of the body is read. The handler may take the body as it
+ * arrives with 'http_args_input'; a handler that does not must return
+ * without writing, and is called again once the whole body is buffered.
+ *   @file: The output file.
+ *   @body: The body, null while the request is offered.
+ *   @req, resp: The request and response header.
+ *   @client: The client.
+ */
+struct http_args_t {
+	struct io_file_t file;
+
+	const char *body;
+	struct http_head_t req, resp;
+
+	struct http_client_t *client;
+};
+
+
+/**
+ * Server handler callback.
+ *   @path: The path.
+ *   @args: The request arguments.
+ *   @arg: The argument.
+ *   &returns: True if handled, false otherwise.
+ */
+typedef bool (*http_handler_f)(const char *path, struct http_args_t *args, void *arg);
+
+/**
+ * Response stream callback, called each time the output queue of the
+ * connection drains below the low-water mark.
+ *   @file: The output file.
+ *   @arg: The argument.
+ *   &returns: True if more data remains, false once complete.
+ */
+typedef bool (*http_stream_f)(struct io_file_t file, void *arg);
+
+/**
+ * Request body callback, called with each piece of the decoded body as it
+ * arrives and a last time with no data once the body is complete.
+ *   @args: The request arguments.
+ *   @data: The data, null at the end of the body.
+ *   @len: The length, zero at the end of the body.
+ *   @arg: The argument.
+ *   &returns: True to continue, false to stop reading and close the
+ *     connection after the response.
+ */
+typedef bool (*http_input_f)(struct http_args_t *args, const char *data, size_t len, void *arg);
+
+/**
+ * Deferred work callback, run on a worker thread. The callback may use the
+ * arguments as a handler would, but its output is only sent once it
+ * returns.
+ *   @args: The request arguments.
+ *   @arg: The argument.
+ *   &returns: True if handled, false otherwise.
+ */
+typedef bool (*http_work_f)(struct http_args_t *args, void *arg);
+
+/**
+ * Push callback, called once the handler returns, each time the hub of the
+ * response is signaled, and when the alarm it returned expires.
+ *   @file: The output file.
+ *   @arg: The argument.
+ *   &returns: The time of the next alarm in microseconds, zero for none, or
+ *     negative to complete the response.
+ */
+typedef int64_t (*http_push_f)(struct io_file_t file, void *arg);
+
+/**
+ * WebSocket message callback, called with each complete message received.
+ * Anything written to the output file is sent back as one text message.
+ *   @file: The output file.
+ *   @data: The message data, followed by a null byte.
+ *   @len: The message length.
+ *   @arg: The argument.
+ *   &returns: True to continue, false to close the connection.
+ */
+typedef bool (*http_websock_f)(struct io_file_t file, const char *data, size_t len, void *arg);
+
+/*
+ * structure prototypes
+ */
+struct tcp_client_t;
+struct http_server_t;
+struct http_client_t;
+struct http_hub_t;
+
+/*
+ * http configuration function declarations
+ */
+struct http_conf_t http_conf_init(void);
+
+/*
+ * http server function declarations
+ */
+char *http_server_open(struct http_server_t **server, uint16_t port, const struct http_conf_t *conf);
+void http_server_close(struct http_server_t *server);
+
+void http_server_start(struct http_server_t *server, http_handler_f func, void *arg);
+
+char *http_server_proc(struct http_server_t *server, struct sys_poll_t *fds, http_handler_f func, void *arg);
+unsigned int http_server_poll(struct http_server_t *server, struct sys_poll_t *poll);
+int http_server_timeout(struct http_server_t *server);
+
+/*
+ * http client function declarations
+ */
+struct http_client_t *http_client_new(struct tcp_client_t *tcp, const struct http_conf_t *conf);
+void http_client_delete(struct http_client_t *client);
+
+bool http_client_proc(struct http_client_t *client, http_handler_f func, void *arg);
+
+/*
+ * http argument function declarations
+ */
+void http_args_length(struct http_args_t *args, uint64_t len);
+void http_args_chunked(struct http_args_t *args);
+void http_args_status(struct http_args_t *args, unsigned int status);
+void http_args_ref(struct http_args_t *args, const void *buf, size_t nbytes, delete_f delete, void *arg);
+void http_args_file(struct http_args_t *args, int fd, uint64_t size, delete_f delete, void *arg);
+void http_args_stream(struct http_args_t *args, http_stream_f func, void *arg, delete_f delete);
+void http_args_input(struct http_args_t *args, http_input_f func, void *arg, delete_f delete);
+bool http_args_defer(struct http_args_t *args, http_work_f func, void *arg, delete_f delete);
+bool http_args_push(struct http_args_t *args, struct http_hub_t *hub, http_push_f func, void *arg, delete_f delete);
+bool http_args_websock(struct http_args_t *args, http_websock_f func, void *arg, delete_f delete);
+
+bool http_websock_defer(struct io_file_t file, http_websock_f func);
+
+/*
+ * http hub function declarations
+ */
+struct http_hub_t *http_hub_new(void);
+void http_hub_delete(struct http_hub_t *hub);
+void http_hub_signal(struct http_hub_t *hub);
+
+/*
+ * http header function declarations
+ */
+struct http_head_t http_head_init(struct arena_t *arena);
+void http_head_destroy(struct http_head_t *head);
+
+const char *http_head_lookup(struct http_head_t *head, const char *key);
+const char *http_head_known(struct http_head_t *head, enum http_known_e id);
+bool http_head_accepts(struct http_head_t *head, const char *coding);
+bool http_etag_match(const char *tags, const char *etag);
+void http_head_add(struct http_head_t *head, const char *key, const char *value);
+
+struct http_pair_t *http_head_get(struct http_head_t *head, unsigned int idx);
+char *http_head_parse(struct http_head_t *head, char *str, size_t len);
+
+
+/*
+ * router definitions
+ */
+#define HTTP_PARAMS	8
+
+/*
+ * route flags
+ */
+#define HTTP_ROUTE_BLOCK	0x01
+#define HTTP_ROUTE_STREAM	0x02
+
+/**
+ * Route parameter structure.
+ *   @str: The parameter text, not null-terminated.
+ *   @len: The length of the text.
+ *   @num: The value of an integer parameter.
+ */
+struct http_param_t {
+	const char *str;
+	size_t len;
+	uint64_t num;
+};
+
+/**
+ * Route handler callback.
+ *   @args: The request arguments.
+ *   @param: The path parameters, in the order they appear.
+ *   @arg: The argument.
+ *   &returns: True if handled, false otherwise.
+ */
+typedef bool (*http_route_f)(struct http_args_t *args, const struct http_param_t *param, void *arg);
+
+/*
+ * structure prototypes
+ */
+struct http_router_t;
+
+/*
+ * router declarations
+ */
+struct http_router_t *http_router_new(void);
+void http_router_delete(struct http_router_t *router);
+
+char *http_router_add(struct http_router_t *router, const char *pattern, http_route_f func, void *arg, unsigned int flags);
+bool http_router_proc(const char *path, struct http_args_t *args, void *arg);
+
+/**
+ * Check if a parameter equals a string.
+ *   @param: The parameter.
+ *   @str: The string.
+ *   &returns: True if equal.
+ */
+static inline bool http_param_eq(const struct http_param_t *param, const char *str)
+{
+	return (strncmp(param->str, str, param->len) == 0) && (str[param->len] == '\0');
+}
+
+
+/*
+ * tcp client declarations
+ */
+struct tcp_client_t;
+
+struct tcp_client_t *tcp_client_new(sys_sock_t sock);
+void tcp_client_delete(struct tcp_client_t *client);
+
+char *tcp_client_open(struct tcp_client_t **client, const char *host, uint16_t port);
+void tcp_client_close(struct tcp_client_t *client);
+
+sys_sock_t tcp_client_sock(struct tcp_client_t *client);
+struct sys_poll_t tcp_client_poll(struct tcp_client_t *client);
+void tcp_client_limit(struct tcp_client_t *client, size_t limit);
+
+size_t tcp_client_avail(struct tcp_client_t *client);
+size_t tcp_client_queue(struct tcp_client_t *client);
+unsigned int tcp_client_pending(struct tcp_client_t *client);
+bool tcp_client_eof(struct tcp_client_t *client);
+
+bool tcp_client_read(struct tcp_client_t *client, void *restrict buf, size_t nbytes);
+const void *tcp_client_peek(struct tcp_client_t *client, size_t *nbytes);
+void tcp_client_consume(struct tcp_client_t *client, size_t nbytes);
+void tcp_client_write(struct tcp_client_t *client, const void *restrict buf, size_t nbytes);
+void tcp_client_writeref(struct tcp_client_t *client, const void *buf, size_t nbytes, delete_f delete, void *arg);
+void tcp_client_sendfile(struct tcp_client_t *client, int fd, int64_t off, size_t nbytes, delete_f delete, void *arg);
+bool tcp_client_flush(struct tcp_client_t *client);
+bool tcp_client_proc(struct tcp_client_t *client, enum sys_poll_e events);
+
+/*
+ * tcp server declarations
+ */
+struct tcp_server_t;
+
+/*
+ * tcp server definitions
+ */
+#define TCP_REUSEPORT	0x01
+
+char *tcp_server_open(struct tcp_server_t **server, uint16_t port, unsigned int flags);
+void tcp_server_close(struct tcp_server_t *server);
+
+char *tcp_server_listen(struct tcp_server_t *server);
+char *tcp_server_accept(struct tcp_server_t *server, sys_sock_t *fd);
+
+sys_sock_t tcp_server_sock(struct tcp_server_t *server);
+struct sys_poll_t tcp_server_poll(struct tcp_server_t *server);
+
+#endif
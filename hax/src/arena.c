@@ -0,0 +1,102 @@
+#include "common.h"
+
+
+/**
+ * Overflow block structure.
+ *   @next: The next block.
+ *   @mem: The memory.
+ */
+struct arena_block_t {
+	struct arena_block_t *next;
+
+	char mem[];
+};
+
+
+/**
+ * Initialize an arena.
+ *   @size: The block size.
+ *   &returns: The arena.
+ */
+struct arena_t arena_init(size_t size)
+{
+	struct arena_t arena;
+
+	arena.idx = 0;
+	arena.size = size;
+	arena.mem = malloc(size);
+	arena.over = NULL;
+
+	return arena;
+}
+
+/**
+ * Destroy an arena, freeing all allocations.
+ *   @arena: The arena.
+ */
+void arena_destroy(struct arena_t *arena)
+{
+	arena_reset(arena);
+	free(arena->mem);
+}
+
+
+/**
+ * Reset an arena, freeing all allocations at once. Without overflow blocks,
+ * the reset is constant time.
+ *   @arena: The arena.
+ */
+void arena_reset(struct arena_t *arena)
+{
+	struct arena_block_t *block;
+
+	while(arena->over != NULL) {
+		block = arena->over;
+		arena->over = block->next;
+		free(block);
+	}
+
+	arena->idx = 0;
+}
+
+
+/**
+ * Allocate memory from an arena. The memory is aligned for any pointer or
+ * integer type and is valid until the arena is reset.
+ *   @arena: The arena.
+ *   @nbytes: The number of bytes.
+ *   &returns: The allocated memory.
+ */
+void *arena_alloc(struct arena_t *arena, size_t nbytes)
+{
+	void *ptr;
+	struct arena_block_t *block;
+
+	nbytes = (nbytes + 7) & ~(size_t)7;
+
+	if(nbytes <= (arena->size - arena->idx)) {
+		ptr = arena->mem + arena->idx;
+		arena->idx += nbytes;
+
+		return ptr;
+	}
+
+	block = malloc(sizeof(struct arena_block_t) + nbytes);
+	block->next = arena->over;
+	arena->over = block;
+
+	return block->mem;
+}
+
+/**
+ * Duplicate a string into an arena.
+ *   @arena: The arena.
+ *   @str: The string.
+ *   &returns: The duplicated string.
+ */
+char *arena_strdup(struct arena_t *arena, const char *str)
+{
+	size_t len = strlen(str) + 1;
+
+	return memcpy(arena_alloc(arena, len), str, len);
+}
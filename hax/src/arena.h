@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/**
+ * Arena structure. Allocations are carved from a fixed block that is kept
+ * across resets; requests that do not fit are given overflow blocks that
+ * are released on reset.
+ *   @idx, size: The index and size of the block.
+ *   @mem: The block memory.
+ *   @over: The overflow block list.
+ */
+struct arena_t {
+	size_t idx, size;
+	char *mem;
+
+	struct arena_block_t *over;
+};
+
+
+/*
+ * arena declarations
+ */
+struct arena_t arena_init(size_t size);
+void arena_destroy(struct arena_t *arena);
+
+void arena_reset(struct arena_t *arena);
+
+void *arena_alloc(struct arena_t *arena, size_t nbytes);
+char *arena_strdup(struct arena_t *arena, const char *str);
+
+#endif
@@ -0,0 +1,5 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+#define DEBUG 1
+#define SHAREDIR "/usr/local/share"
+#endif
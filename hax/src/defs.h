@@ -13,6 +13,7 @@
 #	include <pthread.h>
 #	include <netinet/in.h>
 #	include <sys/socket.h>
+#	include <sys/uio.h>
 #	include <sys/time.h>
 #endif
 
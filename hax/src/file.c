@@ -21,6 +21,10 @@ static size_t accum_write(void *ref, const void *data, size_t nbytes);
 static size_t accum_read(void *ref, void *data, size_t nbytes);
 static void accum_close(void *ref);
 
+static size_t strbuf_write(void *ref, const void *data, size_t nbytes);
+static size_t strbuf_read(void *ref, void *data, size_t nbytes);
+static void strbuf_close(void *ref);
+
 static size_t str_write(void *ref, const void *buf, size_t nbytes);
 static size_t str_read(void *ref, void *buf, size_t nbytes);
 
@@ -113,6 +117,33 @@ static void accum_close(void *ref)
 }
 
 
+/**
+ * Create a file appending onto an existing string buffer. Closing the file
+ * leaves the buffer intact.
+ *   @buf: The string buffer.
+ *   &returns: The file.
+ */
+struct io_file_t io_file_strbuf(struct strbuf_t *buf)
+{
+	static const struct io_file_i iface = { strbuf_read, strbuf_write, strbuf_close };
+
+	return (struct io_file_t){ buf, &iface };
+}
+static size_t strbuf_write(void *ref, const void *data, size_t nbytes)
+{
+	strbuf_addmem(ref, data, nbytes);
+
+	return nbytes;
+}
+static size_t strbuf_read(void *ref, void *data, size_t nbytes)
+{
+	return 0;
+}
+static void strbuf_close(void *ref)
+{
+}
+
+
 /**
  * Write to file.
  *   @ref: The file reference.
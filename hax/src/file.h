@@ -81,11 +81,17 @@ static inline void io_file_close(struct io_file_t file)
 }
 
 
+/*
+ * structure prototypes
+ */
+struct strbuf_t;
+
 /*
  * file declarations
  */
 struct io_file_t io_file_len(size_t *len);
 struct io_file_t io_file_accum(char **str, size_t *len);
+struct io_file_t io_file_strbuf(struct strbuf_t *buf);
 struct io_file_t io_file_wrap(FILE *file);
 struct io_file_t io_file_fd(int fd);
 struct io_file_t io_file_str(const char *str);
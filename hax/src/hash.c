@@ -0,0 +1,54 @@
+#include "common.h"
+
+
+/**
+ * Compute a 32-bit FNV-1a hash over a buffer.
+ *   @hash: The input hash. Initialize to 'HASH_FNV32'.
+ *   @buf: The buffer.
+ *   @nbytes: The size of the buffer.
+ *   &returns: The hash.
+ */
+uint32_t hash_fnv32(uint32_t hash, const void *buf, size_t nbytes)
+{
+	const uint8_t *ptr = buf;
+
+	while(nbytes-- > 0)
+		hash = (hash ^ *ptr++) * 16777619u;
+
+	return hash;
+}
+
+/**
+ * Compute a 32-bit FNV-1a hash over a buffer, folding ASCII upper case to
+ * lower case so that keys differing only in case hash alike.
+ *   @hash: The input hash. Initialize to 'HASH_FNV32'.
+ *   @buf: The buffer.
+ *   @nbytes: The size of the buffer.
+ *   &returns: The hash.
+ */
+uint32_t hash_fnv32_fold(uint32_t hash, const void *buf, size_t nbytes)
+{
+	const uint8_t *ptr = buf;
+
+	for(; nbytes-- > 0; ptr++)
+		hash = (hash ^ (((*ptr >= 'A') && (*ptr <= 'Z')) ? (*ptr + 0x20) : *ptr)) * 16777619u;
+
+	return hash;
+}
+
+/**
+ * Compute a 64-bit FNV-1a hash over a buffer.
+ *   @hash: The input hash. Initialize to 'HASH_FNV64'.
+ *   @buf: The buffer.
+ *   @nbytes: The size of the buffer.
+ *   &returns: The hash.
+ */
+uint64_t hash_fnv64(uint64_t hash, const void *buf, size_t nbytes)
+{
+	const uint8_t *ptr = buf;
+
+	while(nbytes-- > 0)
+		hash = (hash ^ *ptr++) * 1099511628211u;
+
+	return hash;
+}
@@ -0,0 +1,17 @@
+#ifndef HASH_H
+#define HASH_H
+
+/*
+ * hash definitions
+ */
+#define HASH_FNV32	2166136261u
+#define HASH_FNV64	14695981039346656037u
+
+/*
+ * hash declarations
+ */
+uint32_t hash_fnv32(uint32_t hash, const void *buf, size_t nbytes);
+uint32_t hash_fnv32_fold(uint32_t hash, const void *buf, size_t nbytes);
+uint64_t hash_fnv64(uint64_t hash, const void *buf, size_t nbytes);
+
+#endif
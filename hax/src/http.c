@@ -5,44 +5,328 @@
  * State enumerator.
  *   @head_v: Header.
  *   @body_v: Body.
+ *   @work_v: Waiting on deferred work.
+ *   @stream_v: Streaming a response.
+ *   @push_v: Pushing a response as events occur.
+ *   @sock_v: Exchanging WebSocket messages.
  *   @done_v: Done.
  */
 enum state_e {
 	head_v,
 	body_v,
+	work_v,
+	stream_v,
+	push_v,
+	sock_v,
 	done_v
 };
 
 /**
- * HTTP server structure.
+ * Response body enumerator.
+ *   @accum_v: Accumulated and sent with its length.
+ *   @length_v: Sent as written with a declared length.
+ *   @chunk_v: Sent as written with chunked encoding.
+ *   @close_v: Sent as written and delimited by closing the connection.
+ */
+enum body_e {
+	accum_v,
+	length_v,
+	chunk_v,
+	close_v
+};
+
+/**
+ * Request body framing enumerator.
+ *   @length_frame_v: Within a body of declared length.
+ *   @size_frame_v: Expecting a chunk size line.
+ *   @data_frame_v: Within chunk data.
+ *   @crlf_frame_v: Expecting the line ending after chunk data.
+ *   @trailer_frame_v: Within the trailer of a chunked body.
+ *   @end_frame_v: The body is complete.
+ */
+enum frame_e {
+	length_frame_v,
+	size_frame_v,
+	data_frame_v,
+	crlf_frame_v,
+	trailer_frame_v,
+	end_frame_v
+};
+
+/**
+ * WebSocket opcode enumerator.
+ *   @cont_op_v: Continuation of a fragmented message.
+ *   @text_op_v: Text message.
+ *   @binary_op_v: Binary message.
+ *   @close_op_v: Close.
+ *   @ping_op_v: Ping.
+ *   @pong_op_v: Pong.
+ */
+enum opcode_e {
+	cont_op_v = 0x0,
+	text_op_v = 0x1,
+	binary_op_v = 0x2,
+	close_op_v = 0x8,
+	ping_op_v = 0x9,
+	pong_op_v = 0xA
+};
+
+/**
+ * Wait enumerator, naming each kind of connection deadline.
+ *   @idle_wait_v: Idle between requests.
+ *   @head_wait_v: Receiving a request header.
+ *   @body_wait_v: Receiving a request body.
+ *   @life_wait_v: Connection lifetime.
+ *   @nwait_v: The number of kinds, also meaning no deadline.
+ */
+enum wait_e {
+	idle_wait_v,
+	head_wait_v,
+	body_wait_v,
+	life_wait_v,
+	nwait_v
+};
+
+/*
+ * default definitions
+ */
+#define DEFIDLE	(15*1000000)
+#define DEFHDR	(10*1000000)
+#define DEFBODY	(30*1000000)
+#define DEFLIFE	(600*1000000LL)
+#define DEFMAX	100
+#define DEFPIPE	16
+#define DEFTHRD	0
+#define DEFWORK	0
+#define DEFLENGTH	(1024*1024)
+#define DEFHEAD	(16*1024)
+#define DEFARENA	1024
+#define DEFFLUSH	(16*1024)
+#define DEFWATER	(64*1024)
+#define DEFEVENTS	64
+#define DEFACCEPT	32
+#define DEFPAUSE	(100*1000)
+#define DEFMSG	(1024*1024)
+#define WSGUID	"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+/**
+ * Deadline structure.
+ *   @when: The expiration time.
+ *   @client: The client.
+ *   @list: The list, null if unarmed.
+ *   @prev, next: The previous and next deadlines.
+ */
+struct deadline_t {
+	int64_t when;
+	struct http_client_t *client;
+	struct deadline_list_t *list;
+	struct deadline_t *prev, *next;
+};
+
+/**
+ * Deadline list structure. Every deadline on a list expires a fixed
+ * interval after being armed, so appending keeps the list ordered and
+ * arming, disarming, and finding the next expiration are all constant
+ * time.
+ *   @head, tail: The earliest and latest deadlines.
+ */
+struct deadline_list_t {
+	struct deadline_t *head, *tail;
+};
+
+/**
+ * Event loop structure. Each loop owns a listener and the clients accepted
+ * from it, so that loops share nothing but the configuration and handler.
+ * The listener, notifier, and clients stay registered on a poller, so that
+ * each wakeup only visits the ready connections. Pushed responses expire
+ * at arbitrary times, so their alarms are kept ordered in a tree instead of
+ * the deadline lists.
+ *   @server: The server.
  *   @tcp: The TCP server.
- *   @cnt: The number of active clients.
+ *   @poller: The poller.
  *   @client: The client list.
+ *   @dead: The list of dropped clients awaiting deletion.
+ *   @wait: The deadline lists, one per kind.
+ *   @alarm: The tree of clients with an armed alarm.
+ *   @task: The thread task, null if run by the caller.
+ *   @lock: The lock protecting the completed and signaled lists.
+ *   @wake: The notifier signaled on completed work or a signaled hub.
+ *   @done: The list of clients whose deferred work completed.
+ *   @signal: The list of clients whose hub was signaled.
+ *   @pause: The time accepting resumes after running out of resources, zero
+ *     while accepting.
+ *   @warned: Set once running out of resources is reported, until the
+ *     accept queue is drained again.
  */
-struct http_server_t {
+struct http_loop_t {
+	struct http_server_t *server;
 	struct tcp_server_t *tcp;
+	sys_fd_t poller;
 
-	unsigned int cnt;
+	struct http_client_t *client, *dead;
+
+	struct deadline_list_t wait[nwait_v];
+	struct avltree_root_t alarm;
+	struct sys_task_t *task;
+
+	sys_mutex_t lock;
+	sys_fd_t wake;
+	struct http_client_t *done, *signal;
+
+	int64_t pause;
+	bool warned;
+};
+
+/**
+ * Hub structure. Pushed responses subscribe to a hub, and signaling the hub
+ * from any thread wakes every subscriber on its own loop.
+ *   @lock: The lock protecting the subscriber list.
+ *   @client: The subscriber list.
+ */
+struct http_hub_t {
+	sys_mutex_t lock;
 	struct http_client_t *client;
 };
 
+/**
+ * HTTP server structure.
+ *   @conf: The configuration.
+ *   @func, arg: The handler and argument of the loop threads.
+ *   @lock, cond: The lock and condition of the work queue.
+ *   @stop: The worker stop flag.
+ *   @work, tail: The work queue head and tail reference.
+ *   @worker: The worker threads.
+ *   @nloop: The number of event loops.
+ *   @loop: The event loops.
+ */
+struct http_server_t {
+	struct http_conf_t conf;
+
+	http_handler_f func;
+	void *arg;
+
+	sys_mutex_t lock;
+	sys_cond_t cond;
+	bool stop;
+	struct http_client_t *work, **tail;
+	sys_thread_t *worker;
+
+	unsigned int nloop;
+	struct http_loop_t loop[];
+};
+
 /**
  * Connection structure.
  *   @tcp: The TCP client.
+ *   @conf: The configuration.
  *   @state: The state.
- *   @idx, len: The index and length.
- *   @buf: The buffer.
+ *   @idx: The offset where the header scan resumes.
+ *   @frame: The request body framing.
+ *   @len: The remaining length of the request body or current chunk.
+ *   @nreq: The number of requests answered.
+ *   @loop: The event loop, null if the client is standalone.
+ *   @kind: The kind of the armed request deadline.
+ *   @wreq: The request count when the request deadline was armed.
+ *   @drop: Drop flag, set once the connection must be closed.
+ *   @wait, life: The request and lifetime deadlines.
+ *   @keep, sent: The keep-alive and headers sent flags of the response.
+ *   @status: The response status code.
+ *   @body: The response body type.
+ *   @rem: The remaining length of a declared response.
+ *   @ref, fd, off: The referenced response body, either a buffer or a file
+ *     region, null and negative if none.
+ *   @nref, rdel, rarg: The referenced body length, deleter, and deleter
+ *     argument.
+ *   @hdr, buf, out, data: The header, body, response, and response data
+ *     buffers.
+ *   @arena: The request arena.
  *   @head: The request header.
+ *   @args: The arguments of the current response.
+ *   @stream, sarg, sdel: The stream callback, argument, and deleter.
+ *   @input, iarg, idel: The request body callback, argument, and deleter.
+ *   @work, warg, wdel: The deferred work callback, argument, and deleter.
+ *   @handled: The result of the deferred work.
+ *   @wnext: The next client in the work queue, completed list, or dead
+ *     list.
+ *   @push, parg, pdel: The push callback, argument, and deleter.
+ *   @hub: The hub the push is subscribed to, null if none.
+ *   @hprev, hnext: The previous and next subscribers of the hub.
+ *   @alarm: The alarm time of the push, zero if unarmed.
+ *   @anode: The node in the alarm tree.
+ *   @signaled: The signaled flag, set while on the signaled list.
+ *   @pnext: The next client on the signaled list.
+ *   @msg, marg, mdel: The WebSocket message callback, argument, and
+ *     deleter.
+ *   @mop: The opcode of the fragmented message in progress, continuation
+ *     if none.
+ *   @mwork, mlen: The deferred WebSocket message callback and the length of
+ *     the message, kept in the body buffer while deferred.
+ *   @pinged: The pinged flag, set while a ping awaits any frame in reply.
+ *   @events: The events the client is registered for on the poller.
  *   @prev, next: The previous and next clients.
  */
 struct http_client_t {
 	struct tcp_client_t *tcp;
+	const struct http_conf_t *conf;
 
 	enum state_e state;
-	unsigned int idx, len;
-	struct strbuf_t buf;
+	size_t idx;
+	enum frame_e frame;
+	uint64_t len;
+	unsigned int nreq;
+	struct http_loop_t *loop;
+	enum wait_e kind;
+	unsigned int wreq;
+	bool drop;
+	struct deadline_t wait, life;
+	bool keep, sent;
+	unsigned int status;
+	enum body_e body;
+	uint64_t rem;
+	const void *ref;
+	int fd;
+	int64_t off;
+	size_t nref;
+	delete_f rdel;
+	void *rarg;
+	struct strbuf_t hdr, buf, out, data;
+	struct arena_t arena;
 	struct http_head_t head;
 
+	struct http_args_t args;
+	http_stream_f stream;
+	void *sarg;
+	delete_f sdel;
+
+	http_input_f input;
+	void *iarg;
+	delete_f idel;
+
+	http_work_f work;
+	void *warg;
+	delete_f wdel;
+	bool handled;
+	struct http_client_t *wnext;
+
+	http_push_f push;
+	void *parg;
+	delete_f pdel;
+	struct http_hub_t *hub;
+	struct http_client_t *hprev, *hnext;
+	int64_t alarm;
+	struct avltree_node_t anode;
+	bool signaled;
+	struct http_client_t *pnext;
+
+	http_websock_f msg;
+	void *marg;
+	delete_f mdel;
+	enum opcode_e mop;
+	http_websock_f mwork;
+	size_t mlen;
+	bool pinged;
+
+	enum sys_poll_e events;
 	struct http_client_t *prev, *next;
 };
 
@@ -50,64 +334,227 @@ struct http_client_t {
 /*
  * local declarations
  */
-static void client_resp(struct http_client_t *client, http_handler_f func, void *arg);
+static enum state_e client_offer(struct http_client_t *client, http_handler_f func, void *arg);
+static ssize_t client_body(struct http_client_t *client, const char *data, size_t avail);
+static enum state_e client_resp(struct http_client_t *client, http_handler_f func, void *arg);
+static void client_queue(struct http_client_t *client);
+static void client_args(struct http_client_t *client, const char *body);
+static enum state_e client_finish(struct http_client_t *client, bool handled);
+static bool client_stream(struct http_client_t *client);
+static enum state_e client_push(struct http_client_t *client);
+static ssize_t client_frame(struct http_client_t *client, const char *data, size_t avail);
+static bool client_reply(struct http_client_t *client, bool handled);
+static void client_send(struct http_client_t *client, enum opcode_e op, const char *data, size_t len);
+static void client_close(struct http_client_t *client, unsigned int code);
+static void client_flush(struct http_client_t *client);
+static enum state_e client_end(struct http_client_t *client);
+static void client_release(struct http_client_t *client);
+static int range_parse(const char *range, uint64_t size, uint64_t *off, uint64_t *len);
+static const char *status_reason(unsigned int status);
+static bool client_keep(struct http_client_t *client);
+static void client_wait(struct http_client_t *client);
+static void client_limit(struct http_client_t *client);
+
+static char *loop_proc(struct http_loop_t *loop, struct sys_event_t *event, unsigned int n, http_handler_f func, void *arg);
+static void loop_accept(struct http_loop_t *loop, int64_t now, http_handler_f func, void *arg);
+static void loop_resume(struct http_loop_t *loop);
+static void loop_done(struct http_loop_t *loop, http_handler_f func, void *arg);
+static void loop_signal(struct http_loop_t *loop, http_handler_f func, void *arg);
+static void loop_push(struct http_loop_t *loop, struct http_client_t *client, http_handler_f func, void *arg);
+static void loop_alarm(struct http_loop_t *loop, struct http_client_t *client, int64_t when);
+static void loop_ping(struct http_loop_t *loop, struct http_client_t *client, int64_t now);
+static void loop_watch(struct http_loop_t *loop, struct http_client_t *client);
+static void loop_drop(struct http_loop_t *loop, struct http_client_t *client);
+static void loop_reap(struct http_loop_t *loop);
+static int loop_timeout(struct http_loop_t *loop);
+static void loop_task(sys_fd_t fd, void *arg);
+
+static void *work_proc(void *arg);
+static bool sock_work(struct http_args_t *args, void *arg);
+
+static void deadline_arm(struct deadline_t *wait, struct deadline_list_t *list, int64_t when);
+static void deadline_disarm(struct deadline_t *wait);
+static int alarm_compare(const void *left, const void *right);
+
+static void client_error(struct http_client_t *client, const char *status);
+
+static size_t resp_read(void *ref, void *buf, size_t nbytes);
+static size_t resp_write(void *ref, const void *buf, size_t nbytes);
+static void resp_close(void *ref);
+
+static void head_push(struct http_head_t *head, const char *key, const char *value);
+static enum http_known_e head_id(const char *key, size_t len);
+static bool head_agree(struct http_head_t *head, enum http_known_e id);
+
+static size_t headlen(const char *data, size_t len, size_t *idx);
+static char *nextline(char **str, char *end, size_t *len);
+static char *nexttoken(char **str, char *end, size_t *len);
+static bool hastoken(const char *value, const char *token);
+static void b64enc(char *out, const uint8_t *in, size_t len);
 
-static bool isdelim(int16_t byte);
-static bool iseol(int16_t byte);
-static int16_t skiphspace(const char **str);
+
+/**
+ * Initialize a configuration with the default values.
+ *   &returns: The configuration.
+ */
+struct http_conf_t http_conf_init(void)
+{
+	return (struct http_conf_t){ DEFIDLE, DEFHDR, DEFBODY, DEFLIFE, DEFLENGTH, DEFMAX, DEFPIPE, DEFTHRD, DEFWORK };
+}
 
 
 /**
- * Open an HTTP server.
+ * Open an HTTP server. A server with threads has one listener per thread,
+ * all bound to the same port. A server with workers starts them at once.
  *   @server: Ref. The server.
  *   @port: The port.
+ *   @conf: Optional. The configuration, defaults if null.
  *   &returns: Error.
  */
-char *http_server_open(struct http_server_t **server, uint16_t port)
+char *http_server_open(struct http_server_t **server, uint16_t port, const struct http_conf_t *conf)
 {
-#define onexit if((*server)->tcp != NULL) tcp_server_close((*server)->tcp); free(*server);
-	*server = malloc(sizeof(struct http_server_t));
-	(*server)->tcp = NULL;
-	(*server)->client = NULL;
-	(*server)->cnt = 0;
-	chkfail(tcp_server_open(&(*server)->tcp, port));
-	chkfail(tcp_server_listen((*server)->tcp));
+#define onexit http_server_close(*server);
+	unsigned int i, n;
+
+	n = (conf && (conf->threads > 1)) ? conf->threads : 1;
+
+	*server = malloc(sizeof(struct http_server_t) + n * sizeof(struct http_loop_t));
+	(*server)->conf = conf ? *conf : http_conf_init();
+	(*server)->func = NULL;
+	(*server)->arg = NULL;
+	(*server)->lock = sys_mutex_init(0);
+	(*server)->cond = sys_cond_init(0);
+	(*server)->stop = false;
+	(*server)->work = NULL;
+	(*server)->tail = &(*server)->work;
+	(*server)->worker = NULL;
+	(*server)->nloop = n;
+
+	for(i = 0; i < n; i++) {
+		(*server)->loop[i] = (struct http_loop_t){ *server, NULL, sys_poller_new(), NULL, NULL, { { NULL, NULL } }, avltree_root_init(alarm_compare), NULL, sys_mutex_init(0), sys_notify_new(), NULL, NULL, 0, false };
+		memset((*server)->loop[i].wait, 0x00, sizeof((*server)->loop[i].wait));
+	}
+
+	if((*server)->conf.workers > 0) {
+		(*server)->worker = malloc((*server)->conf.workers * sizeof(sys_thread_t));
+		for(i = 0; i < (*server)->conf.workers; i++)
+			(*server)->worker[i] = sys_thread_create(0, work_proc, *server);
+	}
+
+	for(i = 0; i < n; i++) {
+		chkfail(tcp_server_open(&(*server)->loop[i].tcp, port, (n > 1) ? TCP_REUSEPORT : 0));
+		chkfail(tcp_server_listen((*server)->loop[i].tcp));
+
+		sys_poller_add((*server)->loop[i].poller, tcp_server_poll((*server)->loop[i].tcp), (*server)->loop[i].tcp);
+		sys_poller_add((*server)->loop[i].poller, sys_poll_fd((*server)->loop[i].wake, sys_poll_in_e), &(*server)->loop[i].wake);
+	}
 
 	return NULL;
 #undef onexit
 }
 
 /**
- * Close an HTTP server.
+ * Close an HTTP server, stopping any loop and worker threads. Deferred
+ * work still queued is abandoned.
  *   @server: The server.
  */
 void http_server_close(struct http_server_t *server)
 {
+	unsigned int i;
 	struct http_client_t *cur, *next;
 
-	for(cur = server->client; cur != NULL; cur = next) {
-		next = cur->next;
-		http_client_delete(cur);
-		printf("del?\n");
+	for(i = 0; i < server->nloop; i++) {
+		if(server->loop[i].task != NULL)
+			sys_task_delete(server->loop[i].task);
+	}
+
+	if(server->worker != NULL) {
+		sys_mutex_lock(&server->lock);
+		server->stop = true;
+		sys_cond_broadcast(&server->cond);
+		sys_mutex_unlock(&server->lock);
+
+		for(i = 0; i < server->conf.workers; i++)
+			sys_thread_join(&server->worker[i]);
+
+		free(server->worker);
+	}
+
+	for(i = 0; i < server->nloop; i++) {
+		for(cur = server->loop[i].client; cur != NULL; cur = next) {
+			next = cur->next;
+			http_client_delete(cur);
+		}
+
+		if(server->loop[i].tcp != NULL)
+			tcp_server_close(server->loop[i].tcp);
+
+		sys_mutex_destroy(&server->loop[i].lock);
+		sys_notify_delete(server->loop[i].wake);
+		sys_poller_delete(server->loop[i].poller);
 	}
 
-	tcp_server_close(server->tcp);
+	sys_cond_destroy(&server->cond);
+	sys_mutex_destroy(&server->lock);
 	free(server);
 }
 
+/**
+ * Start the event loop threads of a server. The kernel spreads incoming
+ * connections across the loops, and each loop calls the handler
+ * concurrently with the others, so the handler must be thread-safe.
+ *   @server: The server.
+ *   @func: The handler.
+ *   @arg: The argument.
+ */
+void http_server_start(struct http_server_t *server, http_handler_f func, void *arg)
+{
+	unsigned int i;
+
+	assert(server->conf.threads > 0);
+
+	server->func = func;
+	server->arg = arg;
+
+	for(i = 0; i < server->nloop; i++)
+		server->loop[i].task = sys_task_new(loop_task, &server->loop[i]);
+}
+
 /**
  * Create a new HTTP client.
- *   @tcp: The TCP client.
+ *   @tcp: Consumed. The TCP client.
+ *   @conf: The configuration, which must outlive the client.
  *   &returns: The client.
  */
-struct http_client_t *http_client_new(struct tcp_client_t *tcp)
+struct http_client_t *http_client_new(struct tcp_client_t *tcp, const struct http_conf_t *conf)
 {
 	struct http_client_t *client;
 
 	client = malloc(sizeof(struct http_client_t));
 	client->state = head_v;
+	client->idx = 0;
 	client->tcp = tcp;
+	client->conf = conf;
+	client->nreq = 0;
+	client->loop = NULL;
+	client->kind = nwait_v;
+	client->drop = false;
+	client->wait = (struct deadline_t){ 0, client, NULL, NULL, NULL };
+	client->life = (struct deadline_t){ 0, client, NULL, NULL, NULL };
+	client->hdr = strbuf_init(256);
 	client->buf = strbuf_init(256);
+	client->out = strbuf_init(256);
+	client->data = strbuf_init(256);
+	client->arena = arena_init(DEFARENA);
+	client->head = http_head_init(&client->arena);
+	client->stream = NULL;
+	client->input = NULL;
+	client->ref = NULL;
+	client->fd = -1;
+	client->work = NULL;
+	client->push = NULL;
+	client->msg = NULL;
+	client->events = 0;
 
 	return client;
 }
@@ -118,17 +565,32 @@ struct http_client_t *http_client_new(struct tcp_client_t *tcp)
  */
 void http_client_delete(struct http_client_t *client)
 {
-	if(client->state != head_v)
-		http_head_destroy(&client->head);
+	if((client->state == work_v) || (client->state == stream_v) || (client->input != NULL) || (client->push != NULL) || (client->msg != NULL))
+		client_release(client);
 
+	if((client->work != NULL) && (client->wdel != NULL))
+		client->wdel(client->warg);
+
+	deadline_disarm(&client->wait);
+	deadline_disarm(&client->life);
+
+	http_head_destroy(&client->head);
+	arena_destroy(&client->arena);
+	strbuf_destroy(&client->hdr);
 	strbuf_destroy(&client->buf);
-	tcp_client_delete(client->tcp);
+	strbuf_destroy(&client->out);
+	strbuf_destroy(&client->data);
+	tcp_client_close(client->tcp);
 	free(client);
 }
 
 
 /**
- * Process data on a client.
+ * Process data on a client. Pipelined requests are answered in order
+ * through the output queue; once the number of unsent responses reaches the
+ * pipeline limit, parsing and reading pause until the queue drains. Queued
+ * output is sent before returning, so a response normally leaves in one
+ * call.
  *   @client: The client.
  *   @func: The handler.
  *   @arg: The argument.
@@ -136,372 +598,2500 @@ void http_client_delete(struct http_client_t *client)
  */
 bool http_client_proc(struct http_client_t *client, http_handler_f func, void *arg)
 {
-	char ch;
+	size_t avail, len;
+	const char *data;
 
 	while(true) {
-		if((client->state == done_v) && (tcp_client_queue(client->tcp) == 0))
-			return false;
+		if(client->state == done_v) {
+			tcp_client_limit(client->tcp, 0);
 
-		if(!tcp_client_read(client->tcp, &ch, 1))
+			return tcp_client_flush(client->tcp) && (tcp_client_queue(client->tcp) > 0);
+		}
+		else if(client->state == work_v)
 			break;
+		else if(client->state == stream_v) {
+			if(!client_stream(client)) {
+				if(!tcp_client_flush(client->tcp))
+					return false;
+				else if(tcp_client_queue(client->tcp) > 0)
+					break;
+			}
+
+			continue;
+		}
+		else if(client->state == push_v) {
+			tcp_client_peek(client->tcp, &avail);
+			tcp_client_consume(client->tcp, avail);
+			if(!tcp_client_eof(client->tcp))
+				break;
+
+			client->state = done_v;
+			continue;
+		}
+		else if(client->state == sock_v) {
+			ssize_t ret;
+
+			if(tcp_client_queue(client->tcp) >= DEFWATER) {
+				if(!tcp_client_flush(client->tcp))
+					return false;
+				else if(tcp_client_queue(client->tcp) >= DEFWATER)
+					break;
+			}
+
+			data = tcp_client_peek(client->tcp, &avail);
+			ret = client_frame(client, data, avail);
+			if(ret < 0)
+				continue;
+			else if(ret > 0) {
+				tcp_client_consume(client->tcp, ret);
+				continue;
+			}
+
+			if(!tcp_client_eof(client->tcp))
+				break;
+
+			client->state = done_v;
+			continue;
+		}
+
+		if((client->state == head_v) && (client->conf->pipeline > 0) && (tcp_client_pending(client->tcp) >= client->conf->pipeline)) {
+			if(!tcp_client_flush(client->tcp))
+				return false;
+			else if(tcp_client_pending(client->tcp) >= client->conf->pipeline)
+				break;
+		}
+
+		data = tcp_client_peek(client->tcp, &avail);
 
 		if(client->state == head_v) {
-			if(ch == '\r')
+			if((client->idx == 0) && (avail > 0) && ((data[0] == '\r') || (data[0] == '\n'))) {
+				tcp_client_consume(client->tcp, 1);
 				continue;
+			}
 
-			if((ch == '\n') && (strbuf_last(&client->buf) == '\n')) {
-				const char *len;
+			len = headlen(data, avail, &client->idx);
+			if(len > 0) {
+				char *err;
+				const char *clen, *te, *expect;
 
-				http_head_parse(&client->head, strbuf_finish(&client->buf));
+				client->idx = 0;
+				client->len = 0;
 
-				len = http_head_lookup(&client->head, "Content-Length");
-				if(len != NULL)
-					client->len = strtoul(len, (char **)&len, 0);
-				else
-					client->len = 0;
+				client->hdr.idx = 0;
+				strbuf_addmem(&client->hdr, data, len);
+				tcp_client_consume(client->tcp, len);
+
+				err = http_head_parse(&client->head, client->hdr.arr, len);
+				if(err != NULL) {
+					free(err);
+					client_error(client, "400 Bad Request");
+					continue;
+				}
+
+				te = http_head_known(&client->head, http_transfer_encoding_e);
+				clen = http_head_known(&client->head, http_content_length_e);
+				if(te != NULL) {
+					if(!hastoken(te, "chunked")) {
+						client_error(client, "501 Not Implemented");
+						continue;
+					}
 
-				if(client->len == 0) {
-					client->state = done_v;
-					client_resp(client, func, arg);
+					client->frame = size_frame_v;
+				}
+				else if(clen != NULL) {
+					char *endptr;
+
+					if(!head_agree(&client->head, http_content_length_e)) {
+						client_error(client, "400 Bad Request");
+						continue;
+					}
+
+					errno = 0;
+					client->len = strtoull(clen, &endptr, 10);
+					if((*endptr != '\0') || (endptr == clen) || (errno != 0) || !isdigit(clen[0])) {
+						client_error(client, "400 Bad Request");
+						continue;
+					}
+
+					client->frame = (client->len > 0) ? length_frame_v : end_frame_v;
 				}
 				else
-					client->state = body_v;
+					client->frame = end_frame_v;
+
+				if(client->frame == end_frame_v)
+					client->state = client_resp(client, func, arg);
+				else {
+					client->state = client_offer(client, func, arg);
+					if((client->input == NULL) && (client->frame == length_frame_v) && (client->conf->length > 0) && (client->len > client->conf->length)) {
+						client_error(client, "413 Content Too Large");
+						continue;
+					}
+
+					expect = http_head_lookup(&client->head, "Expect");
+					if((expect != NULL) && hastoken(expect, "100-continue") && (client->head.proto != NULL) && (strcmp(client->head.proto, "HTTP/1.1") == 0))
+						tcp_client_write(client->tcp, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+				}
 
+				continue;
+			}
+			else if(avail > DEFHEAD) {
+				client_error(client, "431 Request Header Fields Too Large");
+				continue;
 			}
-			else if((ch == '\n') || ((ch >= 0x20) && (ch <= 0x7F)))
-				strbuf_addch(&client->buf, ch);
 		}
 		else if(client->state == body_v) {
-			strbuf_addch(&client->buf, ch);
-			if(client->buf.idx == client->len) {
-				client->state = done_v;
-				client_resp(client, func, arg);
+			ssize_t ret;
+
+			ret = client_body(client, data, avail);
+			if(ret < 0) {
+				client_error(client, "400 Bad Request");
+				continue;
+			}
+
+			tcp_client_consume(client->tcp, ret);
+
+			if((client->input == NULL) && (client->conf->length > 0) && ((client->buf.idx > client->conf->length) || ((client->frame == data_frame_v) && (client->len > client->conf->length - client->buf.idx)))) {
+				client_error(client, "413 Content Too Large");
+				continue;
+			}
+
+			if(client->frame == end_frame_v) {
+				if(client->input != NULL)
+					client->state = client_finish(client, client->handled);
+				else
+					client->state = client_resp(client, func, arg);
+
+				continue;
 			}
 		}
+
+		if(!tcp_client_eof(client->tcp))
+			break;
+
+		client->state = done_v;
 	}
 
+	if(!tcp_client_flush(client->tcp))
+		return false;
+
+	client_wait(client);
+	client_limit(client);
+
 	return true;
 }
 
 /**
- * Respond to a client.
+ * Offer a request to the handler before its body is received. The handler
+ * sees a null body and may take the body as it arrives with
+ * 'http_args_input'; otherwise the offer is withdrawn and the body is
+ * buffered for a regular response.
  *   @client: The client.
  *   @func: The handler function.
  *   @arg: The argument.
+ *   &returns: The next state.
  */
-static void client_resp(struct http_client_t *client, http_handler_f func, void *arg)
+static enum state_e client_offer(struct http_client_t *client, http_handler_f func, void *arg)
 {
-	bool suc;
-	char *buf;
-	struct io_file_t file;
-	struct http_args_t args;
-	struct http_pair_t *pair;
-	size_t len = 0;
-
-	file = io_file_fd(tcp_client_sock(client->tcp));
+	bool handled;
 
-	args.body = strbuf_finish(&client->buf);
-	args.req = client->head;
-	args.resp = http_head_init();
-	args.file = io_file_accum(&buf, &len);
-	suc = func(args.req.path, &args, arg);
-	io_file_close(args.file);
+	client->nreq++;
+	client_args(client, NULL);
 
-	if(suc) {
-		char slen[32];
-
-		hprintf(file, "HTTP/1.1 200 OK\n");
-
-		if(http_head_lookup(&args.resp, "Content-Type") == NULL)
-			http_head_add(&args.resp, "Content-Type", "application/xhtml+xml");
-
-		snprintf(slen, sizeof(slen), "%zu", len);
-		http_head_add(&args.resp, "Content-Length", slen);
-		http_head_add(&args.resp, "Connection", "close");
-
-		for(pair = args.resp.pair; pair != NULL; pair = pair->next)
-			hprintf(file, "%s: %s\n", pair->key, pair->value);
-
-		hprintf(file, "\n");
-		io_file_write(file, buf, len);
+	handled = func(client->args.req.path, &client->args, arg);
+	if(client->input != NULL)
+		client->handled = handled;
+	else {
+		http_head_destroy(&client->args.resp);
+		client->nreq--;
 	}
-	else
-		hprintf(file, "HTTP/1.1 404 Not Found\nContent-Length: 9\nConnection: close\n\nNot Found");
 
-	free(buf);
-	io_file_close(file);
-	http_head_destroy(&args.resp);
+	return body_v;
 }
 
-
 /**
- * Process data on the server.
- *   @server: The server.
- *   @fds: The file descriptor information returned from poll.
- *   @func: The handler.
- *   @arg: The argument.
- *   &returns: Error.
+ * Process the request body available on a client, decoding chunked
+ * framing. Body data is passed to the input callback as it arrives, or
+ * buffered if the handler did not take the body. Once the body is complete,
+ * the input callback is called a last time with no data.
+ *   @client: The client.
+ *   @data: The available data.
+ *   @avail: The number of bytes available.
+ *   &returns: The number of bytes consumed, or negative if malformed.
  */
-char *http_server_proc(struct http_server_t *server, struct sys_poll_t *fds, http_handler_f func, void *arg)
+static ssize_t client_body(struct http_client_t *client, const char *data, size_t avail)
 {
-#define onexit
-	bool cont[server->cnt];
-	unsigned int i;
-	struct http_client_t *client, **cur;
+	char *endptr;
+	const char *end;
+	size_t len, used = 0;
+
+	while(client->frame != end_frame_v) {
+		if((client->frame == length_frame_v) || (client->frame == data_frame_v)) {
+			len = ((avail - used) < client->len) ? (avail - used) : client->len;
+			if(len == 0)
+				break;
+
+			if(client->input == NULL)
+				strbuf_addmem(&client->buf, data + used, len);
+			else if(!client->input(&client->args, data + used, len, client->iarg)) {
+				client->keep = false;
+				client->frame = end_frame_v;
+
+				return avail;
+			}
 
-	for(i = 0, client = server->client; client != NULL; i++, client = client->next) {
-		assert(i < server->cnt);
+			used += len;
+			client->len -= len;
+			if(client->len == 0)
+				client->frame = (client->frame == length_frame_v) ? end_frame_v : crlf_frame_v;
 
-		cont[i] = true;
-		if((fds != NULL) && (fds[i+1].revents == 0))
-		if(fds[i+1].revents == 0)
 			continue;
+		}
 
-		tcp_client_proc(client->tcp, fds[i+1].revents);
-		cont[i] = http_client_proc(client, func, arg);
-	}
-
-	for(i = 0, cur = &server->client; *cur != NULL; i++) {
-		if(!cont[i]) {
-			client = *cur;
-			*cur = (*cur)->next;
+		end = memchr(data + used, '\n', avail - used);
+		if(end == NULL)
+			return ((avail - used) > DEFHEAD) ? -1 : (ssize_t)used;
 
-			http_client_delete(client);
-			server->cnt--;
-		}
-		else
-			cur = &(*cur)->next;
-	}
+		len = end + 1 - (data + used);
 
-	if((fds == NULL) || (fds[0].revents != 0)) {
-		sys_sock_t sock;
-		struct http_client_t *client;
+		if(client->frame == size_frame_v) {
+			errno = 0;
+			client->len = strtoull(data + used, &endptr, 16);
+			if((endptr == data + used) || !isxdigit(data[used]) || (tolower(data[used + 1]) == 'x') || (errno != 0) || ((*endptr != ';') && (*endptr != '\r') && (*endptr != '\n')))
+				return -1;
 
-		chkfail(tcp_server_accept(server->tcp, &sock));
+			client->frame = (client->len > 0) ? data_frame_v : trailer_frame_v;
+		}
+		else if((len == 1) || ((len == 2) && (data[used] == '\r')))
+			client->frame = (client->frame == crlf_frame_v) ? size_frame_v : end_frame_v;
+		else if(client->frame == crlf_frame_v)
+			return -1;
 
-		client = http_client_new(tcp_client_new(sock));
-		client->next = server->client;
-		server->client = client;
-		server->cnt++;
+		used += len;
+	}
 
-		http_client_proc(client, func, arg);
+	if((client->frame == end_frame_v) && (client->input != NULL)) {
+		if(!client->input(&client->args, NULL, 0, client->iarg))
+			client->keep = false;
 	}
 
-	return NULL;
-#undef onexit
+	return used;
 }
 
 /**
- * Retrieve the polling file descriptor set from the HTTP server.
- *   @server: The server.
- *   @poll: Optional. The pointer where to store the poll information.
- *   &returns: The number of file descriptors.
+ * Respond to a client. An accumulated response is queued as a single
+ * write; a declared or chunked response has already been sent in part by
+ * the time the handler returns. On a persistent connection, the client is
+ * reset to receive the next request, releasing the request arena at once.
+ * A handler that defers its work leaves the client waiting on a worker.
+ *   @client: The client.
+ *   @func: The handler function.
+ *   @arg: The argument.
+ *   &returns: The next state.
  */
-unsigned int http_server_poll(struct http_server_t *server, struct sys_poll_t *poll)
+static enum state_e client_resp(struct http_client_t *client, http_handler_f func, void *arg)
 {
-	unsigned int i;
-	struct http_client_t *client;
+	bool handled;
+
+	client->nreq++;
+	client_args(client, strbuf_finish(&client->buf));
 
-	if(poll != NULL) {
-		poll[0] = tcp_server_poll(server->tcp);
+	handled = func(client->args.req.path, &client->args, arg);
+	if(client->work != NULL) {
+		client_queue(client);
 
-		for(i = 1, client = server->client; client != NULL; i++, client = client->next)
-			poll[i] = tcp_client_poll(client->tcp);
+		return work_v;
 	}
 
-	return 1 + server->cnt;
+	return client_finish(client, handled);
 }
 
 /**
- * Initialize a header structure.
- *   &returns: The header structure.
+ * Queue a client with deferred work to the workers.
+ *   @client: The client.
  */
-struct http_head_t http_head_init(void)
+static void client_queue(struct http_client_t *client)
 {
-	struct http_head_t head;
-
-	head.verb = head.path = head.proto = NULL;
-	head.pair = NULL;
-
-	return head;
+	struct http_server_t *server = client->loop->server;
+
+	sys_mutex_lock(&server->lock);
+	client->wnext = NULL;
+	*server->tail = client;
+	server->tail = &client->wnext;
+	sys_cond_signal(&server->cond);
+	sys_mutex_unlock(&server->lock);
 }
 
 /**
- * Destroy a header sturcture.
- *   @head: The header.
+ * Set up the arguments of a new response.
+ *   @client: The client.
+ *   @body: The request body, null if not yet received.
  */
-void http_head_destroy(struct http_head_t *head)
+static void client_args(struct http_client_t *client, const char *body)
 {
-	struct http_pair_t *cur;
-
-	for(cur = head->pair; cur != NULL; cur = head->pair) {
-		head->pair = cur->next;
-		free(cur->key);
-		free(cur->value);
-		free(cur);
-	}
-
-	erase(head->verb);
-	erase(head->path);
-	erase(head->proto);
+	static const struct io_file_i iface = { resp_read, resp_write, resp_close };
+
+	client->keep = client_keep(client);
+	client->sent = false;
+	client->status = 200;
+	client->body = accum_v;
+	client->data.idx = 0;
+
+	client->args.file = (struct io_file_t){ client, &iface };
+	client->args.body = body;
+	client->args.req = client->head;
+	client->args.resp = http_head_init(&client->arena);
+	client->args.client = client;
 }
 
-
-
 /**
- * Lookup the value from the header.
- *   @head: The ehader.
- *   @key: The key.
- *   &returns: The value or null.
+ * Finish responding to a client once the handler or its deferred work
+ * completes.
+ *   @client: The client.
+ *   @handled: The handled flag.
+ *   &returns: The next state.
  */
-const char *http_head_lookup(struct http_head_t *head, const char *key)
+static enum state_e client_finish(struct http_client_t *client, bool handled)
 {
-	struct http_pair_t *pair;
+	if(!handled) {
+		if(client->sent) {
+			client->body = close_v;
+			client->keep = false;
+		}
+		else {
+			client->out.idx = 0;
+			hprintf(io_file_strbuf(&client->out), "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\nConnection: %s\r\n\r\nNot Found", client->keep ? "keep-alive" : "close");
+			tcp_client_write(client->tcp, client->out.arr, client->out.idx);
+			client_release(client);
+
+			client->body = accum_v;
+			client->sent = true;
+			client->data.idx = 0;
+		}
+	}
+	else if(client->stream != NULL) {
+		client_flush(client);
 
-	for(pair = head->pair; pair != NULL; pair = pair->next) {
-		if(strcmp(key, pair->key) == 0)
-			return pair->value;
+		return stream_v;
+	}
+	else if(client->push != NULL)
+		return client_push(client);
+	else if(client->msg != NULL) {
+		client->data.idx = 0;
+		client_flush(client);
+		deadline_disarm(&client->life);
+
+		return sock_v;
 	}
 
-	return NULL;
+	return client_end(client);
 }
 
 /**
- * Add a key-value pair to the header.
- *   @head: The header.
- *   @key: The key.
- *   @value: The value.
+ * Continue a streamed response while the output queue is below the
+ * low-water mark.
+ *   @client: The client.
+ *   &returns: True if the response completed, false if waiting on the
+ *     output queue to drain.
  */
-void http_head_add(struct http_head_t *head, const char *key, const char *value)
+static bool client_stream(struct http_client_t *client)
 {
-	struct http_pair_t **pair;
+	while(tcp_client_queue(client->tcp) < DEFWATER) {
+		if(!client->stream(client->args.file, client->sarg)) {
+			client->state = client_end(client);
 
-	for(pair = &head->pair; *pair != NULL; pair = &(*pair)->next) {
-		if(strcmp(key, (*pair)->key) == 0)
-			break;
-	}
+			return true;
+		}
 
-	if(*pair == NULL) {
-		*pair = malloc(sizeof(struct http_pair_t));
-		(*pair)->key = strdup(key);
-		(*pair)->value = strdup(value);
-		(*pair)->next = NULL;
+		client_flush(client);
 	}
-	else
-		strset(&(*pair)->value, mprintf("%s,%s", (*pair)->value, value));
-}
 
+	return false;
+}
 
 /**
- * Parse a header.
- *   @head: Ref. The header.
- *   @str: The string.
- *   &returns: The error.
+ * Push the next events of a response, arming the alarm it requests and
+ * releasing the connection from the lifetime limit.
+ *   @client: The client.
+ *   &returns: The next state.
  */
-char *http_head_parse(struct http_head_t *head, const char *str)
+static enum state_e client_push(struct http_client_t *client)
 {
-#define onexit strbuf_destroy(&buf); http_head_destroy(head); *head = http_head_init();
-	struct strbuf_t buf;
+	int64_t when;
 
-	*head = http_head_init();
-	buf = strbuf_init(32);
+	when = client->push(client->args.file, client->parg);
+	if(when < 0)
+		return client_end(client);
+	else if((when > 0) && (when <= sys_utime()))
+		when = sys_utime() + 1;
 
-	if(iseol(skiphspace(&str)))
-		fail("Invalid header. Missing verb.");
+	client_flush(client);
+	loop_alarm(client->loop, client, when);
+	deadline_disarm(&client->life);
 
-	while(!isdelim(*str))
-		strbuf_addch(&buf, *str++);
+	return push_v;
+}
 
-	head->verb = strbuf_done(&buf);
-	buf = strbuf_init(32);
+/**
+ * Process a WebSocket frame from the received data. Client frames must be
+ * masked and are only processed once complete; control frames are answered
+ * at once, and data frames are gathered until their message is complete
+ * and passed to the callback, whose output is sent back as one message.
+ *   @client: The client.
+ *   @data: The received data.
+ *   @avail: The number of bytes available.
+ *   &returns: The number of bytes consumed, zero if the frame is incomplete,
+ *     or negative if the connection is closing.
+ */
+static ssize_t client_frame(struct http_client_t *client, const char *data, size_t avail)
+{
+	bool fin, handled;
+	enum opcode_e op;
+	uint64_t len;
+	size_t i, size, hdr = 2;
+	uint8_t mask[4];
+	char *ptr;
+	const uint8_t *raw = (const uint8_t *)data;
+
+	if(avail < 2)
+		return 0;
+
+	fin = raw[0] & 0x80;
+	op = raw[0] & 0x0F;
+	len = raw[1] & 0x7F;
+
+	if((raw[0] & 0x70) || !(raw[1] & 0x80)) {
+		client_close(client, 1002);
+		return -1;
+	}
+	else if(op & 0x08) {
+		if(!fin || (len > 125) || ((op != close_op_v) && (op != ping_op_v) && (op != pong_op_v))) {
+			client_close(client, 1002);
+			return -1;
+		}
+	}
+	else if((op > binary_op_v) || ((op == cont_op_v) == (client->mop == cont_op_v))) {
+		client_close(client, 1002);
+		return -1;
+	}
 
-	if(iseol(skiphspace(&str)))
-		fail("Invalid header. Missing path.");
+	if(len == 126) {
+		if(avail < 4)
+			return 0;
 
-	while(!isdelim(*str))
-		strbuf_addch(&buf, *str++);
+		len = ((uint64_t)raw[2] << 8) | raw[3];
+		hdr = 4;
+	}
+	else if(len == 127) {
+		if(avail < 10)
+			return 0;
 
-	head->path = strbuf_done(&buf);
-	buf = strbuf_init(32);
+		len = 0;
+		for(i = 0; i < 8; i++)
+			len = (len << 8) | raw[2 + i];
 
-	if(iseol(skiphspace(&str)))
-		fail("Invalid header. Missing protocol.");
+		hdr = 10;
+	}
 
-	while(!isdelim(*str))
-		strbuf_addch(&buf, *str++);
+	if(!(op & 0x08) && (len > DEFMSG - client->buf.idx)) {
+		client_close(client, 1009);
+		return -1;
+	}
+	else if(avail < hdr + 4 + len)
+		return 0;
 
-	head->proto = strbuf_done(&buf);
+	size = hdr + 4 + len;
+	memcpy(mask, raw + hdr, 4);
+	client->nreq++;
+	client->pinged = false;
 
-	if(!iseol(skiphspace(&str)))
-		fail("Invalid header. Invalid request.");
+	if(op & 0x08) {
+		char ctl[125];
 
-	while(true) {
-		char *key, *value;
+		for(i = 0; i < len; i++)
+			ctl[i] = data[hdr + 4 + i] ^ mask[i % 4];
 
-		while((*str == '\n') || (*str == '\r'))
-			str++;
+		if(op == ping_op_v)
+			client_send(client, pong_op_v, ctl, len);
+		else if(op == close_op_v) {
+			client_send(client, close_op_v, ctl, (len >= 2) ? 2 : 0);
+			client->state = done_v;
+		}
 
-		if(*str <= 0)
-			break;
+		return size;
+	}
 
-		buf = strbuf_init(32);
-		while(*str != ':') {
-			if(iseol(*str))
-				fail("Invalid header. Missing value.");
+	strbuf_addmem(&client->buf, data + hdr + 4, len);
+	ptr = client->buf.arr + client->buf.idx - len;
+	for(i = 0; i < len; i++)
+		ptr[i] ^= mask[i % 4];
 
-			strbuf_addch(&buf, *str++);
-		}
+	if(!fin) {
+		if(op != cont_op_v)
+			client->mop = op;
 
-		key = strbuf_done(&buf);
-		str++;
-		skiphspace(&str);
+		return size;
+	}
 
-		buf = strbuf_init(32);
-		while(!iseol(*str))
-			strbuf_addch(&buf, *str++);
+	client->mlen = client->buf.idx;
+	client->mop = cont_op_v;
+	client->data.idx = 0;
 
-		value = strbuf_done(&buf);
-		http_head_add(head, key, value);
+	handled = client->msg(client->args.file, strbuf_finish(&client->buf), client->mlen, client->marg);
+	if(client->work != NULL) {
+		client->data.idx = 0;
+		client->state = work_v;
+		client_queue(client);
 
-		free(key);
-		free(value);
+		return size;
 	}
 
-	return NULL;
-#undef onexit
+	return client_reply(client, handled) ? (ssize_t)size : -1;
 }
 
-
 /**
- * Check if a byte is a delimiter (space or end-of-stream).
- *   @byte: The byte.
- *   &returns: True if delimiter.
+ * Reply to a WebSocket message once handled, sending anything written as
+ * one text message, or closing the connection if the message failed.
+ *   @client: The client.
+ *   @handled: The result of the message callback.
+ *   &returns: True if the connection continues.
  */
-static bool isdelim(int16_t byte)
+static bool client_reply(struct http_client_t *client, bool handled)
 {
-	return isspace(byte) || (byte <= 0);
+	if(!handled) {
+		client_close(client, 1000);
+		return false;
+	}
+
+	if(client->data.idx > 0)
+		client_send(client, text_op_v, client->data.arr, client->data.idx);
+
+	client->data.idx = 0;
+	client->state = sock_v;
+
+	return true;
 }
 
 /**
- * Check if a byte is end end-of-line or end-of-stream.
- *   @byte: The byte.
- *   &returns: True if end-of-line.
+ * Send a WebSocket frame to a client, unmasked and unfragmented.
+ *   @client: The client.
+ *   @op: The opcode.
+ *   @data: The payload.
+ *   @len: The payload length.
  */
-static bool iseol(int16_t byte)
+static void client_send(struct http_client_t *client, enum opcode_e op, const char *data, size_t len)
 {
-	return (byte == '\n') || (byte == '\r') || (byte < 0);
+	unsigned int i;
+	uint8_t hdr[10];
+	size_t n;
+
+	hdr[0] = 0x80 | op;
+	if(len < 126) {
+		hdr[1] = len;
+		n = 2;
+	}
+	else if(len < 65536) {
+		hdr[1] = 126;
+		hdr[2] = len >> 8;
+		hdr[3] = len;
+		n = 4;
+	}
+	else {
+		hdr[1] = 127;
+		for(i = 0; i < 8; i++)
+			hdr[2 + i] = (uint64_t)len >> (56 - 8 * i);
+
+		n = 10;
+	}
+
+	tcp_client_write(client->tcp, hdr, n);
+	if(len > 0)
+		tcp_client_write(client->tcp, data, len);
 }
 
 /**
- * Skip spaces from an input.
- *   @input: The input.
- *   @byte: The current byte.
- *   &returns: The next byte after spaces.
+ * Close a WebSocket connection with a status code once the close frame is
+ * sent.
+ *   @client: The client.
+ *   @code: The status code.
  */
-static int16_t skiphspace(const char **str)
+static void client_close(struct http_client_t *client, unsigned int code)
 {
-	while((**str == ' ') || (**str == '\t'))
-		(*str)++;
+	char status[2] = { code >> 8, code & 0xFF };
 
-	return **str;
+	client_send(client, close_op_v, status, 2);
+	client->state = done_v;
 }
+
+/**
+ * Flush the pending response data into the output queue, preceded by the
+ * headers if not yet sent.
+ *   @client: The client.
+ */
+static void client_flush(struct http_client_t *client)
+{
+	size_t len = client->data.idx;
+	struct io_file_t file = io_file_strbuf(&client->out);
+
+	client->out.idx = 0;
+
+	if((client->body == length_v) && (len > client->rem)) {
+		len = client->rem;
+		client->keep = false;
+	}
+
+	if(!client->sent) {
+		unsigned int i;
+		char slen[32];
+		struct http_pair_t *pair;
+		struct http_head_t *resp = &client->args.resp;
+
+		hprintf(file, "HTTP/1.1 %u %s\r\n", client->status, status_reason(client->status));
+
+		if((http_head_lookup(resp, "Content-Type") == NULL) && (client->status != 304) && (client->status != 101))
+			http_head_add(resp, "Content-Type", "application/xhtml+xml");
+
+		if((client->status == 304) || (client->status == 101))
+			;
+		else if(client->body == accum_v) {
+			snprintf(slen, sizeof(slen), "%zu", len);
+			http_head_add(resp, "Content-Length", slen);
+		}
+		else if(client->body == length_v) {
+			snprintf(slen, sizeof(slen), "%llu", (unsigned long long)client->rem);
+			http_head_add(resp, "Content-Length", slen);
+		}
+		else if(client->body == chunk_v)
+			http_head_add(resp, "Transfer-Encoding", "chunked");
+
+		if(client->status == 101)
+			http_head_add(resp, "Connection", "Upgrade");
+		else
+			http_head_add(resp, "Connection", client->keep ? "keep-alive" : "close");
+
+		for(i = 0; (pair = http_head_get(resp, i)) != NULL; i++)
+			hprintf(file, "%s: %s\r\n", pair->key, pair->value);
+
+		hprintf(file, "\r\n");
+		client->sent = true;
+	}
+
+	if((client->body == chunk_v) && (len > 0)) {
+		hprintf(file, "%zx\r\n", len);
+		strbuf_addmem(&client->out, client->data.arr, len);
+		strbuf_addmem(&client->out, "\r\n", 2);
+		len = 0;
+	}
+
+	if(client->out.idx > 0)
+		tcp_client_write(client->tcp, client->out.arr, client->out.idx);
+
+	if(len > 0)
+		tcp_client_write(client->tcp, client->data.arr, len);
+
+	if(client->body == length_v)
+		client->rem -= len;
+
+	client->data.idx = 0;
+
+	if(client->ref != NULL)
+		tcp_client_writeref(client->tcp, client->ref, client->nref, client->rdel, client->rarg);
+	else if(client->fd >= 0)
+		tcp_client_sendfile(client->tcp, client->fd, client->off, client->nref, client->rdel, client->rarg);
+	else
+		return;
+
+	client->rem -= client->nref;
+	client->ref = NULL;
+	client->fd = -1;
+}
+
+/**
+ * Complete the current response and reset the client for the next
+ * request.
+ *   @client: The client.
+ *   &returns: The next state.
+ */
+static enum state_e client_end(struct http_client_t *client)
+{
+	client_flush(client);
+
+	if(client->body == chunk_v)
+		tcp_client_write(client->tcp, "0\r\n\r\n", 5);
+	else if((client->body == length_v) && (client->rem > 0))
+		client->keep = false;
+
+	client_release(client);
+	http_head_destroy(&client->head);
+	arena_reset(&client->arena);
+	client->buf.idx = 0;
+
+	return client->keep ? head_v : done_v;
+}
+
+/**
+ * Release the response of a client, including any stream.
+ *   @client: The client.
+ */
+static void client_release(struct http_client_t *client)
+{
+	if(client->stream != NULL) {
+		if(client->sdel != NULL)
+			client->sdel(client->sarg);
+
+		client->stream = NULL;
+	}
+
+	if(client->input != NULL) {
+		if(client->idel != NULL)
+			client->idel(client->iarg);
+
+		client->input = NULL;
+	}
+
+	if(client->msg != NULL) {
+		if(client->mdel != NULL)
+			client->mdel(client->marg);
+
+		client->msg = NULL;
+	}
+
+	if(client->push != NULL) {
+		struct http_loop_t *loop = client->loop;
+
+		if(client->hub != NULL) {
+			sys_mutex_lock(&client->hub->lock);
+
+			if(client->hprev != NULL)
+				client->hprev->hnext = client->hnext;
+			else
+				client->hub->client = client->hnext;
+
+			if(client->hnext != NULL)
+				client->hnext->hprev = client->hprev;
+
+			sys_mutex_unlock(&client->hub->lock);
+		}
+
+		sys_mutex_lock(&loop->lock);
+
+		if(client->signaled) {
+			struct http_client_t **ref;
+
+			for(ref = &loop->signal; *ref != client; ref = &(*ref)->pnext)
+				assert(*ref != NULL);
+
+			*ref = client->pnext;
+		}
+
+		sys_mutex_unlock(&loop->lock);
+
+		loop_alarm(loop, client, 0);
+
+		if(client->pdel != NULL)
+			client->pdel(client->parg);
+
+		client->push = NULL;
+	}
+
+	if((client->ref != NULL) || (client->fd >= 0)) {
+		if(client->rdel != NULL)
+			client->rdel(client->rarg);
+
+		client->ref = NULL;
+		client->fd = -1;
+	}
+
+	http_head_destroy(&client->args.resp);
+}
+
+/**
+ * Arm a deadline by appending it to a list. The list interval must be the
+ * same for every deadline on it.
+ *   @wait: The deadline.
+ *   @list: The list.
+ *   @when: The expiration time.
+ */
+static void deadline_arm(struct deadline_t *wait, struct deadline_list_t *list, int64_t when)
+{
+	wait->when = when;
+	wait->list = list;
+	wait->prev = list->tail;
+	wait->next = NULL;
+
+	if(list->tail != NULL)
+		list->tail->next = wait;
+	else
+		list->head = wait;
+
+	list->tail = wait;
+}
+
+/**
+ * Disarm a deadline, removing it from its list if armed.
+ *   @wait: The deadline.
+ */
+static void deadline_disarm(struct deadline_t *wait)
+{
+	if(wait->list == NULL)
+		return;
+
+	if(wait->prev != NULL)
+		wait->prev->next = wait->next;
+	else
+		wait->list->head = wait->next;
+
+	if(wait->next != NULL)
+		wait->next->prev = wait->prev;
+	else
+		wait->list->tail = wait->prev;
+
+	wait->list = NULL;
+}
+
+/**
+ * Compare two clients by their alarm time, breaking ties by address.
+ *   @left: The left client.
+ *   @right: The right client.
+ *   &returns: Their order.
+ */
+static int alarm_compare(const void *left, const void *right)
+{
+	const struct http_client_t *lclient = left, *rclient = right;
+
+	if(lclient->alarm < rclient->alarm)
+		return -1;
+	else if(lclient->alarm > rclient->alarm)
+		return 1;
+	else
+		return compare_ptr(left, right);
+}
+
+
+/**
+ * Parse a single byte range of the form 'bytes=first-last', 'bytes=first-'
+ * or 'bytes=-suffix'.
+ *   @range: Optional. The range header value.
+ *   @size: The entity size.
+ *   @off: Out. The range offset.
+ *   @len: Out. The range length.
+ *   &returns: Positive if a range was parsed, zero if the header is absent
+ *     or ignored, negative if unsatisfiable.
+ */
+static int range_parse(const char *range, uint64_t size, uint64_t *off, uint64_t *len)
+{
+	char *end;
+	unsigned long long first, last;
+
+	if((range == NULL) || (strncmp(range, "bytes=", 6) != 0) || (strchr(range, ',') != NULL))
+		return 0;
+
+	range += 6;
+	if(*range == '-') {
+		if(!isdigit(range[1]))
+			return 0;
+
+		errno = 0;
+		last = strtoull(range + 1, &end, 10);
+		if((*end != '\0') || (errno != 0))
+			return 0;
+		else if((last == 0) || (size == 0))
+			return -1;
+
+		*len = (last < size) ? last : size;
+		*off = size - *len;
+
+		return 1;
+	}
+
+	if(!isdigit(*range))
+		return 0;
+
+	errno = 0;
+	first = strtoull(range, &end, 10);
+	if((*end != '-') || (errno != 0))
+		return 0;
+
+	range = end + 1;
+	if(*range == '\0')
+		last = UINT64_MAX;
+	else {
+		if(!isdigit(*range))
+			return 0;
+
+		last = strtoull(range, &end, 10);
+		if((*end != '\0') || (errno != 0) || (last < first))
+			return 0;
+	}
+
+	if(first >= size)
+		return -1;
+
+	if(last >= size)
+		last = size - 1;
+
+	*off = first;
+	*len = last - first + 1;
+
+	return 1;
+}
+
+/**
+ * Retrieve the reason phrase of a status code.
+ *   @status: The status code.
+ *   &returns: The reason phrase.
+ */
+static const char *status_reason(unsigned int status)
+{
+	switch(status) {
+	case 101: return "Switching Protocols";
+	case 200: return "OK";
+	case 204: return "No Content";
+	case 206: return "Partial Content";
+	case 304: return "Not Modified";
+	case 400: return "Bad Request";
+	case 404: return "Not Found";
+	case 413: return "Content Too Large";
+	case 416: return "Range Not Satisfiable";
+	case 500: return "Internal Server Error";
+	default: return "Unknown";
+	}
+}
+
+/**
+ * Determine if a client connection persists after the current request.
+ * HTTP/1.1 connections persist unless closed by the client, and older
+ * connections only persist when explicitly requested. A request carrying
+ * both a transfer coding and a length never persists, since another hop
+ * may have framed it differently.
+ *   @client: The client.
+ *   &returns: True if kept alive.
+ */
+static bool client_keep(struct http_client_t *client)
+{
+	const char *conn;
+
+	if((client->conf->max > 0) && (client->nreq >= client->conf->max))
+		return false;
+
+	if((http_head_known(&client->head, http_transfer_encoding_e) != NULL) && (http_head_known(&client->head, http_content_length_e) != NULL))
+		return false;
+
+	conn = http_head_known(&client->head, http_connection_e);
+	if((conn != NULL) && hastoken(conn, "close"))
+		return false;
+	else if((client->head.proto != NULL) && (strcmp(client->head.proto, "HTTP/1.1") == 0))
+		return true;
+	else
+		return (conn != NULL) && hastoken(conn, "keep-alive");
+}
+
+/**
+ * Arm the request deadline matching the state of a client. A deadline is
+ * armed once when its phase begins or a request is answered, and is not
+ * extended by partial progress, so that trickling bytes cannot hold a
+ * connection open. No request
+ * deadline applies while a response is in progress or queued.
+ *   @client: The client.
+ */
+static void client_wait(struct http_client_t *client)
+{
+	enum wait_e kind;
+	int64_t limit = 0;
+	const struct http_conf_t *conf = client->conf;
+
+	if(client->loop == NULL)
+		return;
+
+	if(client->state == body_v)
+		kind = body_wait_v;
+	else if(client->state == sock_v)
+		kind = idle_wait_v;
+	else if((client->state != head_v) || (tcp_client_queue(client->tcp) > 0))
+		kind = nwait_v;
+	else if((client->nreq > 0) && (client->idx == 0) && (tcp_client_avail(client->tcp) == 0))
+		kind = idle_wait_v;
+	else
+		kind = head_wait_v;
+
+	switch(kind) {
+	case idle_wait_v: limit = conf->idle; break;
+	case head_wait_v: limit = conf->head; break;
+	case body_wait_v: limit = conf->body; break;
+	default: break;
+	}
+
+	if(limit == 0)
+		kind = nwait_v;
+
+	if((kind == client->kind) && (client->wreq == client->nreq))
+		return;
+
+	deadline_disarm(&client->wait);
+	if(kind != nwait_v)
+		deadline_arm(&client->wait, &client->loop->wait[kind], sys_utime() + limit);
+
+	client->kind = kind;
+	client->wreq = client->nreq;
+}
+
+/**
+ * Limit the input buffered on a client to what its state can consume.
+ * Reading stops while parsing is paused, whether on the pipeline limit, a
+ * streamed response, or WebSocket output above the watermark; otherwise the
+ * unparsed input is capped just past the largest unit the state accepts,
+ * so that an oversized header or frame is still detected.
+ *   @client: The client.
+ */
+static void client_limit(struct http_client_t *client)
+{
+	size_t limit;
+
+	switch(client->state) {
+	case head_v:
+		if((client->conf->pipeline > 0) && (tcp_client_pending(client->tcp) >= client->conf->pipeline))
+			limit = 0;
+		else
+			limit = DEFHEAD + 1;
+
+		break;
+
+	case body_v:
+	case push_v:
+		limit = DEFHEAD + 1;
+		break;
+
+	case sock_v:
+		limit = (tcp_client_queue(client->tcp) >= DEFWATER) ? 0 : (DEFMSG + 15);
+		break;
+
+	default:
+		limit = 0;
+		break;
+	}
+
+	tcp_client_limit(client->tcp, limit);
+}
+
+/**
+ * Queue an error response and close the connection once it is sent.
+ *   @client: The client.
+ *   @status: The status code and reason.
+ */
+static void client_error(struct http_client_t *client, const char *status)
+{
+	if(client->input != NULL)
+		client_release(client);
+
+	client->out.idx = 0;
+	hprintf(io_file_strbuf(&client->out), "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status);
+	tcp_client_write(client->tcp, client->out.arr, client->out.idx);
+
+	client->state = done_v;
+}
+
+
+/**
+ * Process the ready events on the server. Only valid for a server without
+ * threads.
+ *   @server: The server.
+ *   @fds: Unused. The ready set is read from the server's poller.
+ *   @func: The handler.
+ *   @arg: The argument.
+ *   &returns: Error.
+ */
+char *http_server_proc(struct http_server_t *server, struct sys_poll_t *fds, http_handler_f func, void *arg)
+{
+	unsigned int n;
+	struct sys_event_t event[DEFEVENTS];
+
+	assert(server->conf.threads == 0);
+
+	n = sys_poller_wait(server->loop[0].poller, event, DEFEVENTS, 0);
+
+	return loop_proc(&server->loop[0], event, n, func, arg);
+}
+
+/**
+ * Retrieve the polling file descriptor set from the HTTP server. The set
+ * is always the single poller, which is readable whenever any connection
+ * is ready. Only valid for a server without threads.
+ *   @server: The server.
+ *   @poll: Optional. The pointer where to store the poll information.
+ *   &returns: The number of file descriptors.
+ */
+unsigned int http_server_poll(struct http_server_t *server, struct sys_poll_t *poll)
+{
+	assert(server->conf.threads == 0);
+
+	if(poll != NULL)
+		poll[0] = sys_poll_fd(server->loop[0].poller, sys_poll_in_e);
+
+	return 1;
+}
+
+/**
+ * Retrieve the poll timeout until the next connection deadline. Only
+ * valid for a server without threads.
+ *   @server: The server.
+ *   &returns: The timeout in milliseconds, or negative if none.
+ */
+int http_server_timeout(struct http_server_t *server)
+{
+	assert(server->conf.threads == 0);
+
+	return loop_timeout(&server->loop[0]);
+}
+
+
+/**
+ * Process the ready events of an event loop. Only expired and ready
+ * connections are visited, so idle connections cost nothing. Dropped
+ * connections are deleted once all events are processed, since later
+ * events may still refer to them.
+ *   @loop: The loop.
+ *   @event: The event array.
+ *   @n: The number of events.
+ *   @func: The handler.
+ *   @arg: The argument.
+ *   &returns: Error.
+ */
+static char *loop_proc(struct http_loop_t *loop, struct sys_event_t *event, unsigned int n, http_handler_f func, void *arg)
+{
+#define onexit loop_reap(loop);
+	unsigned int i;
+	int64_t now;
+	struct http_client_t *client;
+
+	now = sys_utime();
+
+	for(i = 0; i < nwait_v; i++) {
+		while((loop->wait[i].head != NULL) && (loop->wait[i].head->when <= now)) {
+			client = loop->wait[i].head->client;
+			deadline_disarm(loop->wait[i].head);
+			if((client->state == sock_v) && !client->pinged)
+				loop_ping(loop, client, now);
+			else
+				loop_drop(loop, client);
+		}
+	}
+
+	while((loop->alarm.node != NULL) && ((client = (void *)avltree_root_first(&loop->alarm)->ref)->alarm <= now)) {
+		loop_alarm(loop, client, 0);
+		loop_push(loop, client, func, arg);
+	}
+
+	if((loop->pause > 0) && (loop->pause <= now))
+		loop_resume(loop);
+
+	for(i = 0; i < n; i++) {
+		if(event[i].ref == loop->tcp)
+			loop_accept(loop, now, func, arg);
+		else if(event[i].ref == &loop->wake) {
+			sys_notify_clear(loop->wake);
+			loop_done(loop, func, arg);
+			loop_signal(loop, func, arg);
+		}
+		else {
+			client = event[i].ref;
+			if(client->drop)
+				continue;
+
+			if(tcp_client_proc(client->tcp, event[i].revents) && http_client_proc(client, func, arg))
+				loop_watch(loop, client);
+			else
+				loop_drop(loop, client);
+		}
+	}
+
+	loop_reap(loop);
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Accept pending connections on an event loop. The accept queue is
+ * drained until empty, up to a fixed number of connections per wakeup so
+ * that a burst cannot starve the established connections; any remainder
+ * keeps the listener ready for the next wakeup. Running out of descriptors
+ * or memory takes the listener off the poller, reported once, until a
+ * client closes or a short pause passes, so that the pending connection
+ * does not keep the loop spinning; other errors only concern the
+ * connection being accepted.
+ *   @loop: The loop.
+ *   @now: The current time.
+ *   @func: The handler.
+ *   @arg: The argument.
+ */
+static void loop_accept(struct http_loop_t *loop, int64_t now, http_handler_f func, void *arg)
+{
+	char *err;
+	unsigned int i;
+	sys_sock_t sock;
+	struct http_client_t *client;
+
+	for(i = 0; i < DEFACCEPT; i++) {
+		err = tcp_server_accept(loop->tcp, &sock);
+		if(err != NULL) {
+			if((errno == EMFILE) || (errno == ENFILE) || (errno == ENOBUFS) || (errno == ENOMEM)) {
+				if(!loop->warned)
+					fprintf(stderr, "%s Pausing new connections.\n", err);
+
+				loop->warned = true;
+				loop->pause = now + DEFPAUSE;
+				sys_poller_remove(loop->poller, tcp_server_poll(loop->tcp));
+			}
+			else
+				fprintf(stderr, "%s\n", err);
+
+			free(err);
+			break;
+		}
+		else if(!sys_issock(sock)) {
+			loop->warned = false;
+			break;
+		}
+
+		client = http_client_new(tcp_client_new(sock), &loop->server->conf);
+		client->loop = loop;
+		client->prev = NULL;
+		client->next = loop->client;
+		if(loop->client != NULL)
+			loop->client->prev = client;
+
+		loop->client = client;
+
+		if(loop->server->conf.life > 0)
+			deadline_arm(&client->life, &loop->wait[life_wait_v], now + loop->server->conf.life);
+
+		if(http_client_proc(client, func, arg))
+			loop_watch(loop, client);
+		else
+			loop_drop(loop, client);
+	}
+}
+
+/**
+ * Resume accepting connections after running out of resources.
+ *   @loop: The loop.
+ */
+static void loop_resume(struct http_loop_t *loop)
+{
+	loop->pause = 0;
+	sys_poller_add(loop->poller, tcp_server_poll(loop->tcp), loop->tcp);
+}
+
+/**
+ * Resume the clients whose deferred work completed.
+ *   @loop: The loop.
+ *   @func: The handler.
+ *   @arg: The argument.
+ */
+static void loop_done(struct http_loop_t *loop, http_handler_f func, void *arg)
+{
+	struct http_client_t *client, *done;
+
+	sys_mutex_lock(&loop->lock);
+	done = loop->done;
+	loop->done = NULL;
+	sys_mutex_unlock(&loop->lock);
+
+	for(client = done; client != NULL; client = done) {
+		done = client->wnext;
+
+		if(client->wdel != NULL)
+			client->wdel(client->warg);
+
+		client->work = NULL;
+
+		if(client->drop) {
+			client->wnext = loop->dead;
+			loop->dead = client;
+		}
+		else {
+			if(client->msg != NULL)
+				client_reply(client, client->handled);
+			else
+				client->state = client_finish(client, client->handled);
+
+			if(http_client_proc(client, func, arg))
+				loop_watch(loop, client);
+			else
+				loop_drop(loop, client);
+		}
+	}
+}
+
+/**
+ * Push to the clients whose hub was signaled. Each client stays flagged
+ * until it is visited, so that a signal arriving in the meantime does not
+ * link it onto the list again.
+ *   @loop: The loop.
+ *   @func: The handler.
+ *   @arg: The argument.
+ */
+static void loop_signal(struct http_loop_t *loop, http_handler_f func, void *arg)
+{
+	struct http_client_t *client, *signal;
+
+	sys_mutex_lock(&loop->lock);
+	signal = loop->signal;
+	loop->signal = NULL;
+	sys_mutex_unlock(&loop->lock);
+
+	for(client = signal; client != NULL; client = signal) {
+		sys_mutex_lock(&loop->lock);
+		signal = client->pnext;
+		client->signaled = false;
+		sys_mutex_unlock(&loop->lock);
+
+		loop_push(loop, client, func, arg);
+	}
+}
+
+/**
+ * Push the next events to a client, if still pushing.
+ *   @loop: The loop.
+ *   @client: The client.
+ *   @func: The handler.
+ *   @arg: The argument.
+ */
+static void loop_push(struct http_loop_t *loop, struct http_client_t *client, http_handler_f func, void *arg)
+{
+	if(client->drop || (client->state != push_v))
+		return;
+
+	client->state = client_push(client);
+	if(http_client_proc(client, func, arg))
+		loop_watch(loop, client);
+	else
+		loop_drop(loop, client);
+}
+
+/**
+ * Set the alarm of a client, replacing any armed alarm.
+ *   @loop: The loop.
+ *   @client: The client.
+ *   @when: The alarm time, zero to disarm.
+ */
+static void loop_alarm(struct http_loop_t *loop, struct http_client_t *client, int64_t when)
+{
+	if(client->alarm != 0)
+		avltree_root_remove(&loop->alarm, client);
+
+	client->alarm = when;
+	if(when != 0) {
+		client->anode.ref = client;
+		avltree_root_insert(&loop->alarm, &client->anode);
+	}
+}
+
+/**
+ * Ping an idle WebSocket client, dropping it if no frame arrives before
+ * the idle deadline expires again.
+ *   @loop: The loop.
+ *   @client: The client.
+ *   @now: The current time.
+ */
+static void loop_ping(struct http_loop_t *loop, struct http_client_t *client, int64_t now)
+{
+	client->pinged = true;
+	client_send(client, ping_op_v, NULL, 0);
+	deadline_arm(&client->wait, &loop->wait[idle_wait_v], now + client->conf->idle);
+
+	if(tcp_client_flush(client->tcp))
+		loop_watch(loop, client);
+	else
+		loop_drop(loop, client);
+}
+
+/**
+ * Update the events a client is watched for. A client waiting on a worker
+ * is removed from the poller until the work completes.
+ *   @loop: The loop.
+ *   @client: The client.
+ */
+static void loop_watch(struct http_loop_t *loop, struct http_client_t *client)
+{
+	struct sys_poll_t poll;
+
+	poll = tcp_client_poll(client->tcp);
+	if(client->work != NULL)
+		poll.events = 0;
+
+	if(poll.events == client->events)
+		return;
+
+	if(client->events == 0)
+		sys_poller_add(loop->poller, poll, client);
+	else if(poll.events == 0)
+		sys_poller_remove(loop->poller, poll);
+	else
+		sys_poller_mod(loop->poller, poll, client);
+
+	client->events = poll.events;
+}
+
+/**
+ * Drop a client, deleting it once the current events are processed. A
+ * client waiting on a worker is deleted once the work completes.
+ *   @loop: The loop.
+ *   @client: The client.
+ */
+static void loop_drop(struct http_loop_t *loop, struct http_client_t *client)
+{
+	if(client->drop)
+		return;
+
+	client->drop = true;
+	if(client->work == NULL) {
+		client->wnext = loop->dead;
+		loop->dead = client;
+	}
+}
+
+/**
+ * Delete the dropped clients of an event loop. Closing the socket also
+ * removes it from the poller, and frees a descriptor to resume accepting
+ * if paused.
+ *   @loop: The loop.
+ */
+static void loop_reap(struct http_loop_t *loop)
+{
+	struct http_client_t *client;
+
+	while(loop->dead != NULL) {
+		client = loop->dead;
+		loop->dead = client->wnext;
+
+		if(client->prev != NULL)
+			client->prev->next = client->next;
+		else
+			loop->client = client->next;
+
+		if(client->next != NULL)
+			client->next->prev = client->prev;
+
+		http_client_delete(client);
+
+		if(loop->pause > 0)
+			loop_resume(loop);
+	}
+}
+
+/**
+ * Retrieve the poll timeout until the next deadline of an event loop.
+ *   @loop: The loop.
+ *   &returns: The timeout in milliseconds, or negative if none.
+ */
+static int loop_timeout(struct http_loop_t *loop)
+{
+	unsigned int i;
+	int64_t now, wait, min = -1;
+
+	now = sys_utime();
+
+	for(i = 0; i < nwait_v; i++) {
+		if(loop->wait[i].head == NULL)
+			continue;
+
+		wait = loop->wait[i].head->when - now;
+		if(wait < 0)
+			wait = 0;
+
+		if((min < 0) || (wait < min))
+			min = wait;
+	}
+
+	if(loop->alarm.node != NULL) {
+		wait = ((const struct http_client_t *)avltree_root_first(&loop->alarm)->ref)->alarm - now;
+		if(wait < 0)
+			wait = 0;
+
+		if((min < 0) || (wait < min))
+			min = wait;
+	}
+
+	if(loop->pause > 0) {
+		wait = loop->pause - now;
+		if(wait < 0)
+			wait = 0;
+
+		if((min < 0) || (wait < min))
+			min = wait;
+	}
+
+	return (min < 0) ? -1 : (int)((min + 999) / 1000);
+}
+
+/**
+ * Run an event loop on its own thread until signaled to stop.
+ *   @fd: The termination file descriptor.
+ *   @arg: The loop.
+ */
+static void loop_task(sys_fd_t fd, void *arg)
+{
+	unsigned int i, n;
+	struct sys_event_t event[DEFEVENTS];
+	struct http_loop_t *loop = arg;
+
+	sys_poller_add(loop->poller, sys_poll_fd(fd, sys_poll_in_e), NULL);
+
+	while(true) {
+		n = sys_poller_wait(loop->poller, event, DEFEVENTS, loop_timeout(loop));
+		for(i = 0; i < n; i++) {
+			if(event[i].ref == NULL)
+				return;
+		}
+
+		chkwarn(loop_proc(loop, event, n, loop->server->func, loop->server->arg));
+	}
+}
+
+
+/**
+ * Worker thread that runs deferred handlers off the event loops.
+ *   @arg: The server.
+ *   &returns: Always null.
+ */
+static void *work_proc(void *arg)
+{
+	struct http_server_t *server = arg;
+	struct http_client_t *client;
+	struct http_loop_t *loop;
+
+	while(true) {
+		sys_mutex_lock(&server->lock);
+
+		while((server->work == NULL) && !server->stop)
+			sys_cond_wait(&server->cond, &server->lock);
+
+		if(server->stop) {
+			sys_mutex_unlock(&server->lock);
+			break;
+		}
+
+		client = server->work;
+		server->work = client->wnext;
+		if(server->work == NULL)
+			server->tail = &server->work;
+
+		sys_mutex_unlock(&server->lock);
+
+		client->handled = client->work(&client->args, client->warg);
+
+		loop = client->loop;
+		sys_mutex_lock(&loop->lock);
+		client->wnext = loop->done;
+		loop->done = client;
+		sys_mutex_unlock(&loop->lock);
+
+		sys_notify_signal(loop->wake);
+	}
+
+	return NULL;
+}
+
+/**
+ * Run a deferred WebSocket message on a worker.
+ *   @args: The arguments.
+ *   @arg: The client.
+ *   &returns: The result of the message callback.
+ */
+static bool sock_work(struct http_args_t *args, void *arg)
+{
+	struct http_client_t *client = arg;
+
+	return client->mwork(args->file, client->buf.arr, client->mlen, client->marg);
+}
+
+
+/**
+ * Create a new hub.
+ *   &returns: The hub.
+ */
+struct http_hub_t *http_hub_new(void)
+{
+	struct http_hub_t *hub;
+
+	hub = malloc(sizeof(struct http_hub_t));
+	hub->lock = sys_mutex_init(0);
+	hub->client = NULL;
+
+	return hub;
+}
+
+/**
+ * Delete a hub. The hub must have no subscribers left, so it must outlive
+ * the server whose responses subscribe to it.
+ *   @hub: The hub.
+ */
+void http_hub_delete(struct http_hub_t *hub)
+{
+	assert(hub->client == NULL);
+
+	sys_mutex_destroy(&hub->lock);
+	free(hub);
+}
+
+/**
+ * Signal a hub, waking every subscribed response on its own loop. Safe to
+ * call from any thread; signals arriving before a subscriber is visited
+ * are coalesced into one push.
+ *   @hub: The hub.
+ */
+void http_hub_signal(struct http_hub_t *hub)
+{
+	struct http_loop_t *loop;
+	struct http_client_t *client;
+
+	sys_mutex_lock(&hub->lock);
+
+	for(client = hub->client; client != NULL; client = client->hnext) {
+		loop = client->loop;
+
+		sys_mutex_lock(&loop->lock);
+
+		if(client->signaled) {
+			sys_mutex_unlock(&loop->lock);
+			continue;
+		}
+
+		client->signaled = true;
+		client->pnext = loop->signal;
+		loop->signal = client;
+
+		sys_mutex_unlock(&loop->lock);
+		sys_notify_signal(loop->wake);
+	}
+
+	sys_mutex_unlock(&hub->lock);
+}
+
+
+/**
+ * Take the request body as it arrives instead of buffering it. Only valid
+ * while the request is offered with a null body. The callback receives the
+ * decoded body in pieces as they are read, so the body is never held in
+ * memory; reading is paced by the callback, since no more is read until it
+ * returns. The handler's return value is kept until the body ends, after
+ * which the response is completed as usual.
+ *   @args: The arguments.
+ *   @func: The input callback.
+ *   @arg: The argument.
+ *   @delete: Optional. The deletion callback for the argument.
+ */
+void http_args_input(struct http_args_t *args, http_input_f func, void *arg, delete_f delete)
+{
+	struct http_client_t *client = args->client;
+
+	assert(args->body == NULL);
+
+	client->input = func;
+	client->iarg = arg;
+	client->idel = delete;
+}
+
+/**
+ * Defer the rest of a request to a worker thread. The work function runs
+ * off the event loop and may block; it writes the response exactly as a
+ * handler would, and its return value is taken as the handled flag. The
+ * response is only sent once the work completes.
+ *   @args: The arguments.
+ *   @func: The work function.
+ *   @arg: The argument.
+ *   @delete: Optional. The deletion callback for the argument.
+ *   &returns: True if deferred, false if the server has no workers.
+ */
+bool http_args_defer(struct http_args_t *args, http_work_f func, void *arg, delete_f delete)
+{
+	struct http_client_t *client = args->client;
+
+	if((client->loop == NULL) || (client->loop->server->worker == NULL) || (client->work != NULL) || (args->body == NULL))
+		return false;
+
+	client->work = func;
+	client->warg = arg;
+	client->wdel = delete;
+
+	return true;
+}
+
+/**
+ * Declare the length of the response body. The headers are sent on the
+ * first flush, so any response headers must be added beforehand.
+ *   @args: The arguments.
+ *   @len: The length.
+ */
+void http_args_length(struct http_args_t *args, uint64_t len)
+{
+	struct http_client_t *client = args->client;
+
+	assert(!client->sent);
+
+	client->body = length_v;
+	client->rem = len;
+}
+
+/**
+ * Send the response body with chunked encoding. Clients older than
+ * HTTP/1.1 instead receive the body delimited by closing the connection.
+ * The headers are sent on the first flush, so any response headers must be
+ * added beforehand.
+ *   @args: The arguments.
+ */
+void http_args_chunked(struct http_args_t *args)
+{
+	struct http_client_t *client = args->client;
+
+	assert(!client->sent);
+
+	if((client->head.proto != NULL) && (strcmp(client->head.proto, "HTTP/1.1") == 0))
+		client->body = chunk_v;
+	else {
+		client->body = close_v;
+		client->keep = false;
+	}
+}
+
+/**
+ * Set the status code of the response.
+ *   @args: The arguments.
+ *   @status: The status code.
+ */
+void http_args_status(struct http_args_t *args, unsigned int status)
+{
+	assert(!args->client->sent);
+
+	args->client->status = status;
+}
+
+/**
+ * Send an external buffer as the response body without copying it. The
+ * buffer must remain valid until released by the deleter, and no other
+ * data may be written to the response.
+ *   @args: The arguments.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   @delete: Optional. The deleter, called once the buffer is sent or the
+ *     response is discarded.
+ *   @arg: The deleter argument.
+ */
+void http_args_ref(struct http_args_t *args, const void *buf, size_t nbytes, delete_f delete, void *arg)
+{
+	struct http_client_t *client = args->client;
+
+	http_args_length(args, nbytes);
+
+	client->ref = buf;
+	client->nref = nbytes;
+	client->rdel = delete;
+	client->rarg = arg;
+}
+
+/**
+ * Send a file as the response body directly from the file, without
+ * copying. A single byte range in the request is answered with a partial
+ * response, and an unsatisfiable range with an empty one; multiple ranges
+ * are ignored and the whole file is sent. The file must remain open until
+ * released by the deleter, and no other data may be written to the
+ * response.
+ *   @args: The arguments.
+ *   @fd: The file descriptor.
+ *   @size: The file size.
+ *   @delete: Optional. The deleter, called once the file is sent or the
+ *     response is discarded.
+ *   @arg: The deleter argument.
+ */
+void http_args_file(struct http_args_t *args, int fd, uint64_t size, delete_f delete, void *arg)
+{
+	int ret;
+	char str[64];
+	uint64_t off = 0, len = size;
+	struct http_client_t *client = args->client;
+
+	http_head_add(&args->resp, "Accept-Ranges", "bytes");
+
+	ret = range_parse(http_head_known(&args->req, http_range_e), size, &off, &len);
+	if(ret < 0) {
+		snprintf(str, sizeof(str), "bytes */%llu", (unsigned long long)size);
+		http_head_add(&args->resp, "Content-Range", str);
+		http_args_status(args, 416);
+
+		if(delete != NULL)
+			delete(arg);
+
+		return;
+	}
+	else if(ret > 0) {
+		snprintf(str, sizeof(str), "bytes %llu-%llu/%llu", (unsigned long long)off, (unsigned long long)(off + len - 1), (unsigned long long)size);
+		http_head_add(&args->resp, "Content-Range", str);
+		http_args_status(args, 206);
+	}
+
+	http_args_length(args, len);
+
+	client->fd = fd;
+	client->off = off;
+	client->nref = len;
+	client->rdel = delete;
+	client->rarg = arg;
+}
+
+/**
+ * Continue the response body from a stream once the handler returns. The
+ * stream is called whenever the output queue drains below the low-water
+ * mark, so the response never holds more than a bounded amount of memory.
+ * Without a declared length, the response is chunked.
+ *   @args: The arguments.
+ *   @func: The stream callback.
+ *   @arg: The stream argument.
+ *   @delete: Optional. Deletes the argument when the response completes or
+ *     the connection closes.
+ */
+void http_args_stream(struct http_args_t *args, http_stream_f func, void *arg, delete_f delete)
+{
+	struct http_client_t *client = args->client;
+
+	if(client->body == accum_v)
+		http_args_chunked(args);
+
+	client->stream = func;
+	client->sarg = arg;
+	client->sdel = delete;
+}
+
+/**
+ * Push the response body as events occur once the handler returns. The
+ * callback is called right away, each time the hub is signaled, and when
+ * the alarm it returns expires; in between, the connection costs nothing
+ * but its socket. Without a declared length, the response is chunked and
+ * each push is sent as soon as it is written. A pushing connection is no
+ * longer bound by the lifetime limit. Only valid for a client run by a
+ * server and not from deferred work.
+ *   @args: The arguments.
+ *   @hub: Optional. The hub to subscribe to.
+ *   @func: The push callback.
+ *   @arg: The push argument.
+ *   @delete: Optional. Deletes the argument when the response completes or
+ *     the connection closes.
+ *   &returns: True if pushing, false if unsupported.
+ */
+bool http_args_push(struct http_args_t *args, struct http_hub_t *hub, http_push_f func, void *arg, delete_f delete)
+{
+	struct http_client_t *client = args->client;
+
+	if((client->loop == NULL) || (client->work != NULL) || (client->push != NULL))
+		return false;
+
+	if(client->body == accum_v)
+		http_args_chunked(args);
+
+	client->push = func;
+	client->parg = arg;
+	client->pdel = delete;
+	client->hub = hub;
+	client->alarm = 0;
+	client->signaled = false;
+
+	if(hub != NULL) {
+		sys_mutex_lock(&hub->lock);
+
+		client->hprev = NULL;
+		client->hnext = hub->client;
+		if(hub->client != NULL)
+			hub->client->hprev = client;
+
+		hub->client = client;
+
+		sys_mutex_unlock(&hub->lock);
+	}
+
+	return true;
+}
+
+/**
+ * Accept a WebSocket upgrade once the handler returns. The connection then
+ * carries messages instead of requests: each complete message is passed to
+ * the callback, control frames are answered by the server, and an idle
+ * connection is pinged and dropped if it does not answer. An upgraded
+ * connection is no longer bound by the lifetime limit.
+ *   @args: The arguments.
+ *   @func: The message callback.
+ *   @arg: The argument.
+ *   @delete: Optional. Deletes the argument when the connection closes.
+ *   &returns: True if upgrading, false if the request is not a WebSocket
+ *     handshake.
+ */
+bool http_args_websock(struct http_args_t *args, http_websock_f func, void *arg, delete_f delete)
+{
+	char accept[32];
+	uint8_t digest[SHA1_LEN];
+	struct sha1_t sha1;
+	const char *upgrade, *conn, *key, *ver;
+	struct http_client_t *client = args->client;
+
+	if((client->work != NULL) || (client->msg != NULL) || client->sent)
+		return false;
+	else if((args->req.proto == NULL) || (strcmp(args->req.proto, "HTTP/1.1") != 0) || (strcmp(args->req.verb, "GET") != 0))
+		return false;
+
+	upgrade = http_head_lookup(&args->req, "Upgrade");
+	conn = http_head_known(&args->req, http_connection_e);
+	key = http_head_lookup(&args->req, "Sec-WebSocket-Key");
+	ver = http_head_lookup(&args->req, "Sec-WebSocket-Version");
+	if((upgrade == NULL) || !hastoken(upgrade, "websocket") || (conn == NULL) || !hastoken(conn, "upgrade"))
+		return false;
+	else if((key == NULL) || (ver == NULL) || (strcmp(ver, "13") != 0))
+		return false;
+
+	sha1 = sha1_init();
+	sha1_proc(&sha1, key, strlen(key));
+	sha1_proc(&sha1, WSGUID, strlen(WSGUID));
+	sha1_finish(&sha1, digest);
+	b64enc(accept, digest, SHA1_LEN);
+
+	http_args_status(args, 101);
+	http_head_add(&args->resp, "Upgrade", "websocket");
+	http_head_add(&args->resp, "Sec-WebSocket-Accept", accept);
+
+	client->msg = func;
+	client->marg = arg;
+	client->mdel = delete;
+	client->mop = cont_op_v;
+	client->pinged = false;
+
+	return true;
+}
+
+
+/**
+ * Defer the current WebSocket message to a worker thread. Called from the
+ * message callback, which then returns true without writing; the work
+ * function is called with the same message and argument on a worker,
+ * where it may block, and anything it writes is sent as the reply once it
+ * returns. Further messages wait until the reply is queued.
+ *   @file: The output file given to the message callback.
+ *   @func: The work function.
+ *   &returns: True if deferred, false if the server has no workers or the
+ *     message already runs on one.
+ */
+bool http_websock_defer(struct io_file_t file, http_websock_f func)
+{
+	struct http_client_t *client = file.ref;
+
+	if((client->msg == NULL) || (client->loop == NULL) || (client->loop->server->worker == NULL) || (client->work != NULL))
+		return false;
+
+	client->work = sock_work;
+	client->warg = client;
+	client->wdel = NULL;
+	client->mwork = func;
+
+	return true;
+}
+
+
+/**
+ * Read from the response, which is unsupported.
+ *   @ref: The client.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   &returns: Always zero.
+ */
+static size_t resp_read(void *ref, void *buf, size_t nbytes)
+{
+	return 0;
+}
+
+/**
+ * Write to the response. Data is accumulated, or flushed to the output
+ * queue once enough is pending on a streamed response.
+ *   @ref: The client.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   &returns: The number of bytes written.
+ */
+static size_t resp_write(void *ref, const void *buf, size_t nbytes)
+{
+	struct http_client_t *client = ref;
+
+	strbuf_addmem(&client->data, buf, nbytes);
+	if((client->body != accum_v) && (client->work == NULL) && (client->data.idx >= DEFFLUSH))
+		client_flush(client);
+
+	return nbytes;
+}
+
+/**
+ * Close the response, which is a no-op.
+ *   @ref: The client.
+ */
+static void resp_close(void *ref)
+{
+}
+
+
+/**
+ * Initialize a header structure.
+ *   @arena: The arena used for added headers.
+ *   &returns: The header structure.
+ */
+struct http_head_t http_head_init(struct arena_t *arena)
+{
+	struct http_head_t head;
+
+	head.verb = head.path = head.proto = NULL;
+	memset(head.known, 0x00, sizeof(head.known));
+	head.cnt = head.size = 0;
+	head.over = NULL;
+	head.arena = arena;
+
+	return head;
+}
+
+/**
+ * Destroy a header sturcture. The strings and overflow array belong to the
+ * header block and arena, so only the header itself is cleared.
+ *   @head: The header.
+ */
+void http_head_destroy(struct http_head_t *head)
+{
+	*head = http_head_init(head->arena);
+}
+
+
+/**
+ * Retrieve a pair from the header.
+ *   @head: The header.
+ *   @idx: The index.
+ *   &returns: The pair or null if past the end.
+ */
+struct http_pair_t *http_head_get(struct http_head_t *head, unsigned int idx)
+{
+	if(idx >= head->cnt)
+		return NULL;
+	else if(idx < HTTP_INLINE)
+		return &head->pair[idx];
+	else
+		return &head->over[idx - HTTP_INLINE];
+}
+
+/**
+ * Lookup the value from the header, ignoring the case of the key. Only the
+ * first value is returned for repeated keys.
+ *   @head: The ehader.
+ *   @key: The key.
+ *   &returns: The value or null.
+ */
+const char *http_head_lookup(struct http_head_t *head, const char *key)
+{
+	size_t len;
+	uint32_t hash;
+	unsigned int i;
+	enum http_known_e id;
+	struct http_pair_t *pair;
+
+	len = strlen(key);
+	id = head_id(key, len);
+	if(id != http_nknown_e)
+		return head->known[id];
+
+	hash = hash_fnv32_fold(HASH_FNV32, key, len);
+
+	for(i = 0; (pair = http_head_get(head, i)) != NULL; i++) {
+		if((pair->hash == hash) && (strcasecmp(key, pair->key) == 0))
+			return pair->value;
+	}
+
+	return NULL;
+}
+
+/**
+ * Lookup the value of a well-known header.
+ *   @head: The header.
+ *   @id: The header identifier.
+ *   &returns: The value or null.
+ */
+const char *http_head_known(struct http_head_t *head, enum http_known_e id)
+{
+	return head->known[id];
+}
+
+/**
+ * Check if a content coding is acceptable according to the
+ * 'Accept-Encoding' header. A coding is acceptable if listed, or covered by
+ * '*', with a non-zero quality.
+ *   @head: The request header.
+ *   @coding: The content coding.
+ *   &returns: True if acceptable.
+ */
+bool http_head_accepts(struct http_head_t *head, const char *coding)
+{
+	bool star = false;
+	const char *str, *name;
+	size_t n, len = strlen(coding);
+
+	str = http_head_known(head, http_accept_encoding_e);
+	if(str == NULL)
+		return false;
+
+	while(*str != '\0') {
+		double q = 1.0;
+
+		str += strspn(str, " \t,");
+		name = str;
+		n = strcspn(str, " \t,;");
+		str += n;
+
+		while(true) {
+			str += strspn(str, " \t");
+			if(*str != ';')
+				break;
+
+			str += 1 + strspn(str + 1, " \t");
+			if((tolower(str[0]) == 'q') && (str[1] == '='))
+				q = strtod(str + 2, NULL);
+
+			str += strcspn(str, ",;");
+		}
+
+		str += strcspn(str, ",");
+
+		if((n == len) && (strncasecmp(name, coding, len) == 0))
+			return q > 0;
+		else if((n == 1) && (name[0] == '*'))
+			star = q > 0;
+	}
+
+	return star;
+}
+
+/**
+ * Check if an entity tag matches an 'If-None-Match' list of tags, using
+ * the weak comparison.
+ *   @tags: The entity tag list.
+ *   @etag: The entity tag.
+ *   &returns: True if matched.
+ */
+bool http_etag_match(const char *tags, const char *etag)
+{
+	size_t len;
+
+	if(strncmp(etag, "W/", 2) == 0)
+		etag += 2;
+
+	len = strlen(etag);
+
+	while(true) {
+		tags += strspn(tags, " \t,");
+		if(*tags == '\0')
+			return false;
+		else if(tags[0] == '*')
+			return true;
+
+		if(strncmp(tags, "W/", 2) == 0)
+			tags += 2;
+
+		if((strncmp(tags, etag, len) == 0) && ((tags[len] == '\0') || (tags[len] == ',') || (tags[len] == ' ') || (tags[len] == '\t')))
+			return true;
+
+		tags += strcspn(tags, ",");
+	}
+}
+
+/**
+ * Add a key-value pair to the header, copying both strings into the arena.
+ *   @head: The header.
+ *   @key: The key.
+ *   @value: The value.
+ */
+void http_head_add(struct http_head_t *head, const char *key, const char *value)
+{
+	head_push(head, arena_strdup(head->arena, key), arena_strdup(head->arena, value));
+}
+
+/**
+ * Parse a header in a single pass over the header block. The block is
+ * modified in place so that the header strings point directly into it; the
+ * block must outlive the header.
+ *   @head: Ref. The header, whose arena is kept.
+ *   @str: The header block.
+ *   @len: The length of the header block.
+ *   &returns: The error.
+ */
+char *http_head_parse(struct http_head_t *head, char *str, size_t len)
+{
+#define onexit http_head_destroy(head);
+	size_t n, vlen, tlen[4];
+	char *line, *ptr, *tok[4], *end = str + len;
+
+	http_head_destroy(head);
+
+	line = nextline(&str, end, &n);
+	ptr = line;
+
+	tok[0] = nexttoken(&ptr, line + n, &tlen[0]);
+	tok[1] = nexttoken(&ptr, line + n, &tlen[1]);
+	tok[2] = nexttoken(&ptr, line + n, &tlen[2]);
+	tok[3] = nexttoken(&ptr, line + n, &tlen[3]);
+
+	if(tlen[0] == 0)
+		fail("Invalid header. Missing verb.");
+	else if(tlen[1] == 0)
+		fail("Invalid header. Missing path.");
+	else if(tlen[2] == 0)
+		fail("Invalid header. Missing protocol.");
+	else if(tlen[3] != 0)
+		fail("Invalid header. Invalid request.");
+
+	tok[0][tlen[0]] = tok[1][tlen[1]] = tok[2][tlen[2]] = '\0';
+	head->verb = tok[0];
+	head->path = tok[1];
+	head->proto = tok[2];
+
+	while(true) {
+		line = nextline(&str, end, &n);
+		if(n == 0)
+			break;
+
+		ptr = memchr(line, ':', n);
+		if(ptr == NULL)
+			fail("Invalid header. Missing value.");
+
+		*ptr = '\0';
+		if((ptr == line) || (strcspn(line, " \t") < (size_t)(ptr - line)))
+			fail("Invalid header. Invalid name.");
+
+		for(ptr++; (ptr < line + n) && ((*ptr == ' ') || (*ptr == '\t')); ptr++)
+			;
+
+		for(vlen = line + n - ptr; (vlen > 0) && ((ptr[vlen-1] == ' ') || (ptr[vlen-1] == '\t')); vlen--)
+			;
+
+		ptr[vlen] = '\0';
+		head_push(head, line, ptr);
+	}
+
+	return NULL;
+#undef onexit
+}
+
+
+/**
+ * Append a pair to a header without copying the strings.
+ *   @head: The header.
+ *   @key: The key.
+ *   @value: The value.
+ */
+static void head_push(struct http_head_t *head, const char *key, const char *value)
+{
+	size_t len;
+	uint32_t hash;
+	enum http_known_e id;
+
+	len = strlen(key);
+	id = head_id(key, len);
+	if((id != http_nknown_e) && (head->known[id] == NULL))
+		head->known[id] = value;
+
+	hash = hash_fnv32_fold(HASH_FNV32, key, len);
+
+	if(head->cnt >= (HTTP_INLINE + head->size)) {
+		unsigned int size = head->size ? (2 * head->size) : HTTP_INLINE;
+		struct http_pair_t *over;
+
+		over = arena_alloc(head->arena, size * sizeof(struct http_pair_t));
+		if(head->size > 0)
+			memcpy(over, head->over, head->size * sizeof(struct http_pair_t));
+
+		head->over = over;
+		head->size = size;
+	}
+
+	if(head->cnt < HTTP_INLINE)
+		head->pair[head->cnt] = (struct http_pair_t){ key, value, hash };
+	else
+		head->over[head->cnt - HTTP_INLINE] = (struct http_pair_t){ key, value, hash };
+
+	head->cnt++;
+}
+
+/**
+ * Identify a well-known header, ignoring case. Each well-known key has a
+ * distinct length, so only a single comparison is needed.
+ *   @key: The key.
+ *   @len: The key length.
+ *   &returns: The identifier, or 'http_nknown_e' if not well-known.
+ */
+static enum http_known_e head_id(const char *key, size_t len)
+{
+	static const char *name[http_nknown_e] = {
+		"Content-Length", "Connection", "Host", "If-None-Match", "Range", "Accept-Encoding", "Cookie", "Transfer-Encoding"
+	};
+	enum http_known_e id;
+
+	switch(len) {
+	case 14: id = http_content_length_e; break;
+	case 10: id = http_connection_e; break;
+	case 4: id = http_host_e; break;
+	case 13: id = http_if_none_match_e; break;
+	case 5: id = http_range_e; break;
+	case 15: id = http_accept_encoding_e; break;
+	case 6: id = http_cookie_e; break;
+	case 17: id = http_transfer_encoding_e; break;
+	default: return http_nknown_e;
+	}
+
+	return (strncasecmp(key, name[id], len) == 0) ? id : http_nknown_e;
+}
+
+/**
+ * Check that every occurrence of a well-known header carries the same
+ * value as the first, so that repeated framing headers cannot be read
+ * differently by an intermediary.
+ *   @head: The header.
+ *   @id: The header identifier.
+ *   &returns: True if all values agree.
+ */
+static bool head_agree(struct http_head_t *head, enum http_known_e id)
+{
+	unsigned int i;
+	const struct http_pair_t *pair;
+
+	for(i = 0; i < head->cnt; i++) {
+		pair = (i < HTTP_INLINE) ? &head->pair[i] : &head->over[i - HTTP_INLINE];
+		if((head_id(pair->key, strlen(pair->key)) == id) && (strcmp(pair->value, head->known[id]) != 0))
+			return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * Find the length of a header block terminated by an empty line.
+ *   @data: The data.
+ *   @len: The length of the data.
+ *   @idx: Ref. The scan offset, updated so that a later scan of more data
+ *     does not revisit bytes already scanned.
+ *   &returns: The length including the empty line, or zero if incomplete.
+ */
+static size_t headlen(const char *data, size_t len, size_t *idx)
+{
+	const char *ptr = data + *idx, *end = data + len;
+
+	while((ptr = memchr(ptr, '\n', end - ptr)) != NULL) {
+		if(++ptr == end)
+			break;
+		else if(*ptr == '\n')
+			return ptr + 1 - data;
+		else if(*ptr != '\r')
+			continue;
+		else if(++ptr == end)
+			break;
+		else if(*ptr == '\n')
+			return ptr + 1 - data;
+	}
+
+	*idx = (len > 2) ? (len - 2) : 0;
+
+	return 0;
+}
+
+/**
+ * Retrieve the next line from a header block.
+ *   @str: Ref. The current position, advanced past the line.
+ *   @end: The end of the block.
+ *   @len: Ref. The line length, excluding the line terminator.
+ *   &returns: The line.
+ */
+static char *nextline(char **str, char *end, size_t *len)
+{
+	char *line = *str, *eol;
+
+	eol = memchr(line, '\n', end - line);
+	if(eol == NULL)
+		eol = end;
+
+	*str = (eol < end) ? (eol + 1) : end;
+	*len = ((eol > line) && (eol[-1] == '\r')) ? (eol - line - 1) : (eol - line);
+
+	return line;
+}
+
+/**
+ * Retrieve the next space-delimited token from a line.
+ *   @str: Ref. The current position, advanced past the token.
+ *   @end: The end of the line.
+ *   @len: Ref. The token length, zero if none remain.
+ *   &returns: The token.
+ */
+static char *nexttoken(char **str, char *end, size_t *len)
+{
+	char *tok;
+
+	while((*str < end) && ((**str == ' ') || (**str == '\t')))
+		(*str)++;
+
+	for(tok = *str; (*str < end) && (**str != ' ') && (**str != '\t'); (*str)++)
+		;
+
+	*len = *str - tok;
+
+	return tok;
+}
+
+/**
+ * Check if a comma-separated header value contains a token, ignoring case.
+ *   @value: The header value.
+ *   @token: The token.
+ *   &returns: True if found.
+ */
+static bool hastoken(const char *value, const char *token)
+{
+	size_t len = strlen(token);
+
+	while(*value != '\0') {
+		while((*value == ' ') || (*value == '\t') || (*value == ','))
+			value++;
+
+		if((strncasecmp(value, token, len) == 0) && (strchr(" \t,", value[len]) != NULL))
+			return true;
+
+		while((*value != '\0') && (*value != ','))
+			value++;
+	}
+
+	return false;
+}
+
+/**
+ * Encode data as base64.
+ *   @out: The output, at least '4 * ((len + 2) / 3) + 1' bytes.
+ *   @in: The input.
+ *   @len: The input length.
+ */
+static void b64enc(char *out, const uint8_t *in, size_t len)
+{
+	static const char *map = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t i;
+	uint32_t v;
+
+	for(i = 0; i < len; i += 3) {
+		v = (uint32_t)in[i] << 16;
+		if(i + 1 < len)
+			v |= (uint32_t)in[i + 1] << 8;
+
+		if(i + 2 < len)
+			v |= in[i + 2];
+
+		*out++ = map[(v >> 18) & 0x3F];
+		*out++ = map[(v >> 12) & 0x3F];
+		*out++ = (i + 1 < len) ? map[(v >> 6) & 0x3F] : '=';
+		*out++ = (i + 2 < len) ? map[v & 0x3F] : '=';
+	}
+
+	*out = '\0';
+}
+
@@ -1,39 +1,114 @@
 #ifndef HTTP_H
 #define HTTP_H
 
-/**
- * Header sturcture.
- *   @verb, path, proto: Verb path and protocol.
- *   @pair: The key-value pairs.
+/*
+ * header definitions
  */
-struct http_head_t {
-	char *verb, *path, *proto;
+#define HTTP_INLINE	16
 
-	struct http_pair_t *pair;
+/**
+ * Well-known header enumerator.
+ *   @content_length: Content-Length.
+ *   @connection: Connection.
+ *   @host: Host.
+ *   @if_none_match: If-None-Match.
+ *   @range: Range.
+ *   @accept_encoding: Accept-Encoding.
+ *   @cookie: Cookie.
+ *   @transfer_encoding: Transfer-Encoding.
+ *   @nknown: The number of well-known headers.
+ */
+enum http_known_e {
+	http_content_length_e,
+	http_connection_e,
+	http_host_e,
+	http_if_none_match_e,
+	http_range_e,
+	http_accept_encoding_e,
+	http_cookie_e,
+	http_transfer_encoding_e,
+	http_nknown_e
 };
 
 /**
  * Key-value pair structure.
  *   @key, value: Key and value strings.
- *   @next: The next pair.
+ *   @hash: The case-insensitive hash of the key.
  */
 struct http_pair_t {
-	char *key, *value;
+	const char *key, *value;
+	uint32_t hash;
+};
 
-	struct http_pair_t *next;
+/**
+ * Header structure. Request headers point into the received header block
+ * and added headers are copied into the arena, so that no header requires
+ * its own allocation. The first pairs are stored inline, and any further
+ * pairs in an overflow array allocated from the arena. Well-known headers
+ * are also recognized into fixed slots as they are added.
+ *   @verb, path, proto: Verb path and protocol.
+ *   @known: The values of the well-known headers.
+ *   @cnt, size: The number of pairs and the overflow capacity.
+ *   @pair: The inline pair array.
+ *   @over: The overflow pair array.
+ *   @arena: The arena.
+ */
+struct http_head_t {
+	const char *verb, *path, *proto;
+	const char *known[http_nknown_e];
+
+	unsigned int cnt, size;
+	struct http_pair_t pair[HTTP_INLINE], *over;
+
+	struct arena_t *arena;
 };
 
 /**
- * Argument structure.
+ * Server configuration structure. Time limits are in microseconds, zero
+ * for none.
+ *   @idle: The idle limit between requests.
+ *   @head: The limit for receiving a request header, from its first byte
+ *     or from the connection if the first request.
+ *   @body: The limit for receiving a request body.
+ *   @life: The total lifetime of a connection.
+ *   @length: The maximum length of a request body buffered for a handler,
+ *     zero for none. Bodies taken as they arrive are not limited.
+ *   @max: The maximum number of requests per connection, zero for none.
+ *   @threads: The number of event loop threads, zero to run a single loop
+ *     from the caller.
+ *   @workers: The number of worker threads for deferred requests, zero to
+ *     run them inline.
+ *   @pipeline: The maximum number of unsent responses per connection, zero
+ *     for none.
+ */
+struct http_conf_t {
+	int64_t idle, head, body, life;
+	uint64_t length;
+	unsigned int max, pipeline, threads, workers;
+};
+
+/**
+ * Argument structure. By default, the response body is accumulated and
+ * sent with its length once the handler returns. A handler may instead
+ * declare the length or select chunked encoding before writing, after
+ * which the headers are sent and writes go out as they are produced.
+ *
+ * A request with a body is first offered to the handler with a null body,
+ * before any of the body is read. The handler may take the body as it
+ * arrives with 'http_args_input'; a handler that does not must return
+ * without writing, and is called again once the whole body is buffered.
  *   @file: The output file.
- *   @body: The body.
+ *   @body: The body, null while the request is offered.
  *   @req, resp: The request and response header.
+ *   @client: The client.
  */
 struct http_args_t {
 	struct io_file_t file;
 
 	const char *body;
 	struct http_head_t req, resp;
+
+	struct http_client_t *client;
 };
 
 
@@ -46,39 +121,127 @@ struct http_args_t {
  */
 typedef bool (*http_handler_f)(const char *path, struct http_args_t *args, void *arg);
 
+/**
+ * Response stream callback, called each time the output queue of the
+ * connection drains below the low-water mark.
+ *   @file: The output file.
+ *   @arg: The argument.
+ *   &returns: True if more data remains, false once complete.
+ */
+typedef bool (*http_stream_f)(struct io_file_t file, void *arg);
+
+/**
+ * Request body callback, called with each piece of the decoded body as it
+ * arrives and a last time with no data once the body is complete.
+ *   @args: The request arguments.
+ *   @data: The data, null at the end of the body.
+ *   @len: The length, zero at the end of the body.
+ *   @arg: The argument.
+ *   &returns: True to continue, false to stop reading and close the
+ *     connection after the response.
+ */
+typedef bool (*http_input_f)(struct http_args_t *args, const char *data, size_t len, void *arg);
+
+/**
+ * Deferred work callback, run on a worker thread. The callback may use the
+ * arguments as a handler would, but its output is only sent once it
+ * returns.
+ *   @args: The request arguments.
+ *   @arg: The argument.
+ *   &returns: True if handled, false otherwise.
+ */
+typedef bool (*http_work_f)(struct http_args_t *args, void *arg);
+
+/**
+ * Push callback, called once the handler returns, each time the hub of the
+ * response is signaled, and when the alarm it returned expires.
+ *   @file: The output file.
+ *   @arg: The argument.
+ *   &returns: The time of the next alarm in microseconds, zero for none, or
+ *     negative to complete the response.
+ */
+typedef int64_t (*http_push_f)(struct io_file_t file, void *arg);
+
+/**
+ * WebSocket message callback, called with each complete message received.
+ * Anything written to the output file is sent back as one text message.
+ *   @file: The output file.
+ *   @data: The message data, followed by a null byte.
+ *   @len: The message length.
+ *   @arg: The argument.
+ *   &returns: True to continue, false to close the connection.
+ */
+typedef bool (*http_websock_f)(struct io_file_t file, const char *data, size_t len, void *arg);
+
 /*
  * structure prototypes
  */
 struct tcp_client_t;
 struct http_server_t;
 struct http_client_t;
+struct http_hub_t;
+
+/*
+ * http configuration function declarations
+ */
+struct http_conf_t http_conf_init(void);
 
 /*
  * http server function declarations
  */
-char *http_server_open(struct http_server_t **server, uint16_t port);
+char *http_server_open(struct http_server_t **server, uint16_t port, const struct http_conf_t *conf);
 void http_server_close(struct http_server_t *server);
 
+void http_server_start(struct http_server_t *server, http_handler_f func, void *arg);
+
 char *http_server_proc(struct http_server_t *server, struct sys_poll_t *fds, http_handler_f func, void *arg);
 unsigned int http_server_poll(struct http_server_t *server, struct sys_poll_t *poll);
+int http_server_timeout(struct http_server_t *server);
 
 /*
  * http client function declarations
  */
-struct http_client_t *http_client_new(struct tcp_client_t *tcp);
+struct http_client_t *http_client_new(struct tcp_client_t *tcp, const struct http_conf_t *conf);
 void http_client_delete(struct http_client_t *client);
 
 bool http_client_proc(struct http_client_t *client, http_handler_f func, void *arg);
 
+/*
+ * http argument function declarations
+ */
+void http_args_length(struct http_args_t *args, uint64_t len);
+void http_args_chunked(struct http_args_t *args);
+void http_args_status(struct http_args_t *args, unsigned int status);
+void http_args_ref(struct http_args_t *args, const void *buf, size_t nbytes, delete_f delete, void *arg);
+void http_args_file(struct http_args_t *args, int fd, uint64_t size, delete_f delete, void *arg);
+void http_args_stream(struct http_args_t *args, http_stream_f func, void *arg, delete_f delete);
+void http_args_input(struct http_args_t *args, http_input_f func, void *arg, delete_f delete);
+bool http_args_defer(struct http_args_t *args, http_work_f func, void *arg, delete_f delete);
+bool http_args_push(struct http_args_t *args, struct http_hub_t *hub, http_push_f func, void *arg, delete_f delete);
+bool http_args_websock(struct http_args_t *args, http_websock_f func, void *arg, delete_f delete);
+
+bool http_websock_defer(struct io_file_t file, http_websock_f func);
+
+/*
+ * http hub function declarations
+ */
+struct http_hub_t *http_hub_new(void);
+void http_hub_delete(struct http_hub_t *hub);
+void http_hub_signal(struct http_hub_t *hub);
+
 /*
  * http header function declarations
  */
-struct http_head_t http_head_init(void);
+struct http_head_t http_head_init(struct arena_t *arena);
 void http_head_destroy(struct http_head_t *head);
 
 const char *http_head_lookup(struct http_head_t *head, const char *key);
+const char *http_head_known(struct http_head_t *head, enum http_known_e id);
+bool http_head_accepts(struct http_head_t *head, const char *coding);
+bool http_etag_match(const char *tags, const char *etag);
 void http_head_add(struct http_head_t *head, const char *key, const char *value);
 
-char *http_head_parse(struct http_head_t *head, const char *str);
+struct http_pair_t *http_head_get(struct http_head_t *head, unsigned int idx);
+char *http_head_parse(struct http_head_t *head, char *str, size_t len);
 
 #endif
@@ -0,0 +1,25 @@
+#include "defs.h"
+#include "posix/defs.h"
+#include "posix/defs.h"
+#include "posix/poll.h"
+#include "posix/sock.h"
+#include "posix/thread.h"
+#include "posix/time.h"
+#include "arena.h"
+#include "avltree.h"
+#include "chunk.h"
+#include "complex.h"
+#include "crc.h"
+#include "file.h"
+#include "func.h"
+#include "hash.h"
+#include "list.h"
+#include "log.h"
+#include "mem.h"
+#include "print.h"
+#include "rand.h"
+#include "sha1.h"
+#include "strbuf.h"
+#include "http.h"
+#include "router.h"
+#include "tcp.h"
@@ -1,4 +1,12 @@
 #include "../common.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+
+/*
+ * local declarations
+ */
+static void poller_ctl(sys_fd_t fd, int op, struct sys_poll_t poll, void *ref);
 
 
 /**
@@ -38,3 +46,175 @@ bool sys_poll(struct sys_poll_t *list, unsigned int n, int timeout)
 
 	return err > 0;
 }
+
+
+/**
+ * Create a poller. A poller keeps its set of files between waits, so each
+ * wait costs time in the number of ready files rather than in the number
+ * of files watched. The poller itself is readable whenever a file is ready.
+ *   &returns: The file descriptor.
+ */
+sys_fd_t sys_poller_new(void)
+{
+	int fd;
+
+	fd = epoll_create1(EPOLL_CLOEXEC);
+	if(fd < 0)
+		fatal("Failed to create poller. %s.", strerror(errno));
+
+	return fd;
+}
+
+/**
+ * Delete a poller.
+ *   @fd: The file descriptor.
+ */
+void sys_poller_delete(sys_fd_t fd)
+{
+	close(fd);
+}
+
+/**
+ * Add a file to a poller.
+ *   @fd: The poller file descriptor.
+ *   @poll: The file and events.
+ *   @ref: The reference returned with its events.
+ */
+void sys_poller_add(sys_fd_t fd, struct sys_poll_t poll, void *ref)
+{
+	poller_ctl(fd, EPOLL_CTL_ADD, poll, ref);
+}
+
+/**
+ * Modify the events of a file on a poller.
+ *   @fd: The poller file descriptor.
+ *   @poll: The file and events.
+ *   @ref: The reference returned with its events.
+ */
+void sys_poller_mod(sys_fd_t fd, struct sys_poll_t poll, void *ref)
+{
+	poller_ctl(fd, EPOLL_CTL_MOD, poll, ref);
+}
+
+/**
+ * Remove a file from a poller.
+ *   @fd: The poller file descriptor.
+ *   @poll: The file.
+ */
+void sys_poller_remove(sys_fd_t fd, struct sys_poll_t poll)
+{
+	poller_ctl(fd, EPOLL_CTL_DEL, poll, NULL);
+}
+
+/**
+ * Wait for events on a poller. A hangup is reported as input, so that the
+ * reader observes the end of file.
+ *   @fd: The poller file descriptor.
+ *   @event: The event array.
+ *   @n: The size of the event array.
+ *   @timeout: The timeout in milliseconds. Negative waits forever.
+ *   &returns: The number of events.
+ */
+unsigned int sys_poller_wait(sys_fd_t fd, struct sys_event_t *event, unsigned int n, int timeout)
+{
+	int i, err;
+	struct epoll_event list[n];
+
+	do
+		err = epoll_wait(fd, list, n, timeout);
+	while((err < 0) && (errno == EINTR));
+
+	if(err < 0)
+		fatal("Poller wait failed. %s.", strerror(errno));
+
+	for(i = 0; i < err; i++) {
+		event[i].ref = list[i].data.ptr;
+		event[i].revents = 0;
+		event[i].revents |= (list[i].events & (EPOLLIN | EPOLLHUP)) ? sys_poll_in_e : 0;
+		event[i].revents |= (list[i].events & EPOLLOUT) ? sys_poll_out_e : 0;
+		event[i].revents |= (list[i].events & (EPOLLERR | EPOLLHUP)) ? sys_poll_err_e : 0;
+	}
+
+	return err;
+}
+
+/**
+ * Control the set of a poller.
+ *   @fd: The poller file descriptor.
+ *   @op: The operation.
+ *   @poll: The file and events.
+ *   @ref: The reference.
+ */
+static void poller_ctl(sys_fd_t fd, int op, struct sys_poll_t poll, void *ref)
+{
+	struct epoll_event event;
+
+	event.events = 0;
+	event.events |= (poll.events & sys_poll_in_e) ? EPOLLIN : 0;
+	event.events |= (poll.events & sys_poll_out_e) ? EPOLLOUT : 0;
+	event.events |= (poll.events & sys_poll_err_e) ? EPOLLERR : 0;
+	event.data.ptr = ref;
+
+	if(epoll_ctl(fd, op, (poll.fd >= 0) ? poll.fd : poll.sock, &event) < 0)
+		fatal("Failed to update poller. %s.", strerror(errno));
+}
+
+
+/**
+ * Create a notifier, a file descriptor that becomes readable once signaled
+ * from any thread and stays readable until cleared.
+ *   &returns: The file descriptor.
+ */
+sys_fd_t sys_notify_new(void)
+{
+	int fd;
+
+	fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(fd < 0)
+		fatal("Failed to create notifier. %s.", strerror(errno));
+
+	return fd;
+}
+
+/**
+ * Delete a notifier.
+ *   @fd: The file descriptor.
+ */
+void sys_notify_delete(sys_fd_t fd)
+{
+	close(fd);
+}
+
+/**
+ * Signal a notifier.
+ *   @fd: The file descriptor.
+ */
+void sys_notify_signal(sys_fd_t fd)
+{
+	ssize_t wr;
+	uint64_t one = 1;
+
+	do
+		wr = write(fd, &one, sizeof(one));
+	while((wr < 0) && (errno == EINTR));
+
+	if((wr < 0) && (errno != EAGAIN))
+		fatal("Failed to signal notifier. %s.", strerror(errno));
+}
+
+/**
+ * Clear all pending signals of a notifier.
+ *   @fd: The file descriptor.
+ */
+void sys_notify_clear(sys_fd_t fd)
+{
+	ssize_t rd;
+	uint64_t cnt;
+
+	do
+		rd = read(fd, &cnt, sizeof(cnt));
+	while((rd < 0) && (errno == EINTR));
+
+	if((rd < 0) && (errno != EAGAIN))
+		fatal("Failed to clear notifier. %s.", strerror(errno));
+}
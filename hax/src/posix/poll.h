@@ -47,9 +47,39 @@ static inline struct sys_poll_t sys_poll_sock(sys_sock_t sock, enum sys_poll_e e
 	return (struct sys_poll_t){ -1, sock, events, 0 };
 }
 
+/**
+ * Poller event structure.
+ *   @ref: The reference given when the file was added.
+ *   @revents: The received events.
+ */
+struct sys_event_t {
+	void *ref;
+	enum sys_poll_e revents;
+};
+
 /*
  * poll declarations
  */
 bool sys_poll(struct sys_poll_t *poll, unsigned int n, int timeout);
 
+/*
+ * poller declarations
+ */
+sys_fd_t sys_poller_new(void);
+void sys_poller_delete(sys_fd_t fd);
+
+void sys_poller_add(sys_fd_t fd, struct sys_poll_t poll, void *ref);
+void sys_poller_mod(sys_fd_t fd, struct sys_poll_t poll, void *ref);
+void sys_poller_remove(sys_fd_t fd, struct sys_poll_t poll);
+unsigned int sys_poller_wait(sys_fd_t fd, struct sys_event_t *event, unsigned int n, int timeout);
+
+/*
+ * notifier declarations
+ */
+sys_fd_t sys_notify_new(void);
+void sys_notify_delete(sys_fd_t fd);
+
+void sys_notify_signal(sys_fd_t fd);
+void sys_notify_clear(sys_fd_t fd);
+
 #endif
@@ -1,9 +1,16 @@
+#define _GNU_SOURCE
 #include "../common.h"
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
 
 
+/*
+ * local declarations
+ */
+static ssize_t sock_error(const char *msg);
+
 /*
  * global declarations
  */
@@ -91,7 +98,9 @@ char *sys_connect(sys_sock_t *sock, int type, const char *host, uint16_t port)
  *   @buf: The buffer.
  *   @nbyte: The number of bytes.
  *   @flags: The flags.
- *   &returns: The number of bytes read.
+ *   &returns: The number of bytes read, zero at end of file, or negative on
+ *     error. A read that would block is negative with 'errno' set to
+ *     'EAGAIN'.
  */
 ssize_t sys_recv(sys_sock_t sock, void *buf, size_t nbytes, int flags)
 {
@@ -102,12 +111,11 @@ ssize_t sys_recv(sys_sock_t sock, void *buf, size_t nbytes, int flags)
 	while((ret < 0) && (errno == EINTR));
 
 	if(ret < 0) {
-		if(errno == EBADF)
+		if(sock_error("Failed to read data on socket") < 0)
 			return -1;
-		else if((errno != EAGAIN) && (errno != EWOULDBLOCK))
-			fatal("Failed to read data on socket. %s.", strerror(errno));
-		else
-			return 0;
+
+		errno = EAGAIN;
+		return -1;
 	}
 
 	return ret;
@@ -129,18 +137,68 @@ ssize_t sys_send(sys_sock_t sock, const void *buf, size_t nbytes, int flags)
 		ret = send(sock, buf, nbytes, flags);
 	while((ret < 0) && (errno == EINTR));
 
-	if(ret < 0) {
-		if(errno == EBADF)
-			return -1;
-		else if((errno != EAGAIN) && (errno != EWOULDBLOCK))
-			fatal("Failed to write data on socket. %s.", strerror(errno));
-		else
-			return 0;
-	}
+	if(ret < 0)
+		return sock_error("Failed to write data on socket");
 
 	return ret;
 }
 
+/**
+ * Write data gathered from several buffers on a socket with a single call.
+ *   @sock: The socket.
+ *   @iov: The buffer array.
+ *   @cnt: The number of buffers.
+ *   @flags: The flags.
+ *   &returns: The number of bytes written, or negative if the connection
+ *     is closed.
+ */
+ssize_t sys_sendv(sys_sock_t sock, const struct iovec *iov, unsigned int cnt, int flags)
+{
+	ssize_t ret;
+	struct msghdr msg;
+
+	memset(&msg, 0x00, sizeof(msg));
+	msg.msg_iov = (struct iovec *)iov;
+	msg.msg_iovlen = cnt;
+
+	do
+		ret = sendmsg(sock, &msg, flags);
+	while((ret < 0) && (errno == EINTR));
+
+	if(ret < 0)
+		return sock_error("Failed to write data on socket");
+
+	return ret;
+}
+
+
+/**
+ * Write data from a file on a socket, without copying through user space.
+ *   @sock: The socket.
+ *   @fd: The file descriptor.
+ *   @off: Ref. The file offset, advanced by the number of bytes written.
+ *   @nbytes: The number of bytes.
+ *   &returns: The number of bytes written, or negative if the connection
+ *     is closed or the file ends early.
+ */
+ssize_t sys_sendfile(sys_sock_t sock, int fd, int64_t *off, size_t nbytes)
+{
+	ssize_t ret;
+	off_t pos = *off;
+
+	do
+		ret = sendfile(sock, fd, &pos, nbytes);
+	while((ret < 0) && (errno == EINTR));
+
+	if(ret < 0)
+		return sock_error("Failed to write file on socket");
+	else if((ret == 0) && (nbytes > 0))
+		return -1;
+
+	*off = pos;
+
+	return ret;
+}
 
 /**
  * Bind a socket.
@@ -172,18 +230,35 @@ char *sys_listen(sys_sock_t sock, int backlog)
 }
 
 /**
- * Accpet a socket.
+ * Accept a socket. The client socket is created non-blocking and closed on
+ * exec.
  *   @sock: The socket.
- *   @ref: The client socket.
+ *   @ref: The client socket, 'sys_badsock' if no connection is pending.
  *   @addr: The address.
  *   @len: The length.
- *   &returns: Error.
+ *   &returns: Error, with 'errno' set on failure.
  */
 char *sys_accept(sys_sock_t sock, sys_sock_t *client, struct sockaddr *addr, socklen_t *len)
 {
-	*client = accept(sock, addr, len);
-	if(*client < 0)
-		return mprintf("Failed to set socket option. %s.", strerror(errno));
+	int err;
+	char *msg;
+
+	do
+		*client = accept4(sock, addr, len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	while((*client < 0) && (errno == EINTR));
+
+	if(*client < 0) {
+		if((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ECONNABORTED)) {
+			*client = sys_badsock;
+			return NULL;
+		}
+
+		err = errno;
+		msg = mprintf("Failed to accept connection. %s.", strerror(err));
+		errno = err;
+
+		return msg;
+	}
 
 	return NULL;
 }
@@ -204,3 +279,29 @@ char *sys_setsockopt(sys_sock_t sock, int level, int opt, const void *val, sockl
 
 	return NULL;
 }
+
+
+/**
+ * Handle the error of a failed socket call. Errors that can only come from
+ * invalid arguments are fatal, while any other error only concerns the
+ * connection, such as a reset or an unreachable peer, and closes it.
+ * Unexpected connection errors are reported.
+ *   @msg: The message prefix.
+ *   &returns: Zero if the call would block, negative if the connection is
+ *     closed.
+ */
+static ssize_t sock_error(const char *msg)
+{
+	int err = errno;
+
+	if((err == EAGAIN) || (err == EWOULDBLOCK))
+		return 0;
+	else if((err == EFAULT) || (err == EINVAL) || (err == ENOTSOCK))
+		fatal("%s. %s.", msg, strerror(err));
+	else if((err != EBADF) && (err != ECONNRESET) && (err != EPIPE))
+		fprintf(stderr, "%s. %s.\n", msg, strerror(err));
+
+	errno = err;
+
+	return -1;
+}
@@ -12,6 +12,8 @@ void sys_closesocket(sys_sock_t sock);
 
 ssize_t sys_recv(sys_sock_t sock, void *buf, size_t nbytes, int flags);
 ssize_t sys_send(sys_sock_t sock, const void *buf, size_t nbytes, int flags);
+ssize_t sys_sendv(sys_sock_t sock, const struct iovec *iov, unsigned int cnt, int flags);
+ssize_t sys_sendfile(sys_sock_t sock, int fd, int64_t *off, size_t nbytes);
 
 char *sys_bind(sys_sock_t fd, void *addr, socklen_t len);
 char *sys_listen(sys_sock_t sock, int backlog);
@@ -1,4 +1,11 @@
 #include "../common.h"
+#include <sched.h>
+
+
+/*
+ * local definitions
+ */
+#define SPIN	64
 
 /*
  * local declarations
@@ -55,6 +62,22 @@ void sys_thread_detach(sys_thread_t *thread)
 		fatal("Failed to detach thread (%d). %s.", err, strerror(err));
 }
 
+/**
+ * Wait for a counter of short critical sections, such as readers pinning a
+ * published pointer, to drain to zero. The caller spins briefly and then
+ * yields, so that a reader preempted inside its section can run.
+ *   @cnt: The counter.
+ */
+void sys_thread_drain(unsigned int *cnt)
+{
+	unsigned int spin;
+
+	for(spin = 0; __atomic_load_n(cnt, __ATOMIC_SEQ_CST) != 0; spin++) {
+		if(spin >= SPIN)
+			sched_yield();
+	}
+}
+
 
 /**
  * Initialize a mutex.
@@ -237,6 +260,8 @@ void sys_task_delete(struct sys_task_t *task)
 		fatal("Failed to synchronize task (%d). %s.", errno, strerror(errno));
 
 	sys_thread_join(&task->thread);
+	close(task->pipe[0]);
+	close(task->pipe[1]);
 	free(task);
 }
 
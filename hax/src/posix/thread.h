@@ -39,6 +39,7 @@ typedef struct sys_thread_t sys_thread_t;
 sys_thread_t sys_thread_create(unsigned int flags, void *(*func)(void *), void *arg);
 void *sys_thread_join(sys_thread_t *thread);
 void sys_thread_detach(sys_thread_t *thread);
+void sys_thread_drain(unsigned int *cnt);
 
 /*
  * mutex declarations
@@ -0,0 +1,455 @@
+#include "common.h"
+
+
+/**
+ * Parameter type enumerator.
+ *   @str_v: String parameter.
+ *   @uint_v: Unsigned integer parameter.
+ */
+enum type_e {
+	str_v,
+	uint_v
+};
+
+/**
+ * Router structure. Routes are compiled into a trie of path segments, where
+ * each node finds its static children through a hash table and keeps a
+ * short list of typed parameter children.
+ *   @root: The root node.
+ */
+struct http_router_t {
+	struct node_t *root;
+};
+
+/**
+ * Node structure.
+ *   @cnt, size: The number of static edges and the table size.
+ *   @edge: The static edge hash table.
+ *   @param: The parameter edge list.
+ *   @func: The handler, or null if no route ends at the node.
+ *   @arg: The handler argument.
+ *   @flags: The route flags.
+ */
+struct node_t {
+	unsigned int cnt, size;
+	struct edge_t *edge;
+	struct param_t *param;
+
+	http_route_f func;
+	void *arg;
+	unsigned int flags;
+};
+
+/**
+ * Static edge structure.
+ *   @hash: The segment hash.
+ *   @seg: The segment.
+ *   @len: The segment length.
+ *   @node: The child node, null for an empty slot.
+ */
+struct edge_t {
+	uint32_t hash;
+	char *seg;
+	size_t len;
+	struct node_t *node;
+};
+
+/**
+ * Parameter edge structure.
+ *   @type: The parameter type.
+ *   @suffix: The literal suffix following the parameter in the segment.
+ *   @len: The suffix length.
+ *   @node: The child node.
+ *   @next: The next parameter edge.
+ */
+struct param_t {
+	enum type_e type;
+	char *suffix;
+	size_t len;
+	struct node_t *node;
+
+	struct param_t *next;
+};
+
+/**
+ * Deferred route structure.
+ *   @func: The handler.
+ *   @arg: The handler argument.
+ *   @param: The copied path parameters.
+ */
+struct defer_t {
+	http_route_f func;
+	void *arg;
+	struct http_param_t param[HTTP_PARAMS];
+};
+
+
+/*
+ * local declarations
+ */
+static struct node_t *node_new(void);
+static void node_delete(struct node_t *node);
+static struct node_t *node_match(struct node_t *node, const char *str, const char *end, struct http_param_t *param, unsigned int n);
+static struct node_t *node_static(struct node_t *node, const char *seg, size_t len, bool add);
+static struct node_t *node_param(struct node_t *node, enum type_e type, const char *suffix, size_t len);
+
+static bool defer_proc(struct http_args_t *args, void *arg);
+static void defer_delete(void *arg);
+
+
+/**
+ * Create a new router.
+ *   &returns: The router.
+ */
+struct http_router_t *http_router_new(void)
+{
+	struct http_router_t *router;
+
+	router = malloc(sizeof(struct http_router_t));
+	router->root = node_new();
+
+	return router;
+}
+
+/**
+ * Delete a router.
+ *   @router: The router.
+ */
+void http_router_delete(struct http_router_t *router)
+{
+	node_delete(router->root);
+	free(router);
+}
+
+
+/**
+ * Add a route to the router. Each segment of the pattern is either static
+ * text, a string parameter ':name', or an unsigned integer parameter
+ * '#name'. A parameter may be followed by a literal suffix, such as
+ * ':name.mp3'. Static segments take precedence over parameters. A route
+ * flagged with 'HTTP_ROUTE_BLOCK' may block, so it is handed to a worker
+ * thread when the server has any. A route flagged with 'HTTP_ROUTE_STREAM'
+ * is called as soon as the request is offered, before its body is read, so
+ * that it may take the body with 'http_args_input'; other routes only see
+ * requests with their whole body.
+ *   @router: The router.
+ *   @pattern: The path pattern.
+ *   @func: The handler.
+ *   @arg: The handler argument.
+ *   @flags: The route flags.
+ *   &returns: Error.
+ */
+char *http_router_add(struct http_router_t *router, const char *pattern, http_route_f func, void *arg, unsigned int flags)
+{
+#define onexit
+	size_t len;
+	const char *str, *next;
+	unsigned int n = 0;
+	struct node_t *node = router->root;
+
+	if(pattern[0] != '/')
+		fail("Invalid route '%s'. Routes must begin with '/'.", pattern);
+
+	for(str = pattern + 1; ; str = next + 1) {
+		next = strchr(str, '/');
+		len = next ? (size_t)(next - str) : strlen(str);
+
+		if((str[0] == ':') || (str[0] == '#')) {
+			const char *suffix;
+
+			for(suffix = str + 1; isalnum((unsigned char)*suffix) || (*suffix == '_'); suffix++)
+				;
+
+			if(++n > HTTP_PARAMS)
+				fail("Invalid route '%s'. Too many parameters.", pattern);
+
+			node = node_param(node, (str[0] == '#') ? uint_v : str_v, suffix, str + len - suffix);
+		}
+		else
+			node = node_static(node, str, len, true);
+
+		if(next == NULL)
+			break;
+	}
+
+	if(node->func != NULL)
+		fail("Duplicate route '%s'.", pattern);
+
+	node->func = func;
+	node->arg = arg;
+	node->flags = flags;
+
+	return NULL;
+#undef onexit
+}
+
+/**
+ * Process a request through the router. The query string, if any, is
+ * ignored for matching.
+ *   @path: The path.
+ *   @args: The request arguments.
+ *   @arg: The router.
+ *   &returns: True if handled, false otherwise.
+ */
+bool http_router_proc(const char *path, struct http_args_t *args, void *arg)
+{
+	const char *end;
+	struct node_t *node;
+	struct http_router_t *router = arg;
+	struct http_param_t param[HTTP_PARAMS];
+
+	if(path[0] != '/')
+		return false;
+
+	end = strchr(path, '?');
+	if(end == NULL)
+		end = path + strlen(path);
+
+	node = node_match(router->root, path + 1, end, param, 0);
+	if(node == NULL)
+		return false;
+	else if((args->body == NULL) && !(node->flags & HTTP_ROUTE_STREAM))
+		return false;
+
+	if(node->flags & HTTP_ROUTE_BLOCK) {
+		struct defer_t *defer;
+
+		defer = malloc(sizeof(struct defer_t));
+		defer->func = node->func;
+		defer->arg = node->arg;
+		memcpy(defer->param, param, sizeof(param));
+
+		if(http_args_defer(args, defer_proc, defer, defer_delete))
+			return true;
+
+		free(defer);
+	}
+
+	return node->func(args, param, node->arg);
+}
+
+
+/**
+ * Create a new node.
+ *   &returns: The node.
+ */
+static struct node_t *node_new(void)
+{
+	struct node_t *node;
+
+	node = malloc(sizeof(struct node_t));
+	node->cnt = node->size = 0;
+	node->edge = NULL;
+	node->param = NULL;
+	node->func = NULL;
+	node->arg = NULL;
+	node->flags = 0;
+
+	return node;
+}
+
+/**
+ * Delete a node and all of its children.
+ *   @node: The node.
+ */
+static void node_delete(struct node_t *node)
+{
+	unsigned int i;
+	struct param_t *param;
+
+	for(i = 0; i < node->size; i++) {
+		if(node->edge[i].node != NULL) {
+			free(node->edge[i].seg);
+			node_delete(node->edge[i].node);
+		}
+	}
+
+	while(node->param != NULL) {
+		param = node->param;
+		node->param = param->next;
+
+		free(param->suffix);
+		node_delete(param->node);
+		free(param);
+	}
+
+	erase(node->edge);
+	free(node);
+}
+
+/**
+ * Match the remaining path against a node, filling in the parameters.
+ *   @node: The node.
+ *   @str: The remaining path, at the start of a segment.
+ *   @end: The end of the path.
+ *   @param: The parameter array.
+ *   @n: The number of parameters matched so far.
+ *   &returns: The matched node or null.
+ */
+static struct node_t *node_match(struct node_t *node, const char *str, const char *end, struct http_param_t *param, unsigned int n)
+{
+	size_t len;
+	const char *next;
+	struct param_t *edge;
+	struct node_t *child, *match;
+
+	next = memchr(str, '/', end - str);
+	if(next == NULL)
+		next = end;
+
+	len = next - str;
+
+	child = node_static(node, str, len, false);
+	if(child != NULL) {
+		match = (next == end) ? child : node_match(child, next + 1, end, param, n);
+		if((match != NULL) && (match->func != NULL))
+			return match;
+	}
+
+	for(edge = node->param; edge != NULL; edge = edge->next) {
+		size_t i, plen;
+		uint64_t num = 0;
+
+		if((len <= edge->len) || (memcmp(str + len - edge->len, edge->suffix, edge->len) != 0))
+			continue;
+
+		plen = len - edge->len;
+
+		if(edge->type == uint_v) {
+			for(i = 0; i < plen; i++) {
+				if(!isdigit((unsigned char)str[i]) || (num > (UINT64_MAX - (str[i] - '0')) / 10))
+					break;
+
+				num = 10 * num + (str[i] - '0');
+			}
+
+			if(i < plen)
+				continue;
+		}
+
+		param[n] = (struct http_param_t){ str, plen, num };
+
+		match = (next == end) ? edge->node : node_match(edge->node, next + 1, end, param, n + 1);
+		if((match != NULL) && (match->func != NULL))
+			return match;
+	}
+
+	return NULL;
+}
+
+/**
+ * Find or add the static child of a node.
+ *   @node: The node.
+ *   @seg: The segment.
+ *   @len: The segment length.
+ *   @add: Add the child if it does not exist.
+ *   &returns: The child, or null if not found and not added.
+ */
+static struct node_t *node_static(struct node_t *node, const char *seg, size_t len, bool add)
+{
+	uint32_t hash;
+	unsigned int i;
+	struct edge_t *edge;
+
+	hash = hash_fnv32(HASH_FNV32, seg, len);
+
+	if(node->size > 0) {
+		for(i = hash & (node->size - 1); node->edge[i].node != NULL; i = (i + 1) & (node->size - 1)) {
+			edge = &node->edge[i];
+			if((edge->hash == hash) && (edge->len == len) && (memcmp(edge->seg, seg, len) == 0))
+				return edge->node;
+		}
+	}
+
+	if(!add)
+		return NULL;
+
+	if((2 * (node->cnt + 1)) > node->size) {
+		unsigned int j, size = node->size ? (2 * node->size) : 4;
+		struct edge_t *arr;
+
+		arr = malloc(size * sizeof(struct edge_t));
+		for(i = 0; i < size; i++)
+			arr[i].node = NULL;
+
+		for(i = 0; i < node->size; i++) {
+			if(node->edge[i].node == NULL)
+				continue;
+
+			for(j = node->edge[i].hash & (size - 1); arr[j].node != NULL; j = (j + 1) & (size - 1))
+				;
+
+			arr[j] = node->edge[i];
+		}
+
+		erase(node->edge);
+		node->edge = arr;
+		node->size = size;
+	}
+
+	for(i = hash & (node->size - 1); node->edge[i].node != NULL; i = (i + 1) & (node->size - 1))
+		;
+
+	edge = &node->edge[i];
+	edge->hash = hash;
+	edge->seg = malloc(len + 1);
+	memcpy(edge->seg, seg, len);
+	edge->seg[len] = '\0';
+	edge->len = len;
+	edge->node = node_new();
+	node->cnt++;
+
+	return edge->node;
+}
+
+/**
+ * Find or add the parameter child of a node.
+ *   @node: The node.
+ *   @type: The parameter type.
+ *   @suffix: The literal suffix.
+ *   @len: The suffix length.
+ *   &returns: The child.
+ */
+static struct node_t *node_param(struct node_t *node, enum type_e type, const char *suffix, size_t len)
+{
+	struct param_t **param;
+
+	for(param = &node->param; *param != NULL; param = &(*param)->next) {
+		if(((*param)->type == type) && ((*param)->len == len) && (memcmp((*param)->suffix, suffix, len) == 0))
+			return (*param)->node;
+	}
+
+	*param = malloc(sizeof(struct param_t));
+	(*param)->type = type;
+	(*param)->suffix = malloc(len + 1);
+	memcpy((*param)->suffix, suffix, len);
+	(*param)->suffix[len] = '\0';
+	(*param)->len = len;
+	(*param)->node = node_new();
+	(*param)->next = NULL;
+
+	return (*param)->node;
+}
+
+
+/**
+ * Run a deferred route on a worker thread.
+ *   @args: The request arguments.
+ *   @arg: The deferred route.
+ *   &returns: True if handled, false otherwise.
+ */
+static bool defer_proc(struct http_args_t *args, void *arg)
+{
+	struct defer_t *defer = arg;
+
+	return defer->func(args, defer->param, defer->arg);
+}
+
+/**
+ * Delete a deferred route.
+ *   @arg: The deferred route.
+ */
+static void defer_delete(void *arg)
+{
+	free(arg);
+}
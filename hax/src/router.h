@@ -0,0 +1,61 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+/*
+ * router definitions
+ */
+#define HTTP_PARAMS	8
+
+/*
+ * route flags
+ */
+#define HTTP_ROUTE_BLOCK	0x01
+#define HTTP_ROUTE_STREAM	0x02
+
+/**
+ * Route parameter structure.
+ *   @str: The parameter text, not null-terminated.
+ *   @len: The length of the text.
+ *   @num: The value of an integer parameter.
+ */
+struct http_param_t {
+	const char *str;
+	size_t len;
+	uint64_t num;
+};
+
+/**
+ * Route handler callback.
+ *   @args: The request arguments.
+ *   @param: The path parameters, in the order they appear.
+ *   @arg: The argument.
+ *   &returns: True if handled, false otherwise.
+ */
+typedef bool (*http_route_f)(struct http_args_t *args, const struct http_param_t *param, void *arg);
+
+/*
+ * structure prototypes
+ */
+struct http_router_t;
+
+/*
+ * router declarations
+ */
+struct http_router_t *http_router_new(void);
+void http_router_delete(struct http_router_t *router);
+
+char *http_router_add(struct http_router_t *router, const char *pattern, http_route_f func, void *arg, unsigned int flags);
+bool http_router_proc(const char *path, struct http_args_t *args, void *arg);
+
+/**
+ * Check if a parameter equals a string.
+ *   @param: The parameter.
+ *   @str: The string.
+ *   &returns: True if equal.
+ */
+static inline bool http_param_eq(const struct http_param_t *param, const char *str)
+{
+	return (strncmp(param->str, str, param->len) == 0) && (str[param->len] == '\0');
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "common.h"
+
+
+/*
+ * local declarations
+ */
+static void sha1_block(uint32_t *h, const uint8_t *block);
+
+
+/**
+ * Initialize a SHA-1 computation.
+ *   &returns: The state.
+ */
+struct sha1_t sha1_init(void)
+{
+	return (struct sha1_t){ { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 }, 0 };
+}
+
+/**
+ * Process data into a SHA-1 computation.
+ *   @sha1: The state.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ */
+void sha1_proc(struct sha1_t *sha1, const void *buf, size_t nbytes)
+{
+	size_t n, idx;
+	const uint8_t *ptr = buf;
+
+	idx = sha1->len % 64;
+	sha1->len += nbytes;
+
+	while(nbytes > 0) {
+		n = (nbytes < (64 - idx)) ? nbytes : (64 - idx);
+		memcpy(sha1->buf + idx, ptr, n);
+		ptr += n;
+		nbytes -= n;
+		idx += n;
+
+		if(idx == 64) {
+			sha1_block(sha1->h, sha1->buf);
+			idx = 0;
+		}
+	}
+}
+
+/**
+ * Finish a SHA-1 computation.
+ *   @sha1: The state, unusable afterwards.
+ *   @digest: The output digest of 'SHA1_LEN' bytes.
+ */
+void sha1_finish(struct sha1_t *sha1, uint8_t *digest)
+{
+	unsigned int i;
+	uint8_t pad[72];
+	uint64_t bits = 8 * sha1->len;
+	size_t n;
+
+	n = 64 - ((sha1->len + 8) % 64);
+	memset(pad, 0x00, n);
+	pad[0] = 0x80;
+	for(i = 0; i < 8; i++)
+		pad[n + i] = bits >> (56 - 8 * i);
+
+	sha1_proc(sha1, pad, n + 8);
+
+	for(i = 0; i < SHA1_LEN; i++)
+		digest[i] = sha1->h[i / 4] >> (24 - 8 * (i % 4));
+}
+
+
+/**
+ * Process a single block into the hash state.
+ *   @h: The hash state.
+ *   @block: The 64-byte block.
+ */
+static void sha1_block(uint32_t *h, const uint8_t *block)
+{
+	unsigned int i;
+	uint32_t w[80], a, b, c, d, e, f, k, t;
+
+	for(i = 0; i < 16; i++)
+		w[i] = ((uint32_t)block[4*i] << 24) | ((uint32_t)block[4*i+1] << 16) | ((uint32_t)block[4*i+2] << 8) | (uint32_t)block[4*i+3];
+
+	for(i = 16; i < 80; i++) {
+		t = w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16];
+		w[i] = (t << 1) | (t >> 31);
+	}
+
+	a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+	for(i = 0; i < 80; i++) {
+		if(i < 20)
+			f = (b & c) | (~b & d), k = 0x5a827999;
+		else if(i < 40)
+			f = b ^ c ^ d, k = 0x6ed9eba1;
+		else if(i < 60)
+			f = (b & c) | (b & d) | (c & d), k = 0x8f1bbcdc;
+		else
+			f = b ^ c ^ d, k = 0xca62c1d6;
+
+		t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = (b << 30) | (b >> 2);
+		b = a;
+		a = t;
+	}
+
+	h[0] += a, h[1] += b, h[2] += c, h[3] += d, h[4] += e;
+}
@@ -0,0 +1,28 @@
+#ifndef SHA1_H
+#define SHA1_H
+
+/*
+ * sha1 definitions
+ */
+#define SHA1_LEN	20
+
+/**
+ * SHA-1 state structure.
+ *   @h: The hash state.
+ *   @len: The number of bytes processed.
+ *   @buf: The partial block.
+ */
+struct sha1_t {
+	uint32_t h[5];
+	uint64_t len;
+	uint8_t buf[64];
+};
+
+/*
+ * sha1 declarations
+ */
+struct sha1_t sha1_init(void);
+void sha1_proc(struct sha1_t *sha1, const void *buf, size_t nbytes);
+void sha1_finish(struct sha1_t *sha1, uint8_t *digest);
+
+#endif
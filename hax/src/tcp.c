@@ -5,20 +5,42 @@
  * default defintions
  */
 #define DEFSIZE	(16*1024)
+#define DEFFILE	(64*1024)
+#define DEFIOV	16
 
 
+/**
+ * Input buffer structure. Received data is kept contiguous so that it may
+ * be scanned in place.
+ *   @idx, len, size: The read index, data length, and allocated size.
+ *   @arr: The byte array.
+ */
+struct input_t {
+	size_t idx, len, size;
+	uint8_t *arr;
+};
+
 /**
  * Client structure.
  *   @sock: The socket.
  *   @defsize: The default read size.
- *   @in, out: The input and output data lists.
+ *   @limit: The number of available bytes at which reading stops.
+ *   @in: The input buffer.
+ *   @out: The output data list.
+ *   @nqueue: The number of queued bytes.
+ *   @npend: The number of pending writes.
+ *   @eof: End-of-stream flag.
  *   @events: The pending events.
  */
 struct tcp_client_t {
 	sys_sock_t sock;
 
-	size_t defsize;
-	struct data_t *in, *out;
+	size_t defsize, limit;
+	struct input_t in;
+	struct data_t *out;
+	size_t nqueue;
+	unsigned int npend;
+	bool eof;
 
 	enum sys_poll_e events;
 };
@@ -32,19 +54,39 @@ struct tcp_server_t {
 };
 
 /**
- * Data structure.
+ * Data structure. Data is either copied into the inline buffer, refers to
+ * an external buffer, or refers to a file region sent directly from the
+ * file; external data is released once sent.
  *   @next: The next data.
  *   @idx, len: The index length.
- *   @buf: The buffer.
+ *   @ptr: The data pointer.
+ *   @fd: The file descriptor, negative if not a file region.
+ *   @off: The file offset.
+ *   @delete: Optional. The external data deleter.
+ *   @arg: The deleter argument.
+ *   @buf: The inline buffer.
  */
 struct data_t {
 	struct data_t *next;
 
 	size_t idx, len;
+	const uint8_t *ptr;
+	int fd;
+	int64_t off;
+	delete_f delete;
+	void *arg;
+
 	uint8_t buf[];
 };
 
 
+/*
+ * local declarations
+ */
+static void data_append(struct tcp_client_t *client, struct data_t *data, size_t nbytes);
+static void data_delete(struct data_t *data);
+
+
 /**
  * Create a client from a socket.
  *   @sock: The socket.
@@ -55,7 +97,7 @@ struct tcp_client_t *tcp_client_new(sys_sock_t sock)
 	struct tcp_client_t *client;
 
 	client = malloc(sizeof(struct tcp_client_t));
-	*client = (struct tcp_client_t){ sock, 16*1024, NULL, NULL, 0 };
+	*client = (struct tcp_client_t){ sock, DEFSIZE, SIZE_MAX, { 0, 0, 0, NULL }, NULL, 0, 0, false, 0 };
 
 	return client;
 }
@@ -68,14 +110,11 @@ void tcp_client_delete(struct tcp_client_t *client)
 {
 	struct data_t *cur, *next;
 
-	for(cur = client->in; cur != NULL; cur = next) {
-		next = cur->next;
-		free(cur);
-	}
+	erase(client->in.arr);
 
 	for(cur = client->out; cur != NULL; cur = next) {
 		next = cur->next;
-		free(cur);
+		data_delete(cur);
 	}
 
 	free(client);
@@ -123,13 +162,30 @@ sys_sock_t tcp_client_sock(struct tcp_client_t *client)
 }
 
 /**
- * Retrieve the file descriptor of the client.
+ * Retrieve the poll information of the client. Input is only polled while
+ * below the input limit.
  *   @client: The client.
- *   &returns: The file descriptor.
+ *   &returns: The poll information.
  */
 struct sys_poll_t tcp_client_poll(struct tcp_client_t *client)
 {
-	return sys_poll_sock(client->sock, sys_poll_in_e | sys_poll_err_e | (client->out ? sys_poll_out_e : 0));
+	bool in = !client->eof && (tcp_client_avail(client) < client->limit);
+
+	return sys_poll_sock(client->sock, (in ? sys_poll_in_e : 0) | sys_poll_err_e | (client->out ? sys_poll_out_e : 0));
+}
+
+/**
+ * Limit the input buffered on a client. Once the number of available bytes
+ * reaches the limit, no more is read from the socket until consumed, so
+ * that a peer cannot grow the buffer while its input is not being
+ * processed.
+ *   @client: The client.
+ *   @limit: The limit in bytes, zero to stop reading, or 'SIZE_MAX' for
+ *     none.
+ */
+void tcp_client_limit(struct tcp_client_t *client, size_t limit)
+{
+	client->limit = limit;
 }
 
 /**
@@ -139,13 +195,7 @@ struct sys_poll_t tcp_client_poll(struct tcp_client_t *client)
  */
 size_t tcp_client_avail(struct tcp_client_t *client)
 {
-	struct data_t *data;
-	size_t nbytes = 0;
-
-	for(data = client->in; data != NULL; data = data->next)
-		nbytes += data->len - data->idx;
-
-	return nbytes;
+	return client->in.len - client->in.idx;
 }
 
 /**
@@ -155,13 +205,28 @@ size_t tcp_client_avail(struct tcp_client_t *client)
  */
 size_t tcp_client_queue(struct tcp_client_t *client)
 {
-	struct data_t *data;
-	size_t nbytes = 0;
+	return client->nqueue;
+}
 
-	for(data = client->out; data != NULL; data = data->next)
-		nbytes += data->len - data->idx;
+/**
+ * Retrieve the number of pending writes on a client, each write counting
+ * once until fully sent.
+ *   @client: The client.
+ *   &returns: The number of writes.
+ */
+unsigned int tcp_client_pending(struct tcp_client_t *client)
+{
+	return client->npend;
+}
 
-	return nbytes;
+/**
+ * Check if the peer has closed its side of the connection.
+ *   @client: The client.
+ *   &returns: True at end-of-stream.
+ */
+bool tcp_client_eof(struct tcp_client_t *client)
+{
+	return client->eof;
 }
 
 
@@ -174,34 +239,42 @@ size_t tcp_client_queue(struct tcp_client_t *client)
  */
 bool tcp_client_read(struct tcp_client_t *client, void *restrict buf, size_t nbytes)
 {
-	size_t len;
-	struct data_t *data;
-
 	if(tcp_client_avail(client) < nbytes) {
 		client->events |= sys_poll_in_e;
 		return false;
 	}
 
-	while(nbytes > 0) {
-		data = client->in;
-		if(nbytes < (data->len - data->idx))
-			len = nbytes;
-		else
-			len = data->len - data->idx;
+	memcpy(buf, client->in.arr + client->in.idx, nbytes);
+	tcp_client_consume(client, nbytes);
 
-		memcpy(buf, data->buf + data->idx, len);
+	return true;
+}
 
-		nbytes -= len;
-		data->idx += len;
+/**
+ * Retrieve the available input in place without consuming it.
+ *   @client: The client.
+ *   @nbytes: Ref. The number of available bytes.
+ *   &returns: The contiguous input data.
+ */
+const void *tcp_client_peek(struct tcp_client_t *client, size_t *nbytes)
+{
+	*nbytes = client->in.len - client->in.idx;
 
-		if(data->idx != data->len)
-			break;
+	return client->in.arr + client->in.idx;
+}
 
-		client->in = data->next;
-		free(data);
-	}
+/**
+ * Consume available input.
+ *   @client: The client.
+ *   @nbytes: The number of bytes, at most the number available.
+ */
+void tcp_client_consume(struct tcp_client_t *client, size_t nbytes)
+{
+	assert(nbytes <= (client->in.len - client->in.idx));
 
-	return true;
+	client->in.idx += nbytes;
+	if(client->in.idx == client->in.len)
+		client->in.idx = client->in.len = 0;
 }
 
 /**
@@ -212,75 +285,174 @@ bool tcp_client_read(struct tcp_client_t *client, void *restrict buf, size_t nby
  */
 void tcp_client_write(struct tcp_client_t *client, const void *restrict buf, size_t nbytes)
 {
-	struct data_t **data;
+	struct data_t *data;
 
-	data = &client->out;
-	while(*data != NULL)
-		data = &(*data)->next;
+	data = malloc(sizeof(struct data_t) + nbytes);
+	data->ptr = data->buf;
+	data->fd = -1;
+	data->delete = NULL;
+	memcpy(data->buf, buf, nbytes);
 
-	*data = malloc(sizeof(struct data_t) + nbytes);
-	(*data)->idx = 0;
-	(*data)->len = nbytes;
-	(*data)->next = NULL;
-	memcpy((*data)->buf, buf, nbytes);
+	data_append(client, data, nbytes);
+}
 
-	client->events |= sys_poll_out_e;
+/**
+ * Write an external buffer to a TCP connection without copying. The
+ * buffer must remain valid until released by the deleter.
+ *   @client: The client.
+ *   @buf: The buffer.
+ *   @nbytes: The number of bytes.
+ *   @delete: Optional. The deleter, called once the buffer is sent or the
+ *     connection is closed.
+ *   @arg: The deleter argument.
+ */
+void tcp_client_writeref(struct tcp_client_t *client, const void *buf, size_t nbytes, delete_f delete, void *arg)
+{
+	struct data_t *data;
+
+	data = malloc(sizeof(struct data_t));
+	data->ptr = buf;
+	data->fd = -1;
+	data->delete = delete;
+	data->arg = arg;
+
+	data_append(client, data, nbytes);
+}
+
+/**
+ * Write a file region to a TCP connection, sent directly from the file
+ * without passing through user space. The file must remain open until
+ * released by the deleter.
+ *   @client: The client.
+ *   @fd: The file descriptor.
+ *   @off: The offset into the file.
+ *   @nbytes: The number of bytes.
+ *   @delete: Optional. The deleter, called once the region is sent or the
+ *     connection is closed.
+ *   @arg: The deleter argument.
+ */
+void tcp_client_sendfile(struct tcp_client_t *client, int fd, int64_t off, size_t nbytes, delete_f delete, void *arg)
+{
+	struct data_t *data;
+
+	data = malloc(sizeof(struct data_t));
+	data->ptr = NULL;
+	data->fd = fd;
+	data->off = off;
+	data->delete = delete;
+	data->arg = arg;
+
+	data_append(client, data, nbytes);
 }
 
 /**
- * Process data on a client.
+ * Process data on a client. Input is read up to the input limit, and
+ * queued output is sent without blocking, so a slow peer leaves the
+ * remainder queued until the socket is writable.
  *   @client: The client.
  *   @events: The events.
  *   &returns: The success flag.
  */
 bool tcp_client_proc(struct tcp_client_t *client, enum sys_poll_e events)
 {
-	if(events & sys_poll_in_e) {
+	if((events & sys_poll_in_e) && !client->eof && (tcp_client_avail(client) < client->limit)) {
 		ssize_t ret;
-		struct data_t **ref, *data;
-
-		data = malloc(sizeof(struct data_t) + DEFSIZE);
-
-		ret = sys_recv(client->sock, data->buf, DEFSIZE, 0);
-		if(ret <= 0) {
-			free(data);
-			return false;
+		size_t want;
+		struct input_t *in = &client->in;
+
+		if((in->size - in->len) < client->defsize) {
+			if(in->idx > 0) {
+				memmove(in->arr, in->arr + in->idx, in->len - in->idx);
+				in->len -= in->idx;
+				in->idx = 0;
+			}
+
+			if((in->size - in->len) < client->defsize) {
+				in->size = in->size ? (2 * in->size) : client->defsize;
+				if(in->arr == NULL)
+					in->arr = malloc(in->size);
+				else
+					in->arr = realloc(in->arr, in->size);
+			}
 		}
 
-		data->next = NULL;
-		data->idx = 0;
-		data->len = ret;
-
-		ref = &client->in;
-		while(*ref != NULL)
-			ref = &(*ref)->next;
+		want = client->limit - (in->len - in->idx);
+		if(want > (in->size - in->len))
+			want = in->size - in->len;
 
-		data = realloc(data, sizeof(struct data_t) + data->len);
-		*ref = data;
+		ret = sys_recv(client->sock, in->arr + in->len, want, 0);
+		if(ret > 0)
+			in->len += ret;
+		else if(ret == 0)
+			client->eof = true;
+		else if(errno != EAGAIN)
+			return false;
 
 		client->events &= ~sys_poll_in_e;
 	}
 
 	if(events & sys_poll_out_e) {
-		struct data_t *data;
+		if(!tcp_client_flush(client))
+			return false;
 
-		while(client->out != NULL) {
-			ssize_t ret;
+		client->events &= ~sys_poll_out_e;
+	}
 
-			data = client->out;
-			ret = sys_send(client->sock, data->buf + data->idx, data->len - data->idx, 0);
-			if(ret <= 0)
-				return false;
+	return true;
+}
 
-			data->idx += ret;
-			if(data->idx != data->len)
-				break;
+/**
+ * Send as much queued output as possible without blocking. Consecutive
+ * buffers are gathered into a single call, so that a response head and
+ * body leave together; file regions are sent one bounded piece at a time.
+ *   @client: The client.
+ *   &returns: The success flag.
+ */
+bool tcp_client_flush(struct tcp_client_t *client)
+{
+	bool full;
+	ssize_t ret;
+	size_t want;
+	unsigned int cnt;
+	struct data_t *data;
+	struct iovec iov[DEFIOV];
+
+	while(client->out != NULL) {
+		data = client->out;
+		if(data->fd >= 0) {
+			int64_t off = data->off + data->idx;
 
+			want = ((data->len - data->idx) < DEFFILE) ? (data->len - data->idx) : DEFFILE;
+			ret = sys_sendfile(client->sock, data->fd, &off, want);
+		}
+		else {
+			want = 0;
+			for(cnt = 0; (cnt < DEFIOV) && (data != NULL) && (data->fd < 0); cnt++, data = data->next) {
+				iov[cnt] = (struct iovec){ (void *)(data->ptr + data->idx), data->len - data->idx };
+				want += data->len - data->idx;
+			}
+
+			ret = sys_sendv(client->sock, iov, cnt, MSG_DONTWAIT);
+		}
+
+		if(ret < 0)
+			return false;
+
+		client->nqueue -= ret;
+		full = ((size_t)ret == want) && (client->out->fd < 0);
+
+		while(((data = client->out) != NULL) && ((size_t)ret >= (data->len - data->idx))) {
+			ret -= data->len - data->idx;
 			client->out = data->next;
-			free(data);
+			client->npend--;
+			data_delete(data);
 		}
 
-		client->events &= ~sys_poll_out_e;
+		if(data != NULL)
+			data->idx += ret;
+
+		if(!full)
+			break;
 	}
 
 	return true;
@@ -288,23 +460,73 @@ bool tcp_client_proc(struct tcp_client_t *client, enum sys_poll_e events)
 
 
 /**
- * Open a TCP server.
+ * Append data to the output queue of a client.
+ *   @client: The client.
+ *   @data: Consumed. The data.
+ *   @nbytes: The number of bytes.
+ */
+static void data_append(struct tcp_client_t *client, struct data_t *data, size_t nbytes)
+{
+	struct data_t **ref;
+
+	data->idx = 0;
+	data->len = nbytes;
+	data->next = NULL;
+
+	ref = &client->out;
+	while(*ref != NULL)
+		ref = &(*ref)->next;
+
+	*ref = data;
+
+	client->nqueue += nbytes;
+	client->npend++;
+	client->events |= sys_poll_out_e;
+}
+
+/**
+ * Delete data, releasing any external buffer.
+ *   @data: The data.
+ */
+static void data_delete(struct data_t *data)
+{
+	if(data->delete != NULL)
+		data->delete(data->arg);
+
+	free(data);
+}
+
+
+/**
+ * Open a TCP server. The listening socket is non-blocking, so the accept
+ * queue can be drained until empty. With 'TCP_REUSEPORT', several servers
+ * may bind the same port and the kernel spreads incoming connections
+ * across them.
  *   @server: Ref. The server.
  *   @port: The port.
+ *   @flags: The flags.
  *   &returns: Error.
  */
-char *tcp_server_open(struct tcp_server_t **server, uint16_t port)
+char *tcp_server_open(struct tcp_server_t **server, uint16_t port, unsigned int flags)
 {
 #define onexit if(sys_issock(sock)) sys_closesocket(sock);
 	int val;
 	struct sockaddr_in addr;
 	sys_sock_t sock = sys_badsock;
 
-	chkfail(sys_socket(&sock, AF_INET, SOCK_STREAM, 0));
+	chkfail(sys_socket(&sock, AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
 
 	val = 1;
 	chkfail(sys_setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(int)));
 
+	if(flags & TCP_REUSEPORT) {
+#ifdef SO_REUSEPORT
+		chkfail(sys_setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(int)));
+#else
+		fail("Sharing a port is not supported.");
+#endif
+	}
+
 	memset(&addr, 0x00, sizeof(addr));
 	addr.sin_family = AF_INET;
 	addr.sin_addr.s_addr = INADDR_ANY;
@@ -366,9 +588,10 @@ char *tcp_server_listen(struct tcp_server_t *server)
 }
 
 /**
- * Accept a new connection from the server.
+ * Accept a new connection from the server without blocking.
  *   @server: The server.
- *   @fd: Ref. The output file descriptor.
+ *   @fd: Ref. The output file descriptor, 'sys_badsock' if no connection is
+ *     pending.
  *   &returns: Error.
  */
 char *tcp_server_accept(struct tcp_server_t *server, sys_sock_t *fd)
@@ -14,12 +14,20 @@ void tcp_client_close(struct tcp_client_t *client);
 
 sys_sock_t tcp_client_sock(struct tcp_client_t *client);
 struct sys_poll_t tcp_client_poll(struct tcp_client_t *client);
+void tcp_client_limit(struct tcp_client_t *client, size_t limit);
 
 size_t tcp_client_avail(struct tcp_client_t *client);
 size_t tcp_client_queue(struct tcp_client_t *client);
+unsigned int tcp_client_pending(struct tcp_client_t *client);
+bool tcp_client_eof(struct tcp_client_t *client);
 
 bool tcp_client_read(struct tcp_client_t *client, void *restrict buf, size_t nbytes);
+const void *tcp_client_peek(struct tcp_client_t *client, size_t *nbytes);
+void tcp_client_consume(struct tcp_client_t *client, size_t nbytes);
 void tcp_client_write(struct tcp_client_t *client, const void *restrict buf, size_t nbytes);
+void tcp_client_writeref(struct tcp_client_t *client, const void *buf, size_t nbytes, delete_f delete, void *arg);
+void tcp_client_sendfile(struct tcp_client_t *client, int fd, int64_t off, size_t nbytes, delete_f delete, void *arg);
+bool tcp_client_flush(struct tcp_client_t *client);
 bool tcp_client_proc(struct tcp_client_t *client, enum sys_poll_e events);
 
 /*
@@ -27,7 +35,12 @@ bool tcp_client_proc(struct tcp_client_t *client, enum sys_poll_e events);
  */
 struct tcp_server_t;
 
-char *tcp_server_open(struct tcp_server_t **server, uint16_t port);
+/*
+ * tcp server definitions
+ */
+#define TCP_REUSEPORT	0x01
+
+char *tcp_server_open(struct tcp_server_t **server, uint16_t port, unsigned int flags);
 void tcp_server_close(struct tcp_server_t *server);
 
 char *tcp_server_listen(struct tcp_server_t *server);
@@ -1 +1,412 @@
 #include "../common.h"
+
+
+/*
+ * local declarations
+ */
+/**
+ * Handle type enumerator.
+ *   @poller_v: Poller.
+ *   @notify_v: Notifier.
+ */
+enum handle_v {
+	poller_v,
+	notify_v
+};
+
+/**
+ * Handle structure. WSAPoll only waits on sockets, so pollers and
+ * notifiers are handed out as pointers to this structure; file handles
+ * given to 'sys_poll' or a poller must be one of the two.
+ *   @type: The type.
+ *   @sock: The notifier socket.
+ *   @cnt, size: The number of files and the array size of a poller.
+ *   @next: The first file examined by the next wait, rotated for fairness.
+ *   @fds: The poller files.
+ *   @ref: The poller references.
+ */
+struct handle_t {
+	enum handle_v type;
+	SOCKET sock;
+
+	unsigned int cnt, size, next;
+	WSAPOLLFD *fds;
+	void **ref;
+};
+
+static struct handle_t *handle_get(sys_fd_t fd, enum handle_v type);
+static struct handle_t *poll_poller(struct sys_poll_t poll);
+static SOCKET poll_sock(struct sys_poll_t poll);
+static SHORT poll_events(enum sys_poll_e events);
+static enum sys_poll_e poll_revents(SHORT revents);
+static int poll_wait(WSAPOLLFD *fds, unsigned int n, int timeout);
+static unsigned int poller_find(struct handle_t *poller, SOCKET sock);
+
+
+/**
+ * Asynchronously poll files. A poller is ready for input whenever any of
+ * its files is ready.
+ *   @list: The poll structure list.
+ *   @n: The number of poll structures.
+ *   @timeout: The timeout in milliseconds. Negative waits forever.
+ *   &returns: True if on file wakeup, false on timeout.
+ */
+bool sys_poll(struct sys_poll_t *list, unsigned int n, int timeout)
+{
+	int err;
+	unsigned int i, k, cnt = 0;
+	WSAPOLLFD *fds;
+	struct handle_t *poller;
+
+	for(i = 0; i < n; i++)
+		cnt += ((poller = poll_poller(list[i])) != NULL) ? poller->cnt : 1;
+
+	fds = malloc((cnt ? cnt : 1) * sizeof(WSAPOLLFD));
+
+	for(i = cnt = 0; i < n; i++) {
+		if((poller = poll_poller(list[i])) != NULL) {
+			memcpy(fds + cnt, poller->fds, poller->cnt * sizeof(WSAPOLLFD));
+			cnt += poller->cnt;
+		}
+		else {
+			fds[cnt].fd = poll_sock(list[i]);
+			fds[cnt].events = poll_events(list[i].events);
+			fds[cnt].revents = 0;
+			cnt++;
+		}
+	}
+
+	err = poll_wait(fds, cnt, timeout);
+
+	for(i = cnt = 0; i < n; i++) {
+		list[i].revents = 0;
+
+		if((poller = poll_poller(list[i])) != NULL) {
+			for(k = 0; k < poller->cnt; k++) {
+				if(fds[cnt + k].revents != 0)
+					list[i].revents = sys_poll_in_e;
+			}
+
+			cnt += poller->cnt;
+		}
+		else
+			list[i].revents = poll_revents(fds[cnt++].revents);
+	}
+
+	free(fds);
+
+	return err > 0;
+}
+
+
+/**
+ * Create a poller. On Windows, the poller keeps an array of sockets that
+ * is handed to WSAPoll on each wait, so each wait costs time in the number
+ * of files watched.
+ *   &returns: The poller handle.
+ */
+sys_fd_t sys_poller_new(void)
+{
+	struct handle_t *poller;
+
+	poller = malloc(sizeof(struct handle_t));
+	*poller = (struct handle_t){ poller_v, INVALID_SOCKET, 0, 0, 0, NULL, NULL };
+
+	return (sys_fd_t)poller;
+}
+
+/**
+ * Delete a poller.
+ *   @fd: The poller handle.
+ */
+void sys_poller_delete(sys_fd_t fd)
+{
+	struct handle_t *poller = handle_get(fd, poller_v);
+
+	erase(poller->fds);
+	erase(poller->ref);
+	free(poller);
+}
+
+/**
+ * Add a file to a poller.
+ *   @fd: The poller handle.
+ *   @poll: The file and events.
+ *   @ref: The reference returned with its events.
+ */
+void sys_poller_add(sys_fd_t fd, struct sys_poll_t poll, void *ref)
+{
+	struct handle_t *poller = handle_get(fd, poller_v);
+
+	if(poller->cnt == poller->size) {
+		poller->size = poller->size ? (2 * poller->size) : 64;
+		poller->fds = poller->fds ? realloc(poller->fds, poller->size * sizeof(WSAPOLLFD)) : malloc(poller->size * sizeof(WSAPOLLFD));
+		poller->ref = poller->ref ? realloc(poller->ref, poller->size * sizeof(void *)) : malloc(poller->size * sizeof(void *));
+	}
+
+	poller->fds[poller->cnt].fd = poll_sock(poll);
+	poller->fds[poller->cnt].events = poll_events(poll.events);
+	poller->fds[poller->cnt].revents = 0;
+	poller->ref[poller->cnt] = ref;
+	poller->cnt++;
+}
+
+/**
+ * Modify the events of a file on a poller.
+ *   @fd: The poller handle.
+ *   @poll: The file and events.
+ *   @ref: The reference returned with its events.
+ */
+void sys_poller_mod(sys_fd_t fd, struct sys_poll_t poll, void *ref)
+{
+	unsigned int i;
+	struct handle_t *poller = handle_get(fd, poller_v);
+
+	i = poller_find(poller, poll_sock(poll));
+	poller->fds[i].events = poll_events(poll.events);
+	poller->ref[i] = ref;
+}
+
+/**
+ * Remove a file from a poller.
+ *   @fd: The poller handle.
+ *   @poll: The file.
+ */
+void sys_poller_remove(sys_fd_t fd, struct sys_poll_t poll)
+{
+	unsigned int i;
+	struct handle_t *poller = handle_get(fd, poller_v);
+
+	i = poller_find(poller, poll_sock(poll));
+	poller->cnt--;
+	poller->fds[i] = poller->fds[poller->cnt];
+	poller->ref[i] = poller->ref[poller->cnt];
+}
+
+/**
+ * Wait for events on a poller. A hangup is reported as input, so that the
+ * reader observes the end of file. When more files are ready than fit in
+ * the event array, the next wait starts after the last one reported.
+ *   @fd: The poller handle.
+ *   @event: The event array.
+ *   @n: The size of the event array.
+ *   @timeout: The timeout in milliseconds. Negative waits forever.
+ *   &returns: The number of events.
+ */
+unsigned int sys_poller_wait(sys_fd_t fd, struct sys_event_t *event, unsigned int n, int timeout)
+{
+	unsigned int i, k, cnt = 0;
+	struct handle_t *poller = handle_get(fd, poller_v);
+
+	if(poll_wait(poller->fds, poller->cnt, timeout) <= 0)
+		return 0;
+
+	for(k = 0; (k < poller->cnt) && (cnt < n); k++) {
+		i = (poller->next + k) % poller->cnt;
+		if(poller->fds[i].revents == 0)
+			continue;
+
+		event[cnt].ref = poller->ref[i];
+		event[cnt].revents = poll_revents(poller->fds[i].revents);
+		cnt++;
+	}
+
+	poller->next = (poller->next + k) % poller->cnt;
+
+	return cnt;
+}
+
+
+/**
+ * Create a notifier, a handle that becomes readable once signaled from any
+ * thread and stays readable until cleared. The notifier is a loopback UDP
+ * socket connected to itself, so that WSAPoll can wait on it.
+ *   &returns: The notifier handle.
+ */
+sys_fd_t sys_notify_new(void)
+{
+	int len;
+	u_long mode = 1;
+	struct sockaddr_in addr;
+	struct handle_t *notify;
+
+	notify = malloc(sizeof(struct handle_t));
+	*notify = (struct handle_t){ notify_v, INVALID_SOCKET, 0, 0, 0, NULL, NULL };
+
+	chkabort(sys_socket(&notify->sock, AF_INET, SOCK_DGRAM, 0));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	len = sizeof(addr);
+
+	if((bind(notify->sock, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR) ||
+	   (getsockname(notify->sock, (struct sockaddr *)&addr, &len) == SOCKET_ERROR) ||
+	   (connect(notify->sock, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR) ||
+	   (ioctlsocket(notify->sock, FIONBIO, &mode) == SOCKET_ERROR))
+		fatal("Failed to create notifier. %C.", sys_sockerr());
+
+	return (sys_fd_t)notify;
+}
+
+/**
+ * Delete a notifier.
+ *   @fd: The notifier handle.
+ */
+void sys_notify_delete(sys_fd_t fd)
+{
+	struct handle_t *notify = handle_get(fd, notify_v);
+
+	closesocket(notify->sock);
+	free(notify);
+}
+
+/**
+ * Signal a notifier.
+ *   @fd: The notifier handle.
+ */
+void sys_notify_signal(sys_fd_t fd)
+{
+	char one = 1;
+	struct handle_t *notify = handle_get(fd, notify_v);
+
+	if((send(notify->sock, &one, 1, 0) == SOCKET_ERROR) && (WSAGetLastError() != WSAEWOULDBLOCK))
+		fatal("Failed to signal notifier. %C.", sys_sockerr());
+}
+
+/**
+ * Clear all pending signals of a notifier.
+ *   @fd: The notifier handle.
+ */
+void sys_notify_clear(sys_fd_t fd)
+{
+	char buf[64];
+	struct handle_t *notify = handle_get(fd, notify_v);
+
+	while(recv(notify->sock, buf, sizeof(buf), 0) != SOCKET_ERROR)
+		;
+
+	if(WSAGetLastError() != WSAEWOULDBLOCK)
+		fatal("Failed to clear notifier. %C.", sys_sockerr());
+}
+
+
+/**
+ * Retrieve a poll handle of a given type.
+ *   @fd: The handle.
+ *   @type: The expected type.
+ *   &returns: The handle structure, or null if of another type.
+ */
+static struct handle_t *handle_get(sys_fd_t fd, enum handle_v type)
+{
+	struct handle_t *handle = (struct handle_t *)fd;
+
+	return (handle->type == type) ? handle : NULL;
+}
+
+/**
+ * Retrieve the poller of a poll structure.
+ *   @poll: The poll structure.
+ *   &returns: The poller, or null if a socket or notifier.
+ */
+static struct handle_t *poll_poller(struct sys_poll_t poll)
+{
+	return (poll.fd != NULL) ? handle_get(poll.fd, poller_v) : NULL;
+}
+
+/**
+ * Retrieve the socket to wait on for a poll structure, a notifier standing
+ * for its socket.
+ *   @poll: The poll structure.
+ *   &returns: The socket.
+ */
+static SOCKET poll_sock(struct sys_poll_t poll)
+{
+	struct handle_t *notify;
+
+	if(poll.fd == NULL)
+		return poll.sock;
+
+	notify = handle_get(poll.fd, notify_v);
+	if(notify == NULL)
+		fatal("Cannot poll a file handle that is not a notifier.");
+
+	return notify->sock;
+}
+
+/**
+ * Convert poll events to WSAPoll events. Errors are always reported, and
+ * WSAPoll rejects them as requested events.
+ *   @events: The poll events.
+ *   &returns: The WSAPoll events.
+ */
+static SHORT poll_events(enum sys_poll_e events)
+{
+	SHORT ret = 0;
+
+	ret |= (events & sys_poll_in_e) ? POLLRDNORM : 0;
+	ret |= (events & sys_poll_out_e) ? POLLWRNORM : 0;
+
+	return ret;
+}
+
+/**
+ * Convert WSAPoll received events to poll events, a hangup counting as
+ * both input and error.
+ *   @revents: The WSAPoll events.
+ *   &returns: The poll events.
+ */
+static enum sys_poll_e poll_revents(SHORT revents)
+{
+	enum sys_poll_e ret = 0;
+
+	ret |= (revents & (POLLRDNORM | POLLHUP)) ? sys_poll_in_e : 0;
+	ret |= (revents & POLLWRNORM) ? sys_poll_out_e : 0;
+	ret |= (revents & (POLLERR | POLLHUP | POLLNVAL)) ? sys_poll_err_e : 0;
+
+	return ret;
+}
+
+/**
+ * Wait on a set of sockets. WSAPoll rejects an empty set, so an empty wait
+ * only sleeps.
+ *   @fds: The socket array.
+ *   @n: The number of sockets.
+ *   @timeout: The timeout in milliseconds. Negative waits forever.
+ *   &returns: The number of ready sockets.
+ */
+static int poll_wait(WSAPOLLFD *fds, unsigned int n, int timeout)
+{
+	int err;
+
+	if(n == 0) {
+		Sleep((timeout < 0) ? INFINITE : (DWORD)timeout);
+
+		return 0;
+	}
+
+	err = WSAPoll(fds, n, timeout);
+	if(err == SOCKET_ERROR)
+		fatal("Poll failed. %C.", sys_sockerr());
+
+	return err;
+}
+
+/**
+ * Find the index of a socket on a poller.
+ *   @poller: The poller.
+ *   @sock: The socket.
+ *   &returns: The index.
+ */
+static unsigned int poller_find(struct handle_t *poller, SOCKET sock)
+{
+	unsigned int i;
+
+	for(i = 0; i < poller->cnt; i++) {
+		if(poller->fds[i].fd == sock)
+			return i;
+	}
+
+	fatal("Socket missing from poller.");
+}
@@ -100,6 +100,57 @@ size_t sys_send(sys_sock_t sock, const void *buf, size_t nbytes, int flags)
 	return ret;
 }
 
+/**
+ * Write data gathered from several buffers on a socket. Only the first
+ * non-empty buffer is written per call.
+ *   @sock: The socket.
+ *   @iov: The buffer array.
+ *   @cnt: The number of buffers.
+ *   @flags: The flags.
+ *   &returns: The number of bytes written.
+ */
+size_t sys_sendv(sys_sock_t sock, const struct iovec *iov, unsigned int cnt, int flags)
+{
+	unsigned int i;
+
+	for(i = 0; i < cnt; i++) {
+		if(iov[i].iov_len > 0)
+			return sys_send(sock, iov[i].iov_base, iov[i].iov_len, flags);
+	}
+
+	return 0;
+}
+
+/**
+ * Write data from a file on a socket, reading through a buffer.
+ *   @sock: The socket.
+ *   @fd: The file descriptor.
+ *   @off: Ref. The file offset, advanced by the number of bytes written.
+ *   @nbytes: The number of bytes.
+ *   &returns: The number of bytes written.
+ */
+size_t sys_sendfile(sys_sock_t sock, int fd, int64_t *off, size_t nbytes)
+{
+	int rd;
+	size_t ret;
+	uint8_t buf[16*1024];
+
+	if(nbytes > sizeof(buf))
+		nbytes = sizeof(buf);
+
+	if(_lseeki64(fd, *off, SEEK_SET) < 0)
+		fatal("Failed to seek file. %s.", strerror(errno));
+
+	rd = _read(fd, buf, nbytes);
+	if(rd <= 0)
+		fatal("Failed to read file. %s.", strerror(errno));
+
+	ret = sys_send(sock, buf, rd, 0);
+	*off += ret;
+
+	return ret;
+}
+
 
 /**
  * Bind a socket.
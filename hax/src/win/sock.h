@@ -1,6 +1,17 @@
 #ifndef SOCK_H
 #define SOCK_H
 
+/**
+ * Gather buffer structure, matching the POSIX layout.
+ *   @iov_base: The buffer.
+ *   @iov_len: The length.
+ */
+struct iovec {
+	void *iov_base;
+	size_t iov_len;
+};
+
+
 /*
  * socket declarations
  */
@@ -11,6 +22,8 @@ void sys_closesocket(sys_sock_t sock);
 
 size_t sys_recv(sys_sock_t sock, void *buf, size_t nbytes, int flags);
 size_t sys_send(sys_sock_t sock, const void *buf, size_t nbytes, int flags);
+size_t sys_sendv(sys_sock_t sock, const struct iovec *iov, unsigned int cnt, int flags);
+size_t sys_sendfile(sys_sock_t sock, int fd, int64_t *off, size_t nbytes);
 
 char *sys_bind(sys_sock_t sock, const struct sockaddr *addr, int len);
 char *sys_listen(sys_sock_t sock, int backlog);
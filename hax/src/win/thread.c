@@ -1,6 +1,29 @@
 #include "../common.h"
 
 
+/*
+ * local definitions
+ */
+#define SPIN	64
+
+
+/**
+ * Wait for a counter of short critical sections, such as readers pinning a
+ * published pointer, to drain to zero. The caller spins briefly and then
+ * yields, so that a reader preempted inside its section can run.
+ *   @cnt: The counter.
+ */
+void sys_thread_drain(unsigned int *cnt)
+{
+	unsigned int spin;
+
+	for(spin = 0; __atomic_load_n(cnt, __ATOMIC_SEQ_CST) != 0; spin++) {
+		if(spin >= SPIN)
+			SwitchToThread();
+	}
+}
+
+
 /**
  * Initialize a mutex.
  *   @flags: The flags.
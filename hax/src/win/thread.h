@@ -9,6 +9,11 @@ struct sys_mutex_t {
 	CRITICAL_SECTION lock;
 };
 
+/*
+ * thread declarations
+ */
+void sys_thread_drain(unsigned int *cnt);
+
 /*
  * mutex declarations
  */
@@ -0,0 +1,4 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+#define SHAREDIR "/usr/local/share"
+#endif
@@ -0,0 +1,464 @@
+#define _GNU_SOURCE
+#include "common.h"
+#include <sys/socket.h>
+
+
+/**
+ * Exchange case structure.
+ *   @req: The raw request.
+ *   @status: The expected status line.
+ *   @has: Text the response must contain, or null.
+ *   @lacks: Text the response must not contain, or null.
+ */
+struct case_t {
+	const char *req, *status, *has, *lacks;
+};
+
+/**
+ * WebSocket frame structure.
+ *   @head: The first header byte, holding the flags and opcode.
+ *   @len: The payload length.
+ *   @mask: The masked flag.
+ */
+struct frame_t {
+	uint8_t head;
+	uint64_t len;
+	bool mask;
+};
+
+/**
+ * WebSocket case structure.
+ *   @n: The number of frames.
+ *   @frame: The frames sent after the handshake.
+ *   @expect: The expected frame in the response.
+ *   @len: The length of the expected frame.
+ */
+struct sock_t {
+	unsigned int n;
+	struct frame_t frame[2];
+	const char *expect;
+	size_t len;
+};
+
+/*
+ * local definitions
+ */
+#define WSREQ "GET / HTTP/1.1\r\nHost: a\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n"
+#define WSRESP(str) str, sizeof(str) - 1
+
+
+/*
+ * local declarations
+ */
+static bool test_parse(void);
+static bool test_head(void);
+static bool test_range(void);
+static bool test_websock(void);
+
+static bool check(const char *name, const struct case_t *list, unsigned int n, http_handler_f func, void *arg);
+static void exchange(struct strbuf_t *out, const char *req, size_t len, http_handler_f func, void *arg);
+static bool echo_handler(const char *path, struct http_args_t *args, void *arg);
+static bool head_handler(const char *path, struct http_args_t *args, void *arg);
+static bool file_handler(const char *path, struct http_args_t *args, void *arg);
+static bool sock_handler(const char *path, struct http_args_t *args, void *arg);
+static bool sock_msg(struct io_file_t file, const char *data, size_t len, void *arg);
+
+
+/**
+ * Perform tests on the HTTP client implementation.
+ *   &returns: Success flag.
+ */
+bool test_http(void)
+{
+	bool suc = true;
+
+	suc &= test_parse();
+	suc &= test_head();
+	suc &= test_range();
+	suc &= test_websock();
+
+	return suc;
+}
+
+
+/**
+ * Test parsing of malformed requests and chunked bodies.
+ *   &returns: Success flag.
+ */
+static bool test_parse(void)
+{
+	static const struct case_t list[] = {
+		{ "GET / HTTP/1.1\r\n\r\n", "HTTP/1.1 200 ", "[/:]", NULL },
+		{ "GET / HTTP/1.1\n\n", "HTTP/1.1 200 ", "[/:]", NULL },
+		{ "\r\nGET / HTTP/1.1\r\n\r\n", "HTTP/1.1 200 ", NULL, NULL },
+		{ "GET\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "GET /\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "GET / HTTP/1.1 x\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "GET / HTTP/1.1\r\nHost\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "GET / HTTP/1.1\r\n: x\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "GET / HTTP/1.1\r\nHost : x\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "GET / HTTP/1.1\r\nHost: x\r\n y\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "GET / HTTP/1.1\r\nHost: x", "", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello", "HTTP/1.1 200 ", "[/:hello]", NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 0\r\n\r\n", "HTTP/1.1 200 ", "[/:]", NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: +5\r\n\r\nhello", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 5x\r\n\r\nhello", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 18446744073709551616\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 2000000\r\n\r\n", "HTTP/1.1 413 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", "HTTP/1.1 501 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n", "HTTP/1.1 200 ", "[/:hello]", NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nhe\r\n3\r\nllo\r\n0\r\n\r\n", "HTTP/1.1 200 ", "[/:hello]", NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nA;ext=1\r\n0123456789\r\n0\r\n\r\n", "HTTP/1.1 200 ", "[/:0123456789]", NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\nhello\n0\n\n", "HTTP/1.1 200 ", "[/:hello]", NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\nX-Trailer: 1\r\n\r\n", "HTTP/1.1 200 ", "[/:]", NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhelloX\r\n0\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nz\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n-5\r\nhello\r\n0\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n 5\r\nhello\r\n0\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0x5\r\nhello\r\n0\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5 x\r\nhello\r\n0\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n10000000000000000\r\n\r\n", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nFFFFFFFFFFFFFFFF\r\n\r\n", "HTTP/1.1 413 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n100000\r\n", "HTTP/1.1 413 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel", "", NULL, NULL },
+	};
+
+	return check("parse", list, sizeof(list) / sizeof(list[0]), echo_handler, NULL);
+}
+
+/**
+ * Test lookup of known headers and handling of duplicate or conflicting
+ * framing headers.
+ *   &returns: Success flag.
+ */
+static bool test_head(void)
+{
+	static const struct case_t list[] = {
+		{ "GET / HTTP/1.1\r\nHost: a\r\nX-Test: b\r\n\r\n", "HTTP/1.1 200 ", "[a:b]", NULL },
+		{ "GET / HTTP/1.1\r\nHOST: a\r\nx-test: b\r\n\r\n", "HTTP/1.1 200 ", "[a:b]", NULL },
+		{ "GET / HTTP/1.1\r\nhost:a\r\nX-TEST:\t b \t\r\n\r\n", "HTTP/1.1 200 ", "[a:b]", NULL },
+		{ "GET / HTTP/1.1\r\nHost-Name: a\r\nX-Tes: b\r\n\r\n", "HTTP/1.1 200 ", "[(null):(null)]", NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 5\r\ncontent-length: 5\r\n\r\nhello", "HTTP/1.1 200 ", "[(null):(null)]", "close" },
+		{ "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\nhello!", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 6\r\nCONTENT-LENGTH: 5\r\n\r\nhello!", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nContent-Length: 5, 5\r\n\r\nhello", "HTTP/1.1 400 ", NULL, NULL },
+		{ "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n0\r\n\r\nGET /x HTTP/1.1\r\nX-Test: x\r\n\r\n", "HTTP/1.1 200 ", "Connection: close", ":x]" },
+		{ "POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\nGET /x HTTP/1.1\r\nX-Test: x\r\n\r\n", "HTTP/1.1 200 ", "Connection: close", ":x]" },
+		{ "GET / HTTP/1.1\r\nConnection: Keep-Alive, Close\r\n\r\nGET /x HTTP/1.1\r\nX-Test: x\r\n\r\n", "HTTP/1.1 200 ", "Connection: close", ":x]" },
+		{ "GET / HTTP/1.0\r\n\r\nGET /x HTTP/1.0\r\nX-Test: x\r\n\r\n", "HTTP/1.1 200 ", "Connection: close", ":x]" },
+		{ "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\nGET /x HTTP/1.0\r\nX-Test: b\r\n\r\n", "HTTP/1.1 200 ", ":b]", NULL },
+	};
+
+	return check("head", list, sizeof(list) / sizeof(list[0]), head_handler, NULL);
+}
+
+/**
+ * Test byte ranges of a file response.
+ *   &returns: Success flag.
+ */
+static bool test_range(void)
+{
+	static const struct case_t list[] = {
+		{ "GET / HTTP/1.1\r\n\r\n", "HTTP/1.1 200 ", "Accept-Ranges: bytes", NULL },
+		{ "GET / HTTP/1.1\r\n\r\n", "HTTP/1.1 200 ", "\r\n\r\n0123456789", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=0-4\r\n\r\n", "HTTP/1.1 206 ", "Content-Range: bytes 0-4/10", "56789" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=0-4\r\n\r\n", "HTTP/1.1 206 ", "\r\n\r\n01234", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=5-\r\n\r\n", "HTTP/1.1 206 ", "Content-Range: bytes 5-9/10", "01234" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=9-9\r\n\r\n", "HTTP/1.1 206 ", "Content-Range: bytes 9-9/10", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=5-100\r\n\r\n", "HTTP/1.1 206 ", "Content-Range: bytes 5-9/10", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=-3\r\n\r\n", "HTTP/1.1 206 ", "Content-Range: bytes 7-9/10", "0123456" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=-3\r\n\r\n", "HTTP/1.1 206 ", "\r\n\r\n789", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=-20\r\n\r\n", "HTTP/1.1 206 ", "Content-Range: bytes 0-9/10", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=-0\r\n\r\n", "HTTP/1.1 416 ", "Content-Range: bytes */10", "0123" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=10-\r\n\r\n", "HTTP/1.1 416 ", "Content-Range: bytes */10", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=10-20\r\n\r\n", "HTTP/1.1 416 ", "Content-Range: bytes */10", NULL },
+		{ "GET / HTTP/1.1\r\nRange: bytes=5-3\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=0-1,3-4\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=0-5,2-8\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=-\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=x-1\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=1-2x\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=1--2\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: items=0-1\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=18446744073709551616-\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=0-18446744073709551616\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=-18446744073709551616\r\n\r\n", "HTTP/1.1 200 ", "0123456789", "Content-Range" },
+		{ "GET / HTTP/1.1\r\nRange: bytes=0-0\r\n\r\nGET / HTTP/1.1\r\nRange: bytes=-1\r\n\r\n", "HTTP/1.1 206 ", "\r\n\r\n0HTTP/1.1 206 ", NULL },
+	};
+
+	int fd;
+	bool suc;
+	char path[] = "/tmp/hax-test.XXXXXX";
+
+	fd = mkstemp(path);
+	if(fd < 0)
+		fatal("Failed to create file. %s.", strerror(errno));
+
+	unlink(path);
+	if(write(fd, "0123456789", 10) != 10)
+		fatal("Failed to write file. %s.", strerror(errno));
+
+	suc = check("range", list, sizeof(list) / sizeof(list[0]), file_handler, &fd);
+	close(fd);
+
+	return suc;
+}
+
+/**
+ * Test WebSocket frame lengths, masking and protocol errors. Payloads are
+ * filled with 'a', so that a wrongly unmasked message is detected.
+ *   &returns: Success flag.
+ */
+static bool test_websock(void)
+{
+	static const struct sock_t list[] = {
+		{ 1, { { 0x81, 5, true } }, WSRESP("\x81\x01" "5") },
+		{ 1, { { 0x81, 0, true } }, WSRESP("\x81\x01" "0") },
+		{ 1, { { 0x81, 125, true } }, WSRESP("\x81\x03" "125") },
+		{ 1, { { 0x81, 126, true } }, WSRESP("\x81\x03" "126") },
+		{ 1, { { 0x82, 65535, true } }, WSRESP("\x81\x05" "65535") },
+		{ 1, { { 0x82, 65536, true } }, WSRESP("\x81\x05" "65536") },
+		{ 2, { { 0x01, 3, true }, { 0x80, 2, true } }, WSRESP("\x81\x01" "5") },
+		{ 1, { { 0x89, 2, true } }, WSRESP("\x8a\x02" "aa") },
+		{ 1, { { 0x88, 2, true } }, WSRESP("\x88\x02" "aa") },
+		{ 1, { { 0x81, 5, false } }, WSRESP("\x88\x02\x03\xea") },
+		{ 1, { { 0xc1, 5, true } }, WSRESP("\x88\x02\x03\xea") },
+		{ 1, { { 0x83, 5, true } }, WSRESP("\x88\x02\x03\xea") },
+		{ 1, { { 0x80, 5, true } }, WSRESP("\x88\x02\x03\xea") },
+		{ 1, { { 0x09, 2, true } }, WSRESP("\x88\x02\x03\xea") },
+		{ 1, { { 0x89, 126, true } }, WSRESP("\x88\x02\x03\xea") },
+		{ 2, { { 0x01, 3, true }, { 0x81, 2, true } }, WSRESP("\x88\x02\x03\xea") },
+		{ 1, { { 0x81, 1024 * 1024 + 1, true } }, WSRESP("\x88\x02\x03\xf1") },
+		{ 1, { { 0x81, UINT64_MAX, true } }, WSRESP("\x88\x02\x03\xf1") },
+		{ 2, { { 0x01, 65536, true }, { 0x80, 1024 * 1024 - 65535, true } }, WSRESP("\x88\x02\x03\xf1") },
+	};
+
+	size_t len;
+	const char *resp;
+	unsigned int i, j, k;
+	bool suc = true;
+	struct strbuf_t req, out;
+	static const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+
+	for(i = 0; i < sizeof(list) / sizeof(list[0]); i++) {
+		req = strbuf_init(256);
+		strbuf_addstr(&req, WSREQ);
+
+		for(j = 0; j < list[i].n; j++) {
+			const struct frame_t *frame = &list[i].frame[j];
+
+			strbuf_addch(&req, frame->head);
+			if(frame->len < 126)
+				strbuf_addch(&req, (frame->mask ? 0x80 : 0x00) | frame->len);
+			else if(frame->len < 0x10000) {
+				strbuf_addch(&req, (frame->mask ? 0x80 : 0x00) | 126);
+				for(k = 0; k < 2; k++)
+					strbuf_addch(&req, frame->len >> (8 * (1 - k)));
+			}
+			else {
+				strbuf_addch(&req, (frame->mask ? 0x80 : 0x00) | 127);
+				for(k = 0; k < 8; k++)
+					strbuf_addch(&req, frame->len >> (8 * (7 - k)));
+			}
+
+			if(frame->mask)
+				strbuf_addmem(&req, (const char *)mask, 4);
+
+			if(frame->len <= 0x10000) {
+				for(k = 0; k < frame->len; k++)
+					strbuf_addch(&req, frame->mask ? ('a' ^ mask[k % 4]) : 'a');
+			}
+		}
+
+		out = strbuf_init(256);
+		exchange(&out, req.arr, req.idx, sock_handler, NULL);
+		len = out.idx;
+		resp = strbuf_finish(&out);
+
+		if(strncmp(resp, "HTTP/1.1 101 ", 13) != 0)
+			suc = false, fprintf(stderr, "Error. WebSocket case %u. Expected 'HTTP/1.1 101 ', got '%.40s'.\n", i, resp);
+		else if(strstr(resp, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") == NULL)
+			suc = false, fprintf(stderr, "Error. WebSocket case %u. Missing accept key.\n", i);
+		else if(memmem(resp, len, list[i].expect, list[i].len) == NULL)
+			suc = false, fprintf(stderr, "Error. WebSocket case %u. Missing expected frame.\n", i);
+
+		strbuf_destroy(&req);
+		strbuf_destroy(&out);
+	}
+
+	return suc;
+}
+
+
+/**
+ * Check a list of exchanges against their expected responses.
+ *   @name: The name of the list.
+ *   @list: The case list.
+ *   @n: The number of cases.
+ *   @func: The handler.
+ *   @arg: The handler argument.
+ *   &returns: Success flag.
+ */
+static bool check(const char *name, const struct case_t *list, unsigned int n, http_handler_f func, void *arg)
+{
+	unsigned int i;
+	const char *resp;
+	bool suc = true;
+	struct strbuf_t out;
+
+	for(i = 0; i < n; i++) {
+		out = strbuf_init(256);
+		exchange(&out, list[i].req, strlen(list[i].req), func, arg);
+		resp = strbuf_finish(&out);
+
+		if((strncmp(resp, list[i].status, strlen(list[i].status)) != 0) || ((list[i].status[0] == '\0') && (resp[0] != '\0')))
+			suc = false, fprintf(stderr, "Error. HTTP %s case %u. Expected '%s', got '%.40s'.\n", name, i, list[i].status, resp);
+		else if((list[i].has != NULL) && (strstr(resp, list[i].has) == NULL))
+			suc = false, fprintf(stderr, "Error. HTTP %s case %u. Missing '%s'.\n", name, i, list[i].has);
+		else if((list[i].lacks != NULL) && (strstr(resp, list[i].lacks) != NULL))
+			suc = false, fprintf(stderr, "Error. HTTP %s case %u. Unexpected '%s'.\n", name, i, list[i].lacks);
+
+		strbuf_destroy(&out);
+	}
+
+	return suc;
+}
+
+/**
+ * Send a request through a client over a socket pair and collect the
+ * response. The request side is shut down after writing, so the client
+ * sees the end of input once it has consumed the request.
+ *   @out: The output buffer.
+ *   @req: The raw request.
+ *   @len: The request length.
+ *   @func: The handler.
+ *   @arg: The handler argument.
+ */
+static void exchange(struct strbuf_t *out, const char *req, size_t len, http_handler_f func, void *arg)
+{
+	int pair[2];
+	ssize_t ret;
+	char buf[4096];
+	unsigned int i;
+	struct http_conf_t conf;
+	struct tcp_client_t *tcp;
+	struct http_client_t *client;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, pair) < 0)
+		fatal("Failed to create socket pair. %s.", strerror(errno));
+
+	if(write(pair[1], req, len) != (ssize_t)len)
+		fatal("Failed to write request. %s.", strerror(errno));
+
+	shutdown(pair[1], SHUT_WR);
+
+	conf = http_conf_init();
+	tcp = tcp_client_new(pair[0]);
+	client = http_client_new(tcp, &conf);
+
+	for(i = 0; i < 1024; i++) {
+		if(!tcp_client_proc(tcp, sys_poll_in_e | sys_poll_out_e))
+			break;
+		else if(!http_client_proc(client, func, arg))
+			break;
+	}
+
+	http_client_delete(client);
+
+	while((ret = read(pair[1], buf, sizeof(buf))) > 0)
+		strbuf_addmem(out, buf, ret);
+
+	close(pair[1]);
+}
+
+/**
+ * Handler that echoes the path and body of a request.
+ *   @path: The path.
+ *   @args: The request arguments.
+ *   @arg: Unused.
+ *   &returns: True if handled.
+ */
+static bool echo_handler(const char *path, struct http_args_t *args, void *arg)
+{
+	if(args->body == NULL)
+		return false;
+
+	hprintf(args->file, "[%s:%s]", path, args->body);
+
+	return true;
+}
+
+/**
+ * Handler that echoes the host and a custom header of a request.
+ *   @path: The path.
+ *   @args: The request arguments.
+ *   @arg: Unused.
+ *   &returns: True if handled.
+ */
+static bool head_handler(const char *path, struct http_args_t *args, void *arg)
+{
+	if(args->body == NULL)
+		return false;
+
+	hprintf(args->file, "[%s:%s]", http_head_known(&args->req, http_host_e), http_head_lookup(&args->req, "x-test"));
+
+	return true;
+}
+
+/**
+ * Handler that responds with the whole of a ten byte file.
+ *   @path: The path.
+ *   @args: The request arguments.
+ *   @arg: The file descriptor.
+ *   &returns: True if handled.
+ */
+static bool file_handler(const char *path, struct http_args_t *args, void *arg)
+{
+	if(args->body == NULL)
+		return false;
+
+	http_args_file(args, *(int *)arg, 10, NULL, NULL);
+
+	return true;
+}
+
+/**
+ * Handler that accepts a WebSocket connection.
+ *   @path: The path.
+ *   @args: The request arguments.
+ *   @arg: Unused.
+ *   &returns: True if handled.
+ */
+static bool sock_handler(const char *path, struct http_args_t *args, void *arg)
+{
+	if(args->body == NULL)
+		return false;
+
+	return http_args_websock(args, sock_msg, NULL, NULL);
+}
+
+/**
+ * WebSocket message handler that replies with the message length, or with
+ * 'bad' if the message was not unmasked back to its original content.
+ *   @file: The output file.
+ *   @data: The message data.
+ *   @len: The message length.
+ *   @arg: Unused.
+ *   &returns: Always true.
+ */
+static bool sock_msg(struct io_file_t file, const char *data, size_t len, void *arg)
+{
+	size_t i;
+
+	for(i = 0; i < len; i++) {
+		if(data[i] != 'a')
+			break;
+	}
+
+	if(i < len)
+		hprintf(file, "bad");
+	else
+		hprintf(file, "%zu", len);
+
+	return true;
+}
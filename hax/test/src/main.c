@@ -4,6 +4,8 @@
  * test declarations
  */
 bool test_avltree(void);
+bool test_http(void);
+bool test_router(void);
 
 
 /**
@@ -17,6 +19,8 @@ int main(int argc, char **argv)
 	bool suc = true;
 
 	suc &= test_avltree();
+	suc &= test_http();
+	suc &= test_router();
 
 	if(hax_memcnt != 0)
 		suc &= false, fprintf(stderr, "Error. Missed %d allocations.\n", hax_memcnt);
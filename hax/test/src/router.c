@@ -0,0 +1,143 @@
+#include "common.h"
+
+
+/**
+ * Route case structure.
+ *   @path: The request path.
+ *   @match: The expected match and parameters, or null if none.
+ */
+struct route_t {
+	const char *path, *match;
+};
+
+
+/*
+ * local declarations
+ */
+static bool route_handler(struct http_args_t *args, const struct http_param_t *param, void *arg);
+
+static char route_match[256];
+
+
+/**
+ * Perform tests on the router implementation.
+ *   &returns: Success flag.
+ */
+bool test_router(void)
+{
+	static const char *pattern[] = {
+		"/", "/a/b", "/a/#n", "/a/:s", "/u/#n", "/f/:name.mp3", "/f/static.mp3",
+		"/d/c/:y", "/d/:x/b", "/g/s/x", "/g/:p/e", "/h/#n/:s/#m"
+	};
+	static const struct route_t list[] = {
+		{ "/", "/" },
+		{ "/a/b", "/a/b" },
+		{ "/a/b?x=1", "/a/b" },
+		{ "/a/c", "/a/:s c" },
+		{ "/a/12", "/a/#n 12=12" },
+		{ "/a/007", "/a/#n 007=7" },
+		{ "/a/+5", "/a/:s +5" },
+		{ "/a/5a", "/a/:s 5a" },
+		{ "/a/18446744073709551615", "/a/#n 18446744073709551615=18446744073709551615" },
+		{ "/a/18446744073709551616", "/a/:s 18446744073709551616" },
+		{ "/a/99999999999999999999", "/a/:s 99999999999999999999" },
+		{ "/a/", NULL },
+		{ "/a/b/", NULL },
+		{ "/a", NULL },
+		{ "a/b", NULL },
+		{ "/u/1", "/u/#n 1=1" },
+		{ "/u/x", NULL },
+		{ "/u/\xb9", NULL },
+		{ "/u/18446744073709551616", NULL },
+		{ "/f/a.mp3", "/f/:name.mp3 a" },
+		{ "/f/static.mp3", "/f/static.mp3" },
+		{ "/f/.mp3", NULL },
+		{ "/f/a.mp4", NULL },
+		{ "/d/c/b", "/d/c/:y b" },
+		{ "/d/z/b", "/d/:x/b z" },
+		{ "/d/c", NULL },
+		{ "/g/s/x", "/g/s/x" },
+		{ "/g/s/e", "/g/:p/e s" },
+		{ "/h/1/x/2", "/h/#n/:s/#m 1=1 x 2=2" },
+		{ "/h/1/x/y", NULL },
+	};
+
+	char *err;
+	unsigned int i;
+	bool suc = true;
+	struct http_args_t args;
+	struct http_router_t *router;
+
+	router = http_router_new();
+
+	for(i = 0; i < sizeof(pattern) / sizeof(pattern[0]); i++) {
+		err = http_router_add(router, pattern[i], route_handler, (void *)pattern[i], 0);
+		if(err != NULL)
+			suc = false, fprintf(stderr, "Error. Route '%s'. %s\n", pattern[i], err), free(err);
+	}
+
+	err = http_router_add(router, "/a/b", route_handler, NULL, 0);
+	if(err == NULL)
+		suc = false, fprintf(stderr, "Error. Duplicate route accepted.\n");
+
+	erase(err);
+
+	err = http_router_add(router, "/:a/:b/:c/:d/:e/:f/:g/:h/:i", route_handler, NULL, 0);
+	if(err == NULL)
+		suc = false, fprintf(stderr, "Error. Route with too many parameters accepted.\n");
+
+	erase(err);
+
+	err = http_router_add(router, "a", route_handler, NULL, 0);
+	if(err == NULL)
+		suc = false, fprintf(stderr, "Error. Relative route accepted.\n");
+
+	erase(err);
+
+	memset(&args, 0x00, sizeof(args));
+	args.body = "";
+
+	for(i = 0; i < sizeof(list) / sizeof(list[0]); i++) {
+		route_match[0] = '\0';
+
+		if(!http_router_proc(list[i].path, &args, router)) {
+			if(list[i].match != NULL)
+				suc = false, fprintf(stderr, "Error. Route '%s'. Expected '%s', got no match.\n", list[i].path, list[i].match);
+		}
+		else if((list[i].match == NULL) || (strcmp(route_match, list[i].match) != 0))
+			suc = false, fprintf(stderr, "Error. Route '%s'. Expected '%s', got '%s'.\n", list[i].path, list[i].match ?: "no match", route_match);
+	}
+
+	args.body = NULL;
+	if(http_router_proc("/a/b", &args, router))
+		suc = false, fprintf(stderr, "Error. Route offered a request without its body.\n");
+
+	http_router_delete(router);
+
+	return suc;
+}
+
+
+/**
+ * Handler that records the matched pattern and its parameters.
+ *   @args: The request arguments.
+ *   @param: The parameters.
+ *   @arg: The pattern.
+ *   &returns: Always true.
+ */
+static bool route_handler(struct http_args_t *args, const struct http_param_t *param, void *arg)
+{
+	size_t len;
+	const char *pattern = arg, *ptr;
+
+	len = snprintf(route_match, sizeof(route_match), "%s", pattern);
+
+	for(ptr = pattern; (ptr = strpbrk(ptr, ":#")) != NULL; ptr++, param++) {
+		if(*ptr == ':')
+			len += snprintf(route_match + len, sizeof(route_match) - len, " %.*s", (int)param->len, param->str);
+		else
+			len += snprintf(route_match + len, sizeof(route_match) - len, " %.*s=%llu", (int)param->len, param->str, (unsigned long long)param->num);
+	}
+
+	return true;
+}